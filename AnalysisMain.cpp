@@ -0,0 +1,49 @@
+#include "AnalysisServer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+/* runs the analysis server until it is killed.
+
+   usage: analysisd [--socket PATH] [--threads N] [--hash MB] [--numa] */
+
+int main(int argc, char* argv[]) {
+
+  string path = "/tmp/chess-analysis.sock";
+  int threads = max(1u, thread::hardware_concurrency());
+  int hashMegabytes = 256;
+  bool numa = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--socket") && i + 1 < argc)
+      path = argv[++i];
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      hashMegabytes = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--numa"))
+      numa = true;
+    else {
+      cerr << "usage: analysisd [--socket PATH] [--threads N] [--hash MB]"
+	   << " [--numa]" << endl;
+      return 1;
+    }
+  }
+
+  AnalysisServer server(threads, hashMegabytes, numa);
+  if (!server.listen(path)) {
+    cerr << "analysisd: cannot listen on " << path << endl;
+    return 1;
+  }
+  cerr << "analysisd: listening on " << path << " with " << threads
+       << " threads and " << hashMegabytes << " MB hash"
+       << (numa ? ", pinned to cores" : "") << endl;
+  server.run();
+  return 0;
+}
@@ -0,0 +1,268 @@
+#include "AnalysisServer.h"
+#include "Numa.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// limit given to requests that set none.
+const int DEFAULT_MOVE_TIME = 1000;
+
+}
+
+
+AnalysisServer::Connection::~Connection() {
+  close(socket);
+}
+
+
+void AnalysisServer::Connection::send(const string& line) {
+
+  lock_guard<mutex> lock(writeLock);
+  string text = line + "\n";
+  size_t written = 0;
+  while (written < text.size() && !closed) {
+    // a client that went away must not kill the server with SIGPIPE.
+    ssize_t count = ::send(socket, text.data() + written,
+			   text.size() - written, MSG_NOSIGNAL);
+    if (count <= 0) {
+      closed = true;
+      return;
+    }
+    written += count;
+  }
+}
+
+
+AnalysisServer::AnalysisServer(int threads, int hashMegabytes, bool numa)
+  : table(numa ? 1 : hashMegabytes), numa(numa) {
+
+  // the table is built again with its pages spread over the nodes, as
+  // they are first touched when it is cleared.
+  if (numa) {
+    InterleavedMemory interleaved;
+    table.resize(hashMegabytes);
+  }
+  for (int i = 0; i < threads; i++)
+    workers.emplace_back(&AnalysisServer::work, this, i);
+}
+
+
+AnalysisServer::~AnalysisServer() {
+  {
+    lock_guard<mutex> lock(jobsLock);
+    stopping = true;
+  }
+  jobsReady.notify_all();
+  for (thread& worker : workers)
+    worker.join();
+  if (listener >= 0)
+    close(listener);
+}
+
+
+bool AnalysisServer::listen(const string& path) {
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path))
+    return false;
+  strcpy(address.sun_path, path.c_str());
+
+  listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+    return false;
+
+  // a socket file left by a previous run would make bind fail.
+  unlink(path.c_str());
+  if (bind(listener, (sockaddr*)&address, sizeof(address)) < 0
+      || ::listen(listener, 64) < 0) {
+    close(listener);
+    listener = -1;
+    return false;
+  }
+  return true;
+}
+
+
+void AnalysisServer::run() {
+
+  while (true) {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR)
+	continue;
+      return;
+    }
+    thread(&AnalysisServer::serve, this,
+	   make_shared<Connection>(client)).detach();
+  }
+}
+
+
+void AnalysisServer::serve(shared_ptr<Connection> client) {
+
+  string pending;
+  char buffer[4096];
+  while (true) {
+    ssize_t count = recv(client->socket, buffer, sizeof(buffer), 0);
+    if (count <= 0)
+      break;
+    pending.append(buffer, count);
+
+    size_t end;
+    while ((end = pending.find('\n')) != string::npos) {
+      string line = pending.substr(0, end);
+      pending.erase(0, end + 1);
+      if (!line.empty() && line.back() == '\r')
+	line.pop_back();
+      if (line == "quit") {
+	client->closed = true;
+	return;
+      }
+      handle(client, line);
+    }
+  }
+
+  // jobs still queued for a client that has gone are skipped.
+  client->closed = true;
+}
+
+
+void AnalysisServer::handle(const shared_ptr<Connection>& client,
+			    const string& line) {
+
+  istringstream words(line);
+  string command;
+  if (!(words >> command))
+    return;
+
+  if (command == "clearhash") {
+    table.clear();
+    client->send("ok");
+    return;
+  }
+
+  Job job;
+  if (command != "analyse" || !(words >> job.id)) {
+    client->send("error - unknown request " + line);
+    return;
+  }
+
+  string word;
+  bool limited = false;
+  while (words >> word) {
+    if (word == "fen") {
+      getline(words, job.fen);
+      break;
+    }
+    uint64_t value;
+    if (!(words >> value)) {
+      client->send("error " + job.id + " missing value for " + word);
+      return;
+    }
+    if (word == "depth")
+      job.limits.depth = (int)value;
+    else if (word == "nodes")
+      job.limits.nodes = value;
+    else if (word == "movetime")
+      job.limits.moveTime = (int)value;
+    else if (word == "multipv") {
+      job.limits.multiPv = (int)max<uint64_t>(value, 1);
+      continue;
+    }
+    else {
+      client->send("error " + job.id + " unknown limit " + word);
+      return;
+    }
+    limited = true;
+  }
+
+  if (job.fen.empty()) {
+    client->send("error " + job.id + " missing position");
+    return;
+  }
+  if (!limited)
+    job.limits.moveTime = DEFAULT_MOVE_TIME;
+
+  job.client = client;
+  {
+    lock_guard<mutex> lock(jobsLock);
+    jobs.push_back(move(job));
+  }
+  jobsReady.notify_one();
+}
+
+
+void AnalysisServer::work(int index) {
+
+  // a pinned worker builds its search, and each search thread started by
+  // it its own tables, on the node of its core.
+  if (numa)
+    pinThread(index);
+
+  // every worker searches with the shared table.
+  Search search(table);
+
+  while (true) {
+    Job job;
+    {
+      unique_lock<mutex> lock(jobsLock);
+      jobsReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (stopping)
+	return;
+      job = move(jobs.front());
+      jobs.pop_front();
+    }
+    if (!job.client->closed)
+      analyse(search, job);
+  }
+}
+
+
+void AnalysisServer::analyse(Search& search, const Job& job) {
+
+  ChessBoard board(false);
+  if (!board.setPosition(job.fen)) {
+    job.client->send("error " + job.id + " bad position");
+    return;
+  }
+
+  SearchResult result = search.think(board, job.limits);
+  SearchStatistics statistics = search.statistics();
+
+  // with several lines asked for, each is sent before the result.
+  if (job.limits.multiPv > 1)
+    for (size_t i = 0; i < result.lines.size(); i++) {
+      ostringstream line;
+      line << "line " << job.id << " " << i + 1 << " score "
+	   << scoreText(result.lines[i].score) << " depth "
+	   << result.lines[i].depth << " pv";
+      for (Move move : result.lines[i].pv)
+	line << " " << move;
+      job.client->send(line.str());
+    }
+
+  ostringstream line;
+  line << "result " << job.id << " bestmove ";
+  if (result.bestMove == NO_MOVE)
+    line << "none";
+  else
+    line << result.bestMove;
+  line << " score " << scoreText(result.score) << " depth " << result.depth
+       << " nodes " << statistics.nodes << " time " << statistics.elapsed
+       << " pv";
+  for (Move move : result.pv)
+    line << " " << move;
+  job.client->send(line.str());
+}
@@ -0,0 +1,108 @@
+#ifndef ANALYSISSERVER_H
+#define ANALYSISSERVER_H
+#include "Search.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* long running server that analyses positions sent over a unix domain
+   socket. requests are queued for a pool of workers sharing one
+   transposition table, so positions seen before are answered from a warm
+   table. a client may send many requests without waiting; each result is
+   written back, tagged with its request id, as soon as it is ready.
+
+   requests and results are lines of text:
+     analyse <id> [depth N] [nodes N] [movetime MS] [multipv N]
+       fen <position>
+     clearhash
+     quit
+   answered by
+     line <id> <rank> score cp|mate <N> depth <N> pv <moves>
+       (once per line when multipv is above one, best first)
+     result <id> bestmove <move> score cp|mate <N> depth <N> nodes <N>
+       time <MS> pv <moves>
+     error <id> <reason>
+     ok */
+class AnalysisServer {
+
+public:
+
+  /* constructor for the server, starting its workers.
+     @param threads is the number of positions analysed at once.
+     @param hashMegabytes is the size of the shared transposition table.
+     @param numa pins each worker to a core, the cores of one node taken
+     before the next, so the tables of its searches are allocated on its
+     node, and spreads the shared table over every node. */
+  AnalysisServer(int threads, int hashMegabytes, bool numa = false);
+
+  /* destructor for the server, stopping its workers. */
+  ~AnalysisServer();
+
+  /* function that creates the socket, replacing any file left at the path.
+     @param path is the file name of the socket. */
+  bool listen(const std::string& path);
+
+  /* function that accepts clients until the socket is closed. */
+  void run();
+
+private:
+
+  // struct holding a client connected to the server.
+  struct Connection {
+    int socket;
+    std::mutex writeLock;
+    std::atomic<bool> closed{false};
+
+    Connection(int socket) : socket(socket) {}
+    ~Connection();
+
+    /* function that writes a line to the client. */
+    void send(const std::string& line);
+  };
+
+  // struct holding one position waiting to be analysed.
+  struct Job {
+    std::shared_ptr<Connection> client;
+    std::string id;
+    std::string fen;
+    SearchLimits limits;
+  };
+
+  /* function that reads requests from a client until it disconnects.
+     @param client is the connection to read from. */
+  void serve(std::shared_ptr<Connection> client);
+
+  /* function that handles one line sent by a client.
+     @param client is the connection the line came from.
+     @param line is the request. */
+  void handle(const std::shared_ptr<Connection>& client,
+	      const std::string& line);
+
+  /* function run by each worker, analysing queued jobs.
+     @param index is the number of the worker, placing it when pinned. */
+  void work(int index);
+
+  /* function that analyses one job and sends the result.
+     @param search is the search of the worker.
+     @param job is the job to analyse. */
+  void analyse(Search& search, const Job& job);
+
+  TranspositionTable table;
+  bool numa;
+
+  std::vector<std::thread> workers;
+  std::deque<Job> jobs;
+  std::mutex jobsLock;
+  std::condition_variable jobsReady;
+  bool stopping = false;
+
+  int listener = -1;
+};
+
+#endif
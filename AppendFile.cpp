@@ -0,0 +1,30 @@
+#include "AppendFile.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+AppendFile::~AppendFile() {
+  if (descriptor >= 0)
+    close(descriptor);
+}
+
+bool AppendFile::open(const string& file) {
+  descriptor = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  offset = 0;
+  return descriptor >= 0;
+}
+
+bool AppendFile::append(const void* data, size_t bytes) {
+  uint64_t at = offset.fetch_add(bytes);
+  const char* next = (const char*)data;
+  while (bytes > 0) {
+    ssize_t written = pwrite(descriptor, next, bytes, at);
+    if (written <= 0)
+      return false;
+    next += written;
+    at += written;
+    bytes -= written;
+  }
+  return true;
+}
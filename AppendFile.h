@@ -0,0 +1,42 @@
+#ifndef APPENDFILE_H
+#define APPENDFILE_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/* file of fixed-size records written by many threads at once, such as
+   training data or a search trace. each write reserves its place at the
+   end of the file by advancing an atomic offset and is written there
+   with pwrite, so writers never wait for each other. */
+class AppendFile {
+
+public:
+
+  AppendFile() = default;
+  AppendFile(const AppendFile&) = delete;
+  AppendFile& operator=(const AppendFile&) = delete;
+
+  /* destructor for the file, closing it. */
+  ~AppendFile();
+
+  /* function that creates the file, replacing any file of that name.
+     @param file is the name of the file. */
+  bool open(const std::string& file);
+
+  /* function that writes bytes at the end of the file, safe to call from
+     any thread.
+     @param data is the start of the bytes.
+     @param bytes is the number of bytes. */
+  bool append(const void* data, size_t bytes);
+
+  /* getter function for the number of bytes written or being written. */
+  uint64_t size() const { return offset; }
+
+private:
+
+  int descriptor = -1;
+  std::atomic<uint64_t> offset{0};
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "ChessBoard.h"
+#include "GameArchive.h"
+#include "Uci.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* converts games between text and the binary archive format and replays
+   archives to measure how fast they decode.
+
+   usage: archive pack TEXT ARCHIVE [--entropy]
+          archive unpack ARCHIVE [--game N]
+          archive scan ARCHIVE
+
+   a game in text is one line holding the result and the moves in the
+   universal chess interface notation, e.g.
+     1-0 startpos moves e2e4 e7e5 ...
+     1/2-1/2 fen <position> moves g1f3 ... */
+
+namespace {
+
+const char* const RESULTS[3] = {"1-0", "0-1", "1/2-1/2"};
+
+/* function that reads a game written on one line.
+   @param line is the game in text.
+   @param game is filled with the game. */
+bool parseGame(const string& line, ArchivedGame& game) {
+  istringstream in(line);
+  string token;
+  in >> token;
+  int result = 0;
+  while (result < 3 && token != RESULTS[result])
+    result++;
+  if (result == 3)
+    return false;
+  game.result = (GameResult)result;
+
+  in >> token;
+  game.fen.clear();
+  if (token == "fen") {
+    while (in >> token && token != "moves")
+      game.fen += (game.fen.empty() ? "" : " ") + token;
+  }
+  else if (token != "startpos" || (in >> token && token != "moves"))
+    return false;
+
+  ChessBoard board(false);
+  if (!game.fen.empty() && !board.setPosition(game.fen))
+    return false;
+  game.moves.clear();
+  MoveRecord record;
+  while (in >> token) {
+    Move move;
+    if (!parseUciMove(board, token, move))
+      return false;
+    board.doMove(move, record);
+    game.moves.push_back(move);
+  }
+  return true;
+}
+
+/* function that writes a game on one line. */
+void printGame(ostream& out, const ArchivedGame& game) {
+  out << RESULTS[game.result] << " ";
+  if (game.fen.empty())
+    out << "startpos";
+  else
+    out << "fen " << game.fen;
+  out << " moves";
+  for (Move move : game.moves)
+    out << " " << moveUci(move);
+  out << endl;
+}
+
+int pack(const string& textFile, const string& archiveFile, bool entropy) {
+  ifstream in(textFile);
+  GameArchiveWriter writer;
+  if (!in || !writer.open(archiveFile, entropy)) {
+    cerr << "archive: cannot open " << (in ? archiveFile : textFile) << endl;
+    return 1;
+  }
+
+  string line;
+  ArchivedGame game;
+  uint64_t plies = 0;
+  for (int number = 1; getline(in, line); number++) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    if (!parseGame(line, game)
+	|| !writer.addGame(game.fen, game.moves, game.result)) {
+      cerr << "archive: bad game on line " << number << endl;
+      return 1;
+    }
+    plies += game.moves.size();
+  }
+  size_t games = writer.size();
+  if (!writer.close()) {
+    cerr << "archive: cannot write " << archiveFile << endl;
+    return 1;
+  }
+
+  ifstream written(archiveFile, ios::binary | ios::ate);
+  cout << "Packed " << games << " games, " << plies << " plies into "
+       << written.tellg() << " bytes" << endl;
+  return 0;
+}
+
+int unpack(GameArchiveReader& reader, long game) {
+  ArchivedGame record;
+  size_t first = game < 0 ? 0 : game;
+  size_t last = game < 0 ? reader.size() : game + 1;
+  for (size_t index = first; index < last; index++) {
+    if (!reader.read(index, record)) {
+      cerr << "archive: cannot read game " << index << endl;
+      return 1;
+    }
+    printGame(cout, record);
+  }
+  return 0;
+}
+
+int scan(GameArchiveReader& reader) {
+  ChessBoard board(false);
+  uint64_t plies = 0;
+  int results[3] = {0, 0, 0};
+  auto count = [&plies](ChessBoard&, Move move) {
+    plies += !(move == NO_MOVE);
+    return true;
+  };
+
+  auto start = chrono::steady_clock::now();
+  for (size_t index = 0; index < reader.size(); index++) {
+    GameResult result;
+    if (!reader.replay(index, board, count, &result)) {
+      cerr << "archive: cannot read game " << index << endl;
+      return 1;
+    }
+    results[result]++;
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()
+					    - start).count();
+
+  cout << "Games: " << reader.size() << " (+" << results[WHITE_WINS]
+       << " -" << results[BLACK_WINS] << " =" << results[DRAWN] << ")"
+       << endl;
+  cout << "Plies: " << plies << endl;
+  cout << "Moves: " << (reader.entropyCoded() ? "range coded" : "one byte")
+       << ", " << fixed << setprecision(3)
+       << (plies ? 8.0 * reader.gameBytes() / plies : 0)
+       << " bits per ply with game headers" << endl;
+  cout << "Replayed in " << setprecision(3) << seconds << " s, "
+       << setprecision(0) << plies / max(seconds, 1e-9) << " plies/s"
+       << endl;
+  return 0;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  string command = argc > 1 ? argv[1] : "";
+  if (command == "pack" && (argc == 4 || (argc == 5
+					  && string(argv[4]) == "--entropy")))
+    return pack(argv[2], argv[3], argc == 5);
+
+  bool unpackGame = argc == 5 && string(argv[3]) == "--game";
+  if ((command == "unpack" && (argc == 3 || unpackGame))
+      || (command == "scan" && argc == 3)) {
+    GameArchiveReader reader;
+    if (!reader.open(argv[2])) {
+      cerr << "archive: cannot read " << argv[2] << endl;
+      return 1;
+    }
+    if (command == "scan")
+      return scan(reader);
+    return unpack(reader, unpackGame ? atol(argv[4]) : -1);
+  }
+
+  cerr << "usage: archive pack TEXT ARCHIVE [--entropy]" << endl
+       << "       archive unpack ARCHIVE [--game N]" << endl
+       << "       archive scan ARCHIVE" << endl;
+  return 1;
+}
@@ -0,0 +1,217 @@
+#include "AttackMap.h"
+#include "LineTables.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+// steps of the eight lines out of a square, orthogonal ones first.
+const int LINE_COLUMNS[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+const int LINE_ROWS[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+/* squares attacked from each square by the pieces that do not slide,
+   worked out once. */
+struct StepAttacks {
+  uint64_t knight[64];
+  uint64_t king[64];
+  uint64_t pawn[2][64];
+
+  StepAttacks() {
+    const int knightColumns[8] = {1, 2, 2, 1, -1, -2, -2, -1};
+    const int knightRows[8] = {2, 1, -1, -2, -2, -1, 1, 2};
+    for (int square = 0; square < 64; square++) {
+      knight[square] = king[square] = 0;
+      pawn[WHITE][square] = pawn[BLACK][square] = 0;
+      int column = square % 8;
+      int row = square / 8;
+      for (int i = 0; i < 8; i++) {
+	knight[square] |= bit(column + knightColumns[i], row + knightRows[i]);
+	king[square] |= bit(column + LINE_COLUMNS[i], row + LINE_ROWS[i]);
+      }
+      for (int side = -1; side <= 1; side += 2) {
+	pawn[WHITE][square] |= bit(column + side, row + UP);
+	pawn[BLACK][square] |= bit(column + side, row + DOWN);
+      }
+    }
+  }
+
+  // bit of a square, nothing if it is off the board.
+  static uint64_t bit(int column, int row) {
+    if (column < 0 || column > 7 || row < 0 || row > 7)
+      return 0;
+    return 1ULL << (row*8 + column);
+  }
+};
+
+const StepAttacks steps;
+
+// direction of a step from one coordinate towards another.
+int towards(int from, int to) {
+  return (to > from) - (to < from);
+}
+
+}
+
+
+AttackMap::AttackMap() {
+  clear();
+}
+
+
+void AttackMap::clear() {
+  memset(codes, EMPTY, sizeof(codes));
+  memset(colours, 0, sizeof(colours));
+  memset(attackedFrom, 0, sizeof(attackedFrom));
+}
+
+
+void AttackMap::toggle(int square, int code) {
+
+  uint64_t bit = 1ULL << square;
+  if (codes[square] == EMPTY) {
+    // lines through the square stop on the new piece.
+    updateLines(square, false);
+    codes[square] = code;
+    colours[code / 6] |= bit;
+    updateAttacks(square, true);
+  }
+  else {
+    updateAttacks(square, false);
+    colours[codes[square] / 6] &= ~bit;
+    codes[square] = EMPTY;
+    updateLines(square, true);
+  }
+}
+
+
+bool AttackMap::kingMoveAttacked(int from, int to, Colour attacker) const {
+
+  if (attackedFrom[to] & colours[attacker])
+    return true;
+
+  /* past the king, a check reaches as far as the next piece. positions
+     between the checking piece and the king are attacked anyway. */
+  uint64_t occupied = (colours[WHITE] | colours[BLACK]) & ~(1ULL << from);
+  uint64_t checking = sliders(attackedFrom[from] & colours[attacker]);
+  while (checking) {
+    int checker = __builtin_ctzll(checking);
+    checking &= checking - 1;
+    if (to != checker && (LINES.line[checker][from] >> to & 1)
+	&& (LINES.between[checker][to] & occupied) == 0)
+      return true;
+  }
+  return false;
+}
+
+
+bool AttackMap::exposesKing(int from, int to, int king,
+			    Colour attacker) const {
+
+  // a single check must be taken or, from a sliding piece, blocked.
+  uint64_t checking = attackedFrom[king] & colours[attacker];
+  if (checking & (checking - 1))
+    return true;
+  if (checking) {
+    int checker = __builtin_ctzll(checking);
+    if (to != checker && !(LINES.between[checker][king] >> to & 1))
+      return true;
+  }
+
+  // a piece alone between a sliding piece and its king is pinned.
+  uint64_t occupied = colours[WHITE] | colours[BLACK];
+  uint64_t pinning = sliders(attackedFrom[from] & colours[attacker]);
+  while (pinning) {
+    int pinner = __builtin_ctzll(pinning);
+    pinning &= pinning - 1;
+    uint64_t pin = LINES.between[pinner][king];
+    if ((pin & occupied) == 1ULL << from && to != pinner
+	&& !(pin >> to & 1))
+      return true;
+  }
+  return false;
+}
+
+
+void AttackMap::updateAttacks(int square, bool add) {
+
+  int colour = codes[square] / 6;
+  int type = codes[square] % 6;
+  uint64_t attacked = 0;
+  if (type == PAWN)
+    attacked = steps.pawn[colour][square];
+  else if (type == KNIGHT)
+    attacked = steps.knight[square];
+  else if (type == KING)
+    attacked = steps.king[square];
+  else {
+    // rooks take the orthogonal lines, bishops the diagonal ones.
+    uint64_t occupied = colours[WHITE] | colours[BLACK];
+    int first = type == BISHOP ? 4 : 0;
+    int last = type == ROOK ? 4 : 8;
+    for (int line = first; line < last; line++) {
+      int column = square % 8 + LINE_COLUMNS[line];
+      int row = square / 8 + LINE_ROWS[line];
+      while (column >= 0 && column < 8 && row >= 0 && row < 8) {
+	uint64_t bit = 1ULL << (row*8 + column);
+	attacked |= bit;
+	if (occupied & bit)
+	  break;
+	column += LINE_COLUMNS[line];
+	row += LINE_ROWS[line];
+      }
+    }
+  }
+
+  uint64_t bit = 1ULL << square;
+  while (attacked) {
+    int target = __builtin_ctzll(attacked);
+    attacked &= attacked - 1;
+    if (add)
+      attackedFrom[target] |= bit;
+    else
+      attackedFrom[target] &= ~bit;
+  }
+}
+
+
+void AttackMap::updateLines(int square, bool open) {
+
+  // a slider attacking the square also reaches on past it while it is empty.
+  uint64_t occupied = colours[WHITE] | colours[BLACK];
+  uint64_t through = sliders(attackedFrom[square]);
+  while (through) {
+    int slider = __builtin_ctzll(through);
+    through &= through - 1;
+    uint64_t bit = 1ULL << slider;
+    int stepColumn = towards(slider % 8, square % 8);
+    int stepRow = towards(slider / 8, square / 8);
+    int column = square % 8 + stepColumn;
+    int row = square / 8 + stepRow;
+    while (column >= 0 && column < 8 && row >= 0 && row < 8) {
+      int target = row*8 + column;
+      if (open)
+	attackedFrom[target] |= bit;
+      else
+	attackedFrom[target] &= ~bit;
+      if (occupied >> target & 1)
+	break;
+      column += stepColumn;
+      row += stepRow;
+    }
+  }
+}
+
+
+uint64_t AttackMap::sliders(uint64_t squares) const {
+
+  uint64_t found = 0;
+  while (squares) {
+    int square = __builtin_ctzll(squares);
+    squares &= squares - 1;
+    int type = codes[square] % 6;
+    if (type == ROOK || type == BISHOP || type == QUEEN)
+      found |= 1ULL << square;
+  }
+  return found;
+}
@@ -0,0 +1,78 @@
+#ifndef ATTACKMAP_H
+#define ATTACKMAP_H
+#include "supplementary.h"
+#include <cstdint>
+
+/* for every square, the squares of the pieces of either colour attacking
+   it, kept up to date as pieces are put down and picked up. a piece
+   coming or going changes only its own attacks and the lines of the
+   sliding pieces running through its square, so an update touches those
+   few lines rather than the whole board. squares are numbered
+   row*8 + column and pieces coded colour*6 + type. */
+class AttackMap {
+
+public:
+
+  // code of an empty square.
+  static constexpr uint8_t EMPTY = 12;
+
+  /* constructor for a map of an empty board. */
+  AttackMap();
+
+  /* function that empties the board. */
+  void clear();
+
+  /* function that puts a piece down on an empty square, or picks up the
+     piece standing on a square.
+     @param square is the square of the piece.
+     @param code is the piece put down, colour*6 + type. */
+  void toggle(int square, int code);
+
+  /* getter function for the squares of the pieces of both colours
+     attacking, or defending, a square. */
+  uint64_t attackers(int square) const { return attackedFrom[square]; }
+
+  /* getter function for the squares of the pieces of a colour. */
+  uint64_t pieces(Colour colour) const { return colours[colour]; }
+
+  /* function that determines whether a king moving to another square is
+     attacked there. a sliding piece giving check keeps attacking along
+     its line once the king has left the square that blocked it, so the
+     king cannot retreat along the check.
+     @param from is the square of the king.
+     @param to is the square it moves to.
+     @param attacker is the colour of the attacking pieces. */
+  bool kingMoveAttacked(int from, int to, Colour attacker) const;
+
+  /* function that determines whether moving a piece other than the king
+     leaves its king attacked, because the move neither takes nor blocks
+     a piece giving check or because it leaves a pin.
+     @param from is the square of the piece.
+     @param to is the square it moves to.
+     @param king is the square of the king of the moving piece.
+     @param attacker is the colour of the attacking pieces. */
+  bool exposesKing(int from, int to, int king, Colour attacker) const;
+
+private:
+
+  /* function that marks or unmarks the attacks of the piece on a square.
+     @param square is the square of the piece.
+     @param add is whether to mark the attacks rather than unmark them. */
+  void updateAttacks(int square, bool add);
+
+  /* function that lets the lines of sliding pieces through a square
+     that has been emptied, or stops them at a square that is about to
+     be filled.
+     @param square is the square.
+     @param open is whether the square has been emptied. */
+  void updateLines(int square, bool open);
+
+  /* function that returns the squares of the sliding pieces among some. */
+  uint64_t sliders(uint64_t squares) const;
+
+  uint8_t codes[64];
+  uint64_t colours[2];
+  uint64_t attackedFrom[64];
+};
+
+#endif
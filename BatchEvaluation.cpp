@@ -0,0 +1,392 @@
+#include "BatchEvaluation.h"
+#include "Evaluation.h"
+#include "PawnTable.h"
+#include <cstring>
+
+using namespace std;
+
+// the helpers of the kernels are always inlined into the functions built
+// for each instruction set, so they use its vector registers.
+#define KERNEL_INLINE inline __attribute__((always_inline))
+
+namespace {
+
+const uint64_t FILE_A = 0x0101010101010101ULL;
+const uint64_t FILE_H = FILE_A << 7;
+const uint64_t ROW_1 = 0xffULL;
+
+/* material and piece-square score from white's point of view of each
+   piece code on each square, with zero for EMPTY and the unused codes, so
+   that a square's sixteen entries fill one vector register. */
+struct PieceSquareTable {
+  int32_t values[64][16];
+
+  PieceSquareTable() {
+    memset(values, 0, sizeof(values));
+    for (int square = 0; square < 64; square++)
+      for (int code = 0; code < 12; code++)
+	values[square][code] = pieceSquareScore((Colour)(code / 6),
+						(PieceType)(code % 6),
+						square % 8, square / 8);
+  }
+};
+
+const PieceSquareTable PIECE_SQUARES;
+
+/* types of the lanes a kernel works on. with one lane they are plain
+   integers; with more they are GCC vectors, which the compiler turns into
+   the instructions of the target of the function using them. */
+template <int N> struct Lanes {
+  typedef uint64_t U64 __attribute__((vector_size(8 * N)));
+  typedef int64_t I64 __attribute__((vector_size(8 * N)));
+  typedef int32_t I32 __attribute__((vector_size(4 * N)));
+  typedef uint8_t U8 __attribute__((vector_size(N)));
+};
+
+template <> struct Lanes<1> {
+  typedef uint64_t U64;
+  typedef int64_t I64;
+  typedef int32_t I32;
+  typedef uint8_t U8;
+};
+
+template <class To, class From>
+KERNEL_INLINE To convert(From value) {
+  return __builtin_convertvector(value, To);
+}
+
+template <>
+KERNEL_INLINE uint64_t convert<uint64_t, uint8_t>(uint8_t value) {
+  return value;
+}
+
+template <>
+KERNEL_INLINE int32_t convert<int32_t, uint8_t>(uint8_t value) {
+  return value;
+}
+
+template <>
+KERNEL_INLINE int32_t convert<int32_t, int64_t>(int64_t value) {
+  return value;
+}
+
+template <class T>
+KERNEL_INLINE T load(const void* from) {
+  T value;
+  memcpy(&value, from, sizeof(value));
+  return value;
+}
+
+// all ones in the lanes where a comparison held.
+KERNEL_INLINE uint64_t mask(bool condition) { return condition ? ~0ULL : 0; }
+
+template <class V>
+KERNEL_INLINE V mask(V condition) { return condition; }
+
+KERNEL_INLINE int64_t count(uint64_t bits) {
+  return __builtin_popcountll(bits);
+}
+
+// vectors have no population count in AVX2, so the bits are added up in
+// ever wider fields.
+template <class V>
+KERNEL_INLINE V count(V bits) {
+  bits -= bits >> 1 & 0x5555555555555555ULL;
+  bits = (bits & 0x3333333333333333ULL) + (bits >> 2 & 0x3333333333333333ULL);
+  bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  bits += bits >> 8;
+  bits += bits >> 16;
+  bits += bits >> 32;
+  return bits & 0x7f;
+}
+
+template <class U>
+KERNEL_INLINE U north(U bits) {
+  bits |= bits << 8;
+  bits |= bits << 16;
+  return bits | bits << 32;
+}
+
+template <class U>
+KERNEL_INLINE U south(U bits) {
+  bits |= bits >> 8;
+  bits |= bits >> 16;
+  return bits | bits >> 32;
+}
+
+template <class U>
+KERNEL_INLINE U sideways(U bits) {
+  return (bits << 1 & ~FILE_A) | (bits >> 1 & ~FILE_H);
+}
+
+/* function that sums a weight for every bit set, the weight depending on
+   the row of the bit, by splitting the weights into their binary digits.
+   @param bits are the bits to count.
+   @param weights are the weights of each row, not negative. */
+template <class U, class I>
+KERNEL_INLINE
+I rowWeightedCount(U bits, const int weights[8]) {
+  I sum = I() + 0;
+  for (int digit = 0; digit < 7; digit++) {
+    uint64_t rows = 0;
+    for (int row = 0; row < 8; row++)
+      if (weights[row] >> digit & 1)
+	rows |= ROW_1 << 8 * row;
+    if (rows)
+      sum += (I)count(bits & rows) << digit;
+  }
+  return sum;
+}
+
+/* function that scores the pawn structure of the lanes the way
+   PawnTable::evaluatePawns and evaluate do, with whole bitboards instead
+   of pawn by pawn.
+   @param pawns are the pawns of each colour.
+   @param occupied are the occupied squares.
+   @param kings are the squares of the kings.
+   returns the score from white's point of view. */
+template <int N>
+KERNEL_INLINE typename Lanes<N>::I64
+pawnTerms(const typename Lanes<N>::U64 pawns[2],
+	  typename Lanes<N>::U64 occupied,
+	  const typename Lanes<N>::U64 kings[2]) {
+
+  typedef typename Lanes<N>::U64 U64;
+  typedef typename Lanes<N>::I64 I64;
+
+  static const int ROWS[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  static const int MIRRORED_ROWS[8] = {7, 6, 5, 4, 3, 2, 1, 0};
+  static const int MIRRORED_PASSED_BONUS[8] = {
+    PASSED_BONUS[7], PASSED_BONUS[6], PASSED_BONUS[5], PASSED_BONUS[4],
+    PASSED_BONUS[3], PASSED_BONUS[2], PASSED_BONUS[1], PASSED_BONUS[0]};
+
+  I64 score = I64() + 0;
+  for (int colour = WHITE; colour <= BLACK; colour++) {
+    U64 own = pawns[colour];
+    U64 enemy = pawns[1 - colour];
+    bool white = colour == WHITE;
+
+    // squares strictly ahead of some own pawn, and of some enemy pawn.
+    U64 behindOwn = white ? south(own >> 8) : north(own << 8);
+    U64 enemySpan = white ? south(enemy >> 8) : north(enemy << 8);
+
+    U64 doubled = own & behindOwn;
+    U64 isolated = own & ~sideways(north(south(own)));
+    U64 passed = own & ~(enemySpan | sideways(enemySpan));
+    // no own pawn beside or behind on the next files, and an enemy pawn
+    // attacking the square in front.
+    U64 level = white ? north(own) : south(own);
+    U64 attacked = white ? sideways(enemy) >> 16 : sideways(enemy) << 16;
+    U64 backward = own & ~isolated & ~sideways(level) & attacked;
+
+    I64 terms = I64() + 0;
+    terms -= (I64)count(doubled) * DOUBLED_PENALTY;
+    terms -= (I64)count(isolated) * ISOLATED_PENALTY;
+    terms -= (I64)count(backward) * BACKWARD_PENALTY;
+    terms += rowWeightedCount<U64, I64>(passed, white ? PASSED_BONUS
+					: MIRRORED_PASSED_BONUS);
+
+    // shield of the three files around a king still on its back rows.
+    U64 near = (white ? own >> 8 : own >> 48) & ROW_1;
+    U64 far = (white ? own >> 16 : own >> 40) & ROW_1 & ~near;
+    U64 window = ((U64() + 7) << (kings[colour] & 7)) >> 1 & ROW_1;
+    I64 shelter = (I64)count(near & window) * SHIELD_NEAR
+      + (I64)count(far & window) * SHIELD_FAR
+      + (I64)count(window & ~near & ~far) * SHIELD_MISSING;
+    I64 onBackRows = (I64)(white ? mask(kings[colour] < 16)
+			   : mask(kings[colour] >= 48));
+    terms += shelter & onBackRows;
+
+    // passed pawns with an empty square in front, short of the last row.
+    U64 free = passed & (white ? ~(occupied >> 8) & ~(ROW_1 << 56)
+			 : ~(occupied << 8) & ~ROW_1);
+    terms += rowWeightedCount<U64, I64>(free, white ? ROWS : MIRRORED_ROWS)
+      * FREE_PASSER_BONUS;
+
+    score += white ? terms : -terms;
+  }
+  return score;
+}
+
+/* function that evaluates N positions of a block of a batch.
+   @param batch holds the positions.
+   @param block is the number of the block.
+   @param lane is the first position of the block to evaluate.
+   @param scores is filled with the N scores. */
+template <int N>
+KERNEL_INLINE
+void evaluateLanes(const PositionBatch& batch, size_t block, int lane,
+		   int32_t* scores) {
+
+  typedef typename Lanes<N>::I32 I32;
+  typedef typename Lanes<N>::U8 U8;
+
+  // material and piece-square tables, one square of every lane at a time.
+  I32 material = I32() + 0;
+  const uint8_t* codes = &batch.codes[block * 64 * BATCH_BLOCK + lane];
+  for (int square = 0; square < 64; square++) {
+    I32 code = convert<I32>(load<U8>(codes + square * BATCH_BLOCK));
+    const int32_t* values = PIECE_SQUARES.values[square];
+    if constexpr (N == 1)
+      material += values[code];
+    else if constexpr (N == 16)
+      material += __builtin_shuffle(load<I32>(values), code);
+    else
+      material += __builtin_shuffle(load<I32>(values),
+				    load<I32>(values + N), code);
+  }
+
+  // bitboards are twice as wide as scores, so the pawn terms are worked
+  // out eight lanes at a time, a register's worth with AVX-512.
+  const int P = N < 8 ? N : 8;
+  typedef typename Lanes<P>::U64 U64;
+  int32_t pawnScores[N];
+  for (int part = 0; part < N; part += P) {
+    size_t first = block * BATCH_BLOCK + lane + part;
+    U64 pawns[2] = {load<U64>(&batch.pawns[WHITE][first]),
+		    load<U64>(&batch.pawns[BLACK][first])};
+    U64 kings[2] = {
+      convert<U64>(load<typename Lanes<P>::U8>(&batch.kings[WHITE][first])),
+      convert<U64>(load<typename Lanes<P>::U8>(&batch.kings[BLACK][first]))};
+    U64 occupied = load<U64>(&batch.occupancy[first]);
+    typename Lanes<P>::I32 pawnScore
+      = convert<typename Lanes<P>::I32>(pawnTerms<P>(pawns, occupied, kings));
+    memcpy(pawnScores + part, &pawnScore, sizeof(pawnScore));
+  }
+
+  size_t first = block * BATCH_BLOCK + lane;
+  I32 score = material + load<I32>(pawnScores);
+  I32 black = convert<I32>(load<U8>(&batch.sideToMove[first]));
+  // negating is flipping the bits and adding one, so only for black.
+  score = (score ^ -black) + black;
+  memcpy(scores, &score, sizeof(score));
+}
+
+/* functions that evaluate every block of a batch with the kernel of one
+   instruction set. the lanes of the last block past the end of the batch
+   hold empty boards, so are evaluated and thrown away. */
+template <int N>
+KERNEL_INLINE
+void evaluateBlocks(const PositionBatch& batch, int* scores) {
+  int32_t block[BATCH_BLOCK];
+  for (size_t first = 0; first < batch.size(); first += BATCH_BLOCK) {
+    for (int lane = 0; lane < BATCH_BLOCK; lane += N)
+      evaluateLanes<N>(batch, first / BATCH_BLOCK, lane, block + lane);
+    size_t count = min<size_t>(BATCH_BLOCK, batch.size() - first);
+    memcpy(scores + first, block, count * sizeof(int));
+  }
+}
+
+void evaluateScalar(const PositionBatch& batch, int* scores) {
+  evaluateBlocks<1>(batch, scores);
+}
+
+__attribute__((target("avx2")))
+void evaluateAvx2(const PositionBatch& batch, int* scores) {
+  evaluateBlocks<8>(batch, scores);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void evaluateAvx512(const PositionBatch& batch, int* scores) {
+  evaluateBlocks<16>(batch, scores);
+}
+
+}
+
+
+void PositionBatch::clear() {
+  codes.clear();
+  for (int colour = WHITE; colour <= BLACK; colour++) {
+    pawns[colour].clear();
+    kings[colour].clear();
+  }
+  occupancy.clear();
+  sideToMove.clear();
+  count = 0;
+}
+
+size_t PositionBatch::grow() {
+  // whole blocks are added at once so kernels never read past the end.
+  if (count % BATCH_BLOCK == 0) {
+    size_t size = count + BATCH_BLOCK;
+    codes.resize(size * 64, EMPTY);
+    for (int colour = WHITE; colour <= BLACK; colour++) {
+      pawns[colour].resize(size, 0);
+      kings[colour].resize(size, 0);
+    }
+    occupancy.resize(size, 0);
+    sideToMove.resize(size, 0);
+  }
+  return count++;
+}
+
+void PositionBatch::add(const ChessBoard& board) {
+  size_t index = grow();
+  uint8_t* squares = &codes[index / BATCH_BLOCK * 64 * BATCH_BLOCK
+			    + index % BATCH_BLOCK];
+  for (int square = 0; square < 64; square++) {
+    const Piece* piece = board.pieceAt(square % 8, square / 8);
+    if (piece == nullptr)
+      continue;
+    Colour colour = piece->getPieceColour();
+    PieceType type = piece->getPieceType();
+    squares[square * BATCH_BLOCK] = (uint8_t)(colour * 6 + type);
+    occupancy[index] |= 1ULL << square;
+    if (type == PAWN)
+      pawns[colour][index] |= 1ULL << square;
+    else if (type == KING)
+      kings[colour][index] = (uint8_t)square;
+  }
+  sideToMove[index] = (uint8_t)board.sideToMove();
+}
+
+void PositionBatch::add(const PackedPosition& position) {
+  size_t index = grow();
+  uint8_t* squares = &codes[index / BATCH_BLOCK * 64 * BATCH_BLOCK
+			    + index % BATCH_BLOCK];
+  occupancy[index] = position.occupancy;
+  int piece = 0;
+  for (uint64_t left = position.occupancy; left; left &= left - 1) {
+    int square = __builtin_ctzll(left);
+    int code = position.pieces[piece / 2] >> (piece % 2) * 4 & 15;
+    piece++;
+    if (code >= 12)
+      continue;
+    squares[square * BATCH_BLOCK] = (uint8_t)code;
+    if (code % 6 == PAWN)
+      pawns[code / 6][index] |= 1ULL << square;
+    else if (code % 6 == KING)
+      kings[code / 6][index] = (uint8_t)square;
+  }
+  sideToMove[index] = position.sideAndCastling & 1;
+}
+
+
+BatchKernel bestBatchKernel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    return AVX512_KERNEL;
+  if (__builtin_cpu_supports("avx2"))
+    return AVX2_KERNEL;
+  return SCALAR_KERNEL;
+}
+
+const char* batchKernelName(BatchKernel kernel) {
+  const char* names[3] = {"scalar", "avx2", "avx512"};
+  return names[kernel];
+}
+
+void evaluateBatch(const PositionBatch& batch, int* scores,
+		   BatchKernel kernel) {
+  static const BatchKernel best = bestBatchKernel();
+  switch (kernel < best ? kernel : best) {
+  case AVX512_KERNEL:
+    evaluateAvx512(batch, scores);
+    break;
+  case AVX2_KERNEL:
+    evaluateAvx2(batch, scores);
+    break;
+  default:
+    evaluateScalar(batch, scores);
+  }
+}
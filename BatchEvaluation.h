@@ -0,0 +1,71 @@
+#ifndef BATCHEVALUATION_H
+#define BATCHEVALUATION_H
+#include "ChessBoard.h"
+#include "TrainingData.h"
+#include <cstdint>
+#include <vector>
+
+// number of positions stored together, the widest kernel's lane count.
+const int BATCH_BLOCK = 16;
+
+/* positions laid out for evaluating many at once: for each block of
+   BATCH_BLOCK positions, the piece code of every square of every position
+   with the positions of a square next to each other, followed by the
+   bitboards, kings and players to move of each position. evaluating
+   position after position then becomes the same arithmetic on every lane
+   of a vector. */
+class PositionBatch {
+
+public:
+
+  /* function that empties the batch. */
+  void clear();
+
+  /* getter function for the number of positions in the batch. */
+  size_t size() const { return count; }
+
+  /* function that adds the position on a board. */
+  void add(const ChessBoard& board);
+
+  /* function that adds a packed position, without setting up a board. */
+  void add(const PackedPosition& position);
+
+  // piece on square s of position i at codes[(i / BATCH_BLOCK * 64 + s)
+  // * BATCH_BLOCK + i % BATCH_BLOCK], colour*6 + type or EMPTY.
+  static constexpr uint8_t EMPTY = 12;
+  std::vector<uint8_t> codes;
+  std::vector<uint64_t> pawns[2];
+  std::vector<uint64_t> occupancy;
+  std::vector<uint8_t> kings[2];
+  std::vector<uint8_t> sideToMove;
+
+private:
+
+  /* function that makes room for one more position, returning its number. */
+  size_t grow();
+
+  size_t count = 0;
+};
+
+// instruction sets a batch can be evaluated with, slowest first.
+enum BatchKernel {SCALAR_KERNEL, AVX2_KERNEL, AVX512_KERNEL};
+
+/* function that returns the fastest kernel the processor supports. */
+BatchKernel bestBatchKernel();
+
+/* function that returns the name of a kernel. */
+const char* batchKernelName(BatchKernel kernel);
+
+/* function that scores every position of a batch with the terms of
+   evaluate, which it matches exactly: material, piece-square tables and
+   pawn structure, the last worked out with bitboards rather than looked
+   up in a pawn table.
+   @param batch holds the positions.
+   @param scores is filled with the score of each position from the point
+   of view of the player to move, and must have room for batch.size().
+   @param kernel is the instruction set to use, lowered to the best the
+   processor supports. */
+void evaluateBatch(const PositionBatch& batch, int* scores,
+		   BatchKernel kernel = bestBatchKernel());
+
+#endif
@@ -0,0 +1,461 @@
+#include "ChessBoard.h"
+#include "Evaluation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* micro-benchmarks of the board primitives. every benchmark runs in the
+   same fixed order with the same inputs, so results from different
+   commits can be compared line by line.
+
+   usage: bench [--reps N] [--warmup MS] [--target MS] [--filter TEXT]
+                [--json] */
+
+namespace {
+
+// middlegame positions used for check, move and generation benchmarks.
+const char* const MIDDLEGAME_POSITIONS[] = {
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+  "r2q1rk1/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R2QK2R w KQ - 0 9",
+  "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 0 7",
+  "2r2rk1/pp1bqppp/2n1pn2/3p4/2PP4/P1N1PN2/1PQ2PPP/2R1KB1R w K - 0 13",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+  "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15"};
+
+const char* const MATE_POSITIONS[] = {
+  "rnb1kbnr/pppp1ppp/8/4p3/5PPq/8/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+  "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+  "3R2k1/5ppp/8/8/8/8/5PPP/6K1 b - - 0 1"};
+
+const char* const STALEMATE_POSITIONS[] = {
+  "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",
+  "k7/8/1Q6/8/8/8/8/7K b - - 0 1",
+  "8/8/8/8/8/6k1/5q2/7K w - - 0 1"};
+
+// Alekhine vs. Vasic (1931), ending in checkmate.
+const char* const GAME_MOVES[][2] = {
+  {"E2", "E4"}, {"E7", "E6"}, {"D2", "D4"}, {"D7", "D5"}, {"B1", "C3"},
+  {"F8", "B4"}, {"F1", "D3"}, {"B4", "C3"}, {"B2", "C3"}, {"H7", "H6"},
+  {"C1", "A3"}, {"B8", "D7"}, {"D1", "E2"}, {"D5", "E4"}, {"D3", "E4"},
+  {"G8", "F6"}, {"E4", "D3"}, {"B7", "B6"}, {"E2", "E6"}, {"F7", "E6"},
+  {"D3", "G6"}};
+
+// stream buffer that throws away everything written to it.
+class NullBuffer : public streambuf {
+protected:
+  int overflow(int character) { return character; }
+  streamsize xsputn(const char*, streamsize count) { return count; }
+};
+
+NullBuffer nullBuffer;
+
+// object that silences cout while it is in scope.
+class QuietOutput {
+public:
+  QuietOutput() : saved(cout.rdbuf(&nullBuffer)) {}
+  ~QuietOutput() { cout.rdbuf(saved); }
+private:
+  streambuf* saved;
+};
+
+// struct holding the options given on the command line.
+struct BenchOptions {
+  int repetitions = 15;
+  int warmupMilliseconds = 100;
+  int targetMilliseconds = 20;
+  string filter;
+  bool json = false;
+};
+
+// struct holding the timing statistics of one benchmark in ns per operation.
+struct BenchStatistics {
+  string name;
+  uint64_t operations;
+  double median;
+  double p10;
+  double p90;
+  double minimum;
+  double mean;
+};
+
+// results are folded into this so the optimiser cannot drop the work.
+volatile uint64_t sink = 0;
+
+double nanosecondsSince(chrono::steady_clock::time_point start) {
+  return (double)chrono::duration_cast<chrono::nanoseconds>
+    (chrono::steady_clock::now() - start).count();
+}
+
+double percentile(const vector<double>& sorted, double fraction) {
+  double index = fraction * (sorted.size() - 1);
+  size_t lower = (size_t)index;
+  size_t upper = min(lower + 1, sorted.size() - 1);
+  return sorted[lower] + (sorted[upper] - sorted[lower]) * (index - lower);
+}
+
+/* function that times a benchmark body. the body is run during warm-up to
+   size a batch that takes about the target time, then each repetition
+   times one batch and yields one ns per operation sample.
+   @param operations is the number of operations one call of body does. */
+template <typename Body>
+BenchStatistics measure(const string& name, uint64_t operations, Body body,
+			const BenchOptions& options) {
+
+  uint64_t calls = 0;
+  auto start = chrono::steady_clock::now();
+  do {
+    sink += body();
+    calls++;
+  } while (nanosecondsSince(start) < options.warmupMilliseconds * 1e6);
+
+  double perCall = nanosecondsSince(start) / calls;
+  uint64_t batch = max<uint64_t>(1, (uint64_t)(options.targetMilliseconds
+					       * 1e6 / perCall));
+
+  vector<double> samples;
+  for (int repetition = 0; repetition < options.repetitions; repetition++) {
+    start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < batch; i++)
+      sink += body();
+    samples.push_back(nanosecondsSince(start) / (batch * operations));
+  }
+  sort(samples.begin(), samples.end());
+
+  BenchStatistics statistics;
+  statistics.name = name;
+  statistics.operations = batch * operations;
+  statistics.median = percentile(samples, 0.5);
+  statistics.p10 = percentile(samples, 0.1);
+  statistics.p90 = percentile(samples, 0.9);
+  statistics.minimum = samples.front();
+  double total = 0;
+  for (double sample : samples)
+    total += sample;
+  statistics.mean = total / samples.size();
+  return statistics;
+}
+
+/* function that sets up one board per position, without output.
+   @param positions are the positions in Forsyth-Edwards Notation. */
+template <size_t N>
+vector<unique_ptr<ChessBoard>> makeBoards(const char* const (&positions)[N]) {
+  QuietOutput quiet;
+  vector<unique_ptr<ChessBoard>> boards;
+  for (const char* fen : positions) {
+    boards.emplace_back(new ChessBoard());
+    if (!boards.back()->setPosition(fen)) {
+      cerr << "bench: bad position " << fen << endl;
+      exit(1);
+    }
+  }
+  return boards;
+}
+
+// struct holding a move together with the board it is tried on.
+struct BoardMove {
+  ChessBoard* board;
+  Move move;
+};
+
+/* function that splits the moves valid for the pieces of each board into
+   those that legalMove accepts and those it rejects. */
+void collectMoves(vector<unique_ptr<ChessBoard>>& boards,
+		  vector<BoardMove>& legal, vector<BoardMove>& illegal) {
+
+  for (auto& board : boards) {
+    Colour colour = board->sideToMove();
+    for (int column = 0; column < 8; column++)
+      for (int row = 0; row < 8; row++) {
+	const Piece* piece = board->pieceAt(column, row);
+	if (piece == nullptr || piece->getPieceColour() != colour)
+	  continue;
+	for (int target = 0; target < 64; target++) {
+	  Move move = {column, row, target % 8, target / 8};
+	  const Piece* captured = board->pieceAt(move.targetColumn(),
+						 move.targetRow());
+	  if (captured != nullptr && captured->getPieceColour() == colour)
+	    continue;
+	  if (board->legalMove(move, colour))
+	    legal.push_back({board.get(), move});
+	  else
+	    illegal.push_back({board.get(), move});
+	}
+      }
+  }
+
+  // shuffle with a fixed seed so the order, not the content, is random.
+  mt19937 generator(2024);
+  for (size_t i = legal.size(); i > 1; i--)
+    swap(legal[i - 1], legal[generator() % i]);
+  for (size_t i = illegal.size(); i > 1; i--)
+    swap(illegal[i - 1], illegal[generator() % i]);
+}
+
+/* function that plays through the game, putting before each move some
+   attempts to move the same piece where it cannot go, as a player trying
+   things out would. the attempts skip positions of its own pieces, which
+   are turned down before any rules are applied.
+   @param tries is the number of attempts before each move. */
+vector<pair<string, string>> gameWithAttempts(int tries) {
+
+  QuietOutput quiet;
+  ChessBoard board;
+  vector<pair<string, string>> submissions;
+  for (const auto& gameMove : GAME_MOVES) {
+    int column = gameMove[0][0] - 'A';
+    int row = gameMove[0][1] - '1';
+    Colour colour = board.sideToMove();
+    MoveList legal = board.legalMoves();
+    int attempts = 0;
+    for (int target = 0; target < 64 && attempts < tries; target++) {
+      Move move = {column, row, target % 8, target / 8};
+      const Piece* captured = board.pieceAt(target % 8, target / 8);
+      if ((captured != nullptr && captured->getPieceColour() == colour)
+	  || find(legal.begin(), legal.end(), move) != legal.end())
+	continue;
+      string position = {char('A' + target % 8), char('1' + target / 8)};
+      submissions.push_back({gameMove[0], position});
+      attempts++;
+    }
+    submissions.push_back({gameMove[0], gameMove[1]});
+    board.submitMove(gameMove[0], gameMove[1]);
+  }
+  return submissions;
+}
+
+void printText(ostream& out, const BenchStatistics& statistics) {
+  out << left << setw(28) << statistics.name << right << fixed
+      << setprecision(1) << setw(12) << statistics.median << setw(12)
+      << statistics.p10 << setw(12) << statistics.p90 << setw(12)
+      << statistics.minimum << setw(12) << statistics.mean << endl;
+}
+
+void printJson(ostream& out, const BenchStatistics& statistics, bool first) {
+  out << (first ? "  " : ", ") << "{\"name\": \"" << statistics.name
+      << "\", \"operations\": " << statistics.operations << fixed
+      << setprecision(2) << ", \"median\": " << statistics.median
+      << ", \"p10\": " << statistics.p10 << ", \"p90\": " << statistics.p90
+      << ", \"min\": " << statistics.minimum << ", \"mean\": "
+      << statistics.mean << "}" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  BenchOptions options;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--reps") && i + 1 < argc)
+      options.repetitions = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--warmup") && i + 1 < argc)
+      options.warmupMilliseconds = max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--target") && i + 1 < argc)
+      options.targetMilliseconds = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+      options.filter = argv[++i];
+    else if (!strcmp(argv[i], "--json"))
+      options.json = true;
+    else {
+      cerr << "usage: bench [--reps N] [--warmup MS] [--target MS]"
+	   << " [--filter TEXT] [--json]" << endl;
+      return 1;
+    }
+  }
+
+  auto middlegame = makeBoards(MIDDLEGAME_POSITIONS);
+  auto mates = makeBoards(MATE_POSITIONS);
+  auto stalemates = makeBoards(STALEMATE_POSITIONS);
+
+  vector<BoardMove> legal, illegal;
+  collectMoves(middlegame, legal, illegal);
+
+  // the same positions again with attack maps kept.
+  auto mapped = makeBoards(MIDDLEGAME_POSITIONS);
+  for (auto& board : mapped)
+    board->keepAttackMaps(true);
+  vector<BoardMove> mappedLegal, mappedIllegal;
+  collectMoves(mapped, mappedLegal, mappedIllegal);
+
+  // results bypass cout, which is silenced while submitMove is measured.
+  ostream results(cout.rdbuf());
+  bool first = true;
+  auto report = [&](const BenchStatistics& statistics) {
+    if (options.json)
+      printJson(results, statistics, first);
+    else
+      printText(results, statistics);
+    first = false;
+  };
+
+  // runs a benchmark only if its name matches the filter.
+  auto run = [&](const string& name, uint64_t operations, auto body) {
+    if (name.find(options.filter) == string::npos)
+      return;
+    report(measure(name, operations, body, options));
+  };
+
+  if (options.json)
+    results << "[" << endl;
+  else
+    results << left << setw(28) << "benchmark (ns/op)" << right << setw(12)
+	 << "median" << setw(12) << "p10" << setw(12) << "p90" << setw(12)
+	 << "min" << setw(12) << "mean" << endl;
+
+  run("inCheck/middlegame", middlegame.size() * 2, [&] {
+    uint64_t checks = 0;
+    for (auto& board : middlegame)
+      checks += board->inCheck(WHITE) + board->inCheck(BLACK);
+    return checks;
+  });
+
+  run("inCheck/attack maps", mapped.size() * 2, [&] {
+    uint64_t checks = 0;
+    for (auto& board : mapped)
+      checks += board->inCheck(WHITE) + board->inCheck(BLACK);
+    return checks;
+  });
+
+  run("legalMove/legal", legal.size(), [&] {
+    uint64_t accepted = 0;
+    for (BoardMove& entry : legal)
+      accepted += entry.board->legalMove(entry.move,
+					 entry.board->sideToMove());
+    return accepted;
+  });
+
+  run("legalMove/illegal", illegal.size(), [&] {
+    uint64_t accepted = 0;
+    for (BoardMove& entry : illegal)
+      accepted += entry.board->legalMove(entry.move,
+					 entry.board->sideToMove());
+    return accepted;
+  });
+
+  run("legalMove/legal maps", mappedLegal.size(), [&] {
+    uint64_t accepted = 0;
+    for (BoardMove& entry : mappedLegal)
+      accepted += entry.board->legalMove(entry.move,
+					 entry.board->sideToMove());
+    return accepted;
+  });
+
+  run("legalMove/illegal maps", mappedIllegal.size(), [&] {
+    uint64_t accepted = 0;
+    for (BoardMove& entry : mappedIllegal)
+      accepted += entry.board->legalMove(entry.move,
+					 entry.board->sideToMove());
+    return accepted;
+  });
+
+  run("inCheckMate/mate", mates.size(), [&] {
+    uint64_t over = 0;
+    for (auto& board : mates)
+      over += board->inCheckMate(board->sideToMove());
+    return over;
+  });
+
+  run("inCheckMate/stalemate", stalemates.size(), [&] {
+    uint64_t over = 0;
+    for (auto& board : stalemates)
+      over += board->inCheckMate(board->sideToMove());
+    return over;
+  });
+
+  run("inCheckMate/ongoing", middlegame.size(), [&] {
+    uint64_t over = 0;
+    for (auto& board : middlegame)
+      over += board->inCheckMate(board->sideToMove());
+    return over;
+  });
+
+  run("inCheckMate/attack maps", mapped.size(), [&] {
+    uint64_t over = 0;
+    for (auto& board : mapped)
+      over += board->inCheckMate(board->sideToMove());
+    return over;
+  });
+
+  run("legalMoves/middlegame", middlegame.size(), [&] {
+    uint64_t count = 0;
+    for (auto& board : middlegame)
+      count += board->legalMoves().size();
+    return count;
+  });
+
+  run("legalMoves/attack maps", mapped.size(), [&] {
+    uint64_t count = 0;
+    for (auto& board : mapped)
+      count += board->legalMoves().size();
+    return count;
+  });
+
+  run("evaluate/middlegame", middlegame.size(), [&] {
+    uint64_t total = 0;
+    for (auto& board : middlegame)
+      total += evaluate(*board);
+    return total;
+  });
+
+  // one op is one submitMove, the reset starting each game is included.
+  {
+    QuietOutput quiet;
+    ChessBoard game;
+    const size_t moves = sizeof(GAME_MOVES) / sizeof(GAME_MOVES[0]);
+    run("submitMove/game", moves, [&] {
+      game.resetBoard();
+      for (size_t i = 0; i < moves; i++)
+	game.submitMove(GAME_MOVES[i][0], GAME_MOVES[i][1]);
+      return game.positionKey();
+    });
+
+    // three illegal attempts before every move of the game.
+    auto attempts = gameWithAttempts(3);
+    run("submitMove/illegal tries", attempts.size(), [&] {
+      game.resetBoard();
+      for (const auto& attempt : attempts)
+	game.submitMove(attempt.first.c_str(), attempt.second.c_str());
+      return game.positionKey();
+    });
+
+    game.keepAttackMaps(true);
+    run("submitMove/attack maps", moves, [&] {
+      game.resetBoard();
+      for (size_t i = 0; i < moves; i++)
+	game.submitMove(GAME_MOVES[i][0], GAME_MOVES[i][1]);
+      return game.positionKey();
+    });
+  }
+
+  {
+    QuietOutput quiet;
+    run("board/construct", 1, [&] {
+      ChessBoard board;
+      return board.positionKey();
+    });
+
+    ChessBoard board;
+    run("board/reset", 1, [&] {
+      board.resetBoard();
+      return board.positionKey();
+    });
+  }
+
+  if (options.json)
+    results << "]" << endl;
+  return 0;
+}
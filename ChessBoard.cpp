@@ -1,12 +1,105 @@
 #include "ChessBoard.h"
+#include "Instrumentation.h"
+#include "LineTables.h"
 #include <iostream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
 
 using namespace std;
 
 
+namespace {
 
+// random numbers that make up the zobrist hash key of a position.
+struct ZobristKeys {
+  uint64_t pieces[12][NUMBER_RANKS*NUMBER_FILES];
+  uint64_t castling[4];
+  uint64_t blackToMove;
 
-ChessBoard::ChessBoard() {
+  ZobristKeys() {
+    // fixed seed so keys (and anything stored by key) match between runs.
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    for (int piece = 0; piece < 12; piece++)
+      for (int square = 0; square < NUMBER_RANKS*NUMBER_FILES; square++)
+	pieces[piece][square] = next(seed);
+    for (int i = 0; i < 4; i++)
+      castling[i] = next(seed);
+    blackToMove = next(seed);
+  }
+
+  // splitmix64 generator.
+  static uint64_t next(uint64_t& seed) {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+};
+
+const ZobristKeys zobrist;
+
+/* positions each type of piece could move to from each position on an
+   empty board, pawns by colour. moves outside these need not be put to
+   the rules of the piece at all. */
+struct PieceReach {
+  uint64_t squares[6][NUMBER_RANKS*NUMBER_FILES];
+  uint64_t pawn[2][NUMBER_RANKS*NUMBER_FILES];
+
+  PieceReach() {
+    for (int from = 0; from < 64; from++) {
+      for (int type = 0; type < 6; type++)
+	squares[type][from] = 0;
+      pawn[WHITE][from] = pawn[BLACK][from] = 0;
+      for (int to = 0; to < 64; to++) {
+	if (to == from)
+	  continue;
+	int columns = abs(to % 8 - from % 8);
+	int rows = to / 8 - from / 8;
+	uint64_t bit = 1ULL << to;
+	bool straight = columns == 0 || rows == 0;
+	bool diagonal = columns == abs(rows);
+	if (straight)
+	  squares[ROOK][from] |= bit;
+	if (diagonal)
+	  squares[BISHOP][from] |= bit;
+	if (straight || diagonal)
+	  squares[QUEEN][from] |= bit;
+	if (columns*abs(rows) == 2)
+	  squares[KNIGHT][from] |= bit;
+	if (columns <= 1 && abs(rows) <= 1)
+	  squares[KING][from] |= bit;
+	if (columns <= 1 && (rows == UP || (columns == 0 && rows == 2*UP)))
+	  pawn[WHITE][from] |= bit;
+	if (columns <= 1 && (rows == DOWN || (columns == 0 && rows == 2*DOWN)))
+	  pawn[BLACK][from] |= bit;
+      }
+    }
+  }
+};
+
+const PieceReach reach;
+
+/* function that renumbers bits row*8+column as column*8+row, mirroring
+   the board in its a1-h8 diagonal, so that taking the bits in order goes
+   through the positions column by column. */
+uint64_t byColumn(uint64_t squares) {
+  uint64_t swapped = 0x0f0f0f0f00000000ULL & (squares ^ (squares << 28));
+  squares ^= swapped ^ (swapped >> 28);
+  swapped = 0x3333000033330000ULL & (squares ^ (squares << 14));
+  squares ^= swapped ^ (swapped >> 14);
+  swapped = 0x5500550055005500ULL & (squares ^ (squares << 7));
+  return squares ^ swapped ^ (swapped >> 7);
+}
+
+}
+
+
+ChessBoard::ChessBoard() : ChessBoard(true) {
+}
+
+
+ChessBoard::ChessBoard(bool announce) {
 
   // one of each type of piece object is stored in array for reuse.
   pieceObjects[0] = new Pawn(WHITE, this);
@@ -24,8 +117,13 @@ ChessBoard::ChessBoard() {
 
   // piece pointers to above are setup.
   setBoard();
+  computeKey();
 
-  cout << "A new chess game is started!" << endl;
+  // room for a long game plus a deep search without reallocating.
+  keyHistory.reserve(1024);
+
+  if (announce)
+    cout << "A new chess game is started!" << endl;
 }
 
 
@@ -99,6 +197,11 @@ void ChessBoard::resetBoard() {
   rightBlackRookInactive = true;
   
   coloursTurn = WHITE;
+  computeKey();
+  keyHistory.clear();
+  halfmoves = 0;
+  reversiblePlies = 0;
+  firstPly = 0;
 
   cout << "A new chess game is started!" << endl;
 }
@@ -107,29 +210,34 @@ void ChessBoard::resetBoard() {
 void ChessBoard::submitMove(const char originalPosition[],
 			    const char targetPosition[]) {
 
-  // positions are converted and stored as column and row numbers in a struct.
-  Move move;
-  move.originalColumn = originalPosition[0] - 'A';
-  move.originalRow = originalPosition[1] - '1';
-  move.targetColumn = targetPosition[0] - 'A';
-  move.targetRow = targetPosition[1] - '1';
+  INSTRUMENT_SCOPE(PROBE_SUBMIT_MOVE);
 
   /* run preliminary checks on the move to ensure it is the correct players 
-     turn and piece in original position exist.*/
-  if (!preliminaryChecks(originalPosition, move))
+     turn and piece in original position exist. the positions are converted
+     and stored as column and row numbers in the move once they are known
+     to be on the board. */
+  Move move;
+  if (!preliminaryChecks(originalPosition, targetPosition, move))
     return;
 
+  /* the move is legal if it is among the legal moves of the position,
+     which are listed once however many moves are tried. */
+  bool legal = (legalTargets(move.originalColumn(), move.originalRow())
+		>> move.targetSquare()) & 1;
   
   // if move attempts to castle, go through castling process.
   if (isCastling(move)) {
-    if (legalCastle(move)) {
+    if (legal) {
+      uint64_t previousKey = key;
+      uint64_t previousCastling = castlingKey();
       makeCastlingMove(move);
       castlingAdjustments(move);
       cout << "Castling move by " << coloursTurn << " with rook in position "
 	   << originalPosition << " and king in position "
 	   << targetPosition << endl;
       // once move is made it becomes other players turn.
-      coloursTurn = !coloursTurn;
+      changeTurn();
+      recordHistory(previousKey, previousCastling, false);
       printGameState(coloursTurn);
       return;
     }
@@ -138,17 +246,22 @@ void ChessBoard::submitMove(const char originalPosition[],
   }
 
   
-  /* checks if move is valid (is one of the potential moves of the piece) 
-     and legal (the associated movement on the board does not put the 
-     player in check) before making the move. */
-  if (board[move.originalColumn][move.originalRow]->isValid(move)
-      && legalMove(move, coloursTurn)) {
+  /* the move must be valid (one of the potential moves of the piece)
+     and legal (the associated movement on the board does not put the
+     player in check) to be made. */
+  if (legal) {
 
     printMove(move, originalPosition, targetPosition);
+    uint64_t previousKey = key;
+    uint64_t previousCastling = castlingKey();
+    bool captureOrPawn = board[move.targetColumn()][move.targetRow()] != nullptr
+      || board[move.originalColumn()][move.originalRow()]->getPieceType()
+      == PAWN;
     makeMove(move);
     castlingAdjustments(move);
     // once move is made it becomes other players turn.
-    coloursTurn = !coloursTurn;
+    changeTurn();
+    recordHistory(previousKey, previousCastling, captureOrPawn);
 
     // checks state of the game after move occurs.
     printGameState(coloursTurn);
@@ -156,16 +269,24 @@ void ChessBoard::submitMove(const char originalPosition[],
   
   else
     cout << coloursTurn << "'s "
-	 << board[move.originalColumn][move.originalRow]->getType()
+	 << board[move.originalColumn()][move.originalRow()]->getType()
 	 << " cannot move to " << targetPosition << "!" << endl;
 }
 
 
 
-bool ChessBoard::preliminaryChecks(const char originalPosition[], Move move)  {
+bool ChessBoard::preliminaryChecks(const char originalPosition[],
+				   const char targetPosition[], Move& move)  {
+
+  // disallows move to occur if game is in checkmate or stalemate.
+  if (!hasLegalMove()) {
+    cout << "Game has ended, no further moves can be made. Please reset board."
+	 << endl;
+    return false;
+  }
 
-  // disallows move to occur if game is in checkmate.
-  if (inCheckMate(coloursTurn)) {
+  // disallows move to occur if game is drawn by repetition or fifty moves.
+  if (drawnByRule()) {
     cout << "Game has ended, no further moves can be made. Please reset board."
 	 << endl;
     return false;
@@ -173,24 +294,29 @@ bool ChessBoard::preliminaryChecks(const char originalPosition[], Move move)  {
   
 
   // check supplied move is a valid position.
-  if ((move.originalColumn < 0) || (move.originalColumn > 7)
-      || (move.targetColumn > 7) || (move.originalRow < 0)
-      || (move.targetRow > 7) || (move.targetRow < 0)
-      || (move.targetRow > 7) || (move.targetRow < 0)) {
+  int originalColumn = originalPosition[0] - 'A';
+  int originalRow = originalPosition[1] - '1';
+  int targetColumn = targetPosition[0] - 'A';
+  int targetRow = targetPosition[1] - '1';
+  if ((originalColumn < 0) || (originalColumn > 7)
+      || (targetColumn > 7) || (originalRow < 0)
+      || (originalRow > 7) || (targetColumn < 0)
+      || (targetRow > 7) || (targetRow < 0)) {
     cout << "Invalid positions supplied" << endl; 
     return false;
   }
+  move = Move(originalColumn, originalRow, targetColumn, targetRow);
   
   // check piece exists in submitted original position.
-  if (board[move.originalColumn][move.originalRow] == nullptr) {
+  if (board[move.originalColumn()][move.originalRow()] == nullptr) {
     cout << "There is no piece at position " << originalPosition << "!" << endl;
     return false;
   }
   
   // check if submitted move corresponds to who's turn it is.
-  if (board[move.originalColumn][move.originalRow]->getPieceColour()
+  if (board[move.originalColumn()][move.originalRow()]->getPieceColour()
       != coloursTurn) {
-    if (board[move.originalColumn][move.originalRow]->getPieceColour()
+    if (board[move.originalColumn()][move.originalRow()]->getPieceColour()
 	== BLACK) {
       cout << "It is not black's turn to move!" << endl;
     }
@@ -207,25 +333,38 @@ bool ChessBoard::preliminaryChecks(const char originalPosition[], Move move)  {
 
 bool ChessBoard::legalMove(Move move, Colour colour) {
 
+  INSTRUMENT_SCOPE(PROBE_LEGAL_MOVE);
+
   // keeps a store of piece object in target position.
-  Piece* piece = board[move.targetColumn][move.targetRow];
+  Piece* piece = board[move.targetColumn()][move.targetRow()];
 
   // prevents attacking piece from eating it's own colour.
-  if (board[move.originalColumn][move.originalRow] != nullptr
-      && board[move.targetColumn][move.targetRow] != nullptr) {
-    if (board[move.originalColumn][move.originalRow]->getPieceColour()
-	== board[move.targetColumn][move.targetRow]->getPieceColour())
+  if (board[move.originalColumn()][move.originalRow()] != nullptr
+      && board[move.targetColumn()][move.targetRow()] != nullptr) {
+    if (board[move.originalColumn()][move.originalRow()]->getPieceColour()
+	== board[move.targetColumn()][move.targetRow()]->getPieceColour())
       return false;
   }
 
   // keep track of whether the move involves a king to adjust board details.
   bool kingMove = false;
-  if ((move.originalColumn == whiteKingColumn && move.originalRow
+  if ((move.originalColumn() == whiteKingColumn && move.originalRow()
        == whiteKingRow)
-      || (move.originalColumn == blackKingColumn && move.originalRow
+      || (move.originalColumn() == blackKingColumn && move.originalRow()
 	  == blackKingRow))
     kingMove = true;
 
+  // attack maps tell whether the king is left attacked without the move.
+  const Piece* mover = board[move.originalColumn()][move.originalRow()];
+  if (attackMap && mover != nullptr && mover->getPieceColour() == colour) {
+    if (kingMove)
+      return kingMoveSafe(move, colour);
+    int king = colour == WHITE ? whiteKingRow*NUMBER_FILES + whiteKingColumn
+      : blackKingRow*NUMBER_FILES + blackKingColumn;
+    return !attackMap->exposesKing(move.originalSquare(), move.targetSquare(),
+				   king, !colour);
+  }
+
   makeMove(move);
   
   // checks if making the move puts player in check and reverses move.
@@ -244,46 +383,69 @@ bool ChessBoard::legalMove(Move move, Colour colour) {
 
 void ChessBoard::makeMove(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_MAKE_MOVE);
+
   // if move is to be made and piece moving is a king, the kings position gets updated.
-  if (move.originalColumn == whiteKingColumn && move.originalRow
+  if (move.originalColumn() == whiteKingColumn && move.originalRow()
       == whiteKingRow) {
-    whiteKingColumn = move.targetColumn;
-    whiteKingRow = move.targetRow;
+    whiteKingColumn = move.targetColumn();
+    whiteKingRow = move.targetRow();
   }
 
-  if (move.originalColumn == blackKingColumn && move.originalRow == blackKingRow) {
-    blackKingColumn = move.targetColumn;
-    blackKingRow = move.targetRow;
+  if (move.originalColumn() == blackKingColumn && move.originalRow()
+      == blackKingRow) {
+    blackKingColumn = move.targetColumn();
+    blackKingRow = move.targetRow();
   }
 
+  /* hash keys drop any piece taken and follow the moving piece, in that
+     order so attack maps never hold two pieces in one position. */
+  togglePiece(board[move.targetColumn()][move.targetRow()],
+	      move.targetColumn(), move.targetRow());
+  togglePiece(board[move.originalColumn()][move.originalRow()],
+	      move.originalColumn(), move.originalRow());
+  togglePiece(board[move.originalColumn()][move.originalRow()],
+	      move.targetColumn(), move.targetRow());
+
   // movement occurs here
-  board[move.targetColumn][move.targetRow]
-    = board[move.originalColumn][move.originalRow];
+  board[move.targetColumn()][move.targetRow()]
+    = board[move.originalColumn()][move.originalRow()];
   
-  board[move.originalColumn][move.originalRow] = nullptr;
+  board[move.originalColumn()][move.originalRow()] = nullptr;
  
 }
 
 
 void ChessBoard::reverseMove(Move move, Piece* piece, bool kingMove) {
 
+  INSTRUMENT_SCOPE(PROBE_REVERSE_MOVE);
+
   // if king has moved, reversing will also reverse king position details.
   if (kingMove) {
-    if (move.targetColumn == whiteKingColumn && move.targetRow == whiteKingRow) {
-      whiteKingColumn = move.originalColumn;
-      whiteKingRow = move.originalRow;
+    if (move.targetColumn() == whiteKingColumn
+	&& move.targetRow() == whiteKingRow) {
+      whiteKingColumn = move.originalColumn();
+      whiteKingRow = move.originalRow();
     }
     
-    if (move.targetColumn == blackKingColumn && move.targetRow == blackKingRow) {
-      blackKingColumn = move.originalColumn;
-      blackKingRow = move.originalRow;
+    if (move.targetColumn() == blackKingColumn
+	&& move.targetRow() == blackKingRow) {
+      blackKingColumn = move.originalColumn();
+      blackKingRow = move.originalRow();
     }
   }
 
+  // hash keys are adjusted back the same way they were adjusted by makeMove.
+  togglePiece(board[move.targetColumn()][move.targetRow()],
+	      move.originalColumn(), move.originalRow());
+  togglePiece(board[move.targetColumn()][move.targetRow()],
+	      move.targetColumn(), move.targetRow());
+  togglePiece(piece, move.targetColumn(), move.targetRow());
+
   // move reverse occurs here
-  board[move.originalColumn][move.originalRow]
-    = board[move.targetColumn][move.targetRow];
-  board[move.targetColumn][move.targetRow] = piece;
+  board[move.originalColumn()][move.originalRow()]
+    = board[move.targetColumn()][move.targetRow()];
+  board[move.targetColumn()][move.targetRow()] = piece;
   
 }
 
@@ -292,6 +454,8 @@ void ChessBoard::reverseMove(Move move, Piece* piece, bool kingMove) {
 
 bool ChessBoard::inCheck(Colour colour) {
 
+  INSTRUMENT_SCOPE(PROBE_IN_CHECK);
+
   int kingColumn;
   int kingRow;
 
@@ -305,6 +469,10 @@ bool ChessBoard::inCheck(Colour colour) {
     kingRow = blackKingRow;
   }
 
+  if (attackMap)
+    return attackMap->attackers(kingRow*NUMBER_FILES + kingColumn)
+      & attackMap->pieces(!colour);
+
   // position which will be attacked.
   Move kingThreatMove;
   
@@ -316,10 +484,7 @@ bool ChessBoard::inCheck(Colour colour) {
       if (board[column][row] != nullptr && board[column][row]->getPieceColour()
 	  != colour) {
 	
-	kingThreatMove.originalColumn = column;
-	kingThreatMove.originalRow = row;
-	kingThreatMove.targetColumn = kingColumn;
-	kingThreatMove.targetRow = kingRow;
+	kingThreatMove = Move(column, row, kingColumn, kingRow);
 
 	// if the move onto the king is valid  player is in check.
 	if (board[column][row]->isValid(kingThreatMove)) {	 
@@ -337,6 +502,14 @@ bool ChessBoard::inCheck(Colour colour) {
 
 bool ChessBoard::inCheckMate(Colour colour) {
 
+  INSTRUMENT_SCOPE(PROBE_IN_CHECK_MATE);
+
+  /* checks and pins are worked out once instead of trying every move,
+     unless attack maps are kept, which answer for each move directly. */
+  LegalityMasks masks;
+  if (!attackMap)
+    computeLegalityMasks(colour, masks);
+
   Move move;
 
   // loop through each position on the board.
@@ -351,17 +524,21 @@ bool ChessBoard::inCheckMate(Colour colour) {
 	for (int targetColumn = 0; targetColumn < 8; targetColumn++) {
 	  for (int targetRow = 0; targetRow < 8; targetRow++) {
 	      
-	    move.originalColumn = column;
-	    move.originalRow = row;
-	    move.targetColumn = targetColumn;
-	    move.targetRow = targetRow;
+	    move = Move(column, row, targetColumn, targetRow);
+
+	    // pieces cannot take their own colour.
+	    if (board[targetColumn][targetRow] != nullptr
+		&& board[targetColumn][targetRow]->getPieceColour() == colour)
+	      continue;
 
 	    /* if any move is both valid and puts king
 	       out of check then not checkmate. */
-	    if (board[column][row]->isValid(move)) {	         	       
-	      if (legalMove(move, colour)) {       		  		
+	    if (board[column][row]->isValid(move)) {
+	      if (board[column][row]->getPieceType() == KING
+		  ? kingMoveSafe(move, colour)
+		  : attackMap ? legalMove(move, colour)
+		  : passesMasks(move, masks))
 		return false;
-	      }
 	    }
 	  }
 	}
@@ -378,15 +555,24 @@ bool ChessBoard::inCheckMate(Colour colour) {
 
 void ChessBoard::printGameState(Colour colour) {
   if (inCheck(coloursTurn)) {
-    if (inCheckMate(coloursTurn)) {
+    if (!hasLegalMove()) {
       cout << coloursTurn << " is in checkmate" << endl;
+      // checkmate takes precedence over draws by rule.
+      return;
     }
     else
       cout << coloursTurn << " is in check" << endl;
   }
   else
-    if (inCheckMate(coloursTurn))
+    if (!hasLegalMove()) {
       cout << "Game is in stalemate" << endl;
+      return;
+    }
+
+  if (repetitionCount() >= 2)
+    cout << "Game is drawn by threefold repetition" << endl;
+  else if (halfmoves >= 100)
+    cout << "Game is drawn by the fifty-move rule" << endl;
 }
     
 
@@ -396,18 +582,18 @@ void ChessBoard::printGameState(Colour colour) {
 void ChessBoard::printMove(Move move, const char originalPosition[],
 			   const char targetPosition[]) const {
   
-  if (board[move.targetColumn][move.targetRow] == nullptr) {
+  if (board[move.targetColumn()][move.targetRow()] == nullptr) {
     cout << coloursTurn << "'s "
-	 << board[move.originalColumn][move.originalRow]->getType()
+	 << board[move.originalColumn()][move.originalRow()]->getType()
 	 << " moves from " << originalPosition << " to "
 	 << targetPosition << endl;
   }
   else
     cout << coloursTurn << "'s "
-	 << board[move.originalColumn][move.originalRow]->getType()
+	 << board[move.originalColumn()][move.originalRow()]->getType()
 	 << " moves from " << originalPosition << " to " << targetPosition
 	 << " taking " << !coloursTurn << "'s "
-	 << board[move.targetColumn][move.targetRow]->getType() << endl;
+	 << board[move.targetColumn()][move.targetRow()]->getType() << endl;
 }
 
 
@@ -415,7 +601,7 @@ void ChessBoard::printMove(Move move, const char originalPosition[],
 bool ChessBoard::emptyTarget(Move move) const {
 
   // if target contains a piece, return it is false that position is empty.
-  if (board[move.targetColumn][move.targetRow] != nullptr)
+  if (board[move.targetColumn()][move.targetRow()] != nullptr)
     return false;
   else
     return true;
@@ -426,26 +612,11 @@ bool ChessBoard::emptyTarget(Move move) const {
 
 
 
-bool ChessBoard::pathEmpty(Move move, VerticalDirection verticalDirection,
-			   HorizontalDirection horizontalDirection) const{
+bool ChessBoard::pathEmpty(Move move) const {
 
-  int column = move.originalColumn + horizontalDirection;
-  int row = move.originalRow + verticalDirection;
-
-  /*check between original position and target if there
-  exists a piece that blocks move. */
-  while (column != move.targetColumn || row != move.targetRow) {
-    if (board[column][row] != nullptr) 
-      return false;
-    
-    else {
-      // if empty, increment to the next position.
-      column = column + horizontalDirection;
-      row = row + verticalDirection;
-    } 
-  }
-  // if all positions between original and target are empty return true.
-  return true;
+  // one lookup gives every position a piece could block the move on.
+  return (LINES.between[move.originalSquare()][move.targetSquare()]
+	  & occupancy) == 0;
 }
 
 
@@ -461,15 +632,15 @@ bool ChessBoard::isCastling(Move move) const {
   if (coloursTurn == BLACK) {
 
     // if target is kings position and king is inactive.
-    if (move.targetColumn == 4 && move.targetRow == 7 && blackKingInactive){
+    if (move.targetColumn() == 4 && move.targetRow() == 7 && blackKingInactive){
 
       // if move involves the black rooks.
-      if (move.originalRow == 7) {
+      if (move.originalRow() == 7) {
 
 	// check if supplied move is a rook that also has not moved during game.
-	if (move.originalColumn == 0 && leftBlackRookInactive)
+	if (move.originalColumn() == 0 && leftBlackRookInactive)
 	  return true;
-	if (move.originalColumn == 7 && rightBlackRookInactive)
+	if (move.originalColumn() == 7 && rightBlackRookInactive)
 	  return true;
       }
       return false;
@@ -477,15 +648,15 @@ bool ChessBoard::isCastling(Move move) const {
   }
   else {
     // if target is kings position and king is inactive.
-    if (move.targetColumn == 4 && move.targetRow == 0 && whiteKingInactive){
+    if (move.targetColumn() == 4 && move.targetRow() == 0 && whiteKingInactive){
 
       // if move involes white rooks.
-      if (move.originalRow == 0) {
+      if (move.originalRow() == 0) {
 
 	// check if suopplied move is a rook that also has not moved during game.
-	if (move.originalColumn == 0 && leftWhiteRookInactive)
+	if (move.originalColumn() == 0 && leftWhiteRookInactive)
 	  return true;
-	if (move.originalColumn == 7 && rightWhiteRookInactive)
+	if (move.originalColumn() == 7 && rightWhiteRookInactive)
 	  return true;
       }
     }
@@ -500,51 +671,71 @@ void ChessBoard::makeCastlingMove(Move move) {
 
   // calculate direction of castling.
   HorizontalDirection horizontalDirection;
-  if (move.originalColumn == 0)
+  if (move.originalColumn() == 0)
     horizontalDirection = RIGHT;
   else
     horizontalDirection = LEFT;
 
+  // hash keys drop the rook and king from their original positions.
+  togglePiece(board[move.originalColumn()][move.originalRow()],
+	      move.originalColumn(), move.originalRow());
+  togglePiece(board[move.targetColumn()][move.targetRow()],
+	      move.targetColumn(), move.targetRow());
+
   // if queen side castling/
-  if (move.originalColumn == 0) {
+  if (move.originalColumn() == 0) {
 
     // assigns king and rook to their positions in case of castling.
-    board[move.originalColumn + horizontalDirection*3][move.originalRow]
-      = board[move.originalColumn][move.originalRow];
+    board[move.originalColumn() + horizontalDirection*3][move.originalRow()]
+      = board[move.originalColumn()][move.originalRow()];
     
-    board[move.originalColumn][move.originalRow] = nullptr;
+    board[move.originalColumn()][move.originalRow()] = nullptr;
     
-    board[move.originalColumn + horizontalDirection*2][move.originalRow]
-      = board[move.targetColumn][move.targetRow];
+    board[move.originalColumn() + horizontalDirection*2][move.originalRow()]
+      = board[move.targetColumn()][move.targetRow()];
     
-    board[move.targetColumn][move.targetRow] = nullptr;
+    board[move.targetColumn()][move.targetRow()] = nullptr;
 
     // adjust king positions.
     if (coloursTurn == BLACK)
-      blackKingColumn = move.originalColumn + horizontalDirection*2;
+      blackKingColumn = move.originalColumn() + horizontalDirection*2;
     else
-      whiteKingColumn = move.originalColumn + horizontalDirection*2;
+      whiteKingColumn = move.originalColumn() + horizontalDirection*2;
+
+    togglePiece(board[move.originalColumn() + horizontalDirection*3]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*3, move.originalRow());
+    togglePiece(board[move.originalColumn() + horizontalDirection*2]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*2, move.originalRow());
 
   }
   // if not queen side castling.
   else {
 
     // assigns king and rook to their positions in case of castling.
-    board[move.originalColumn + horizontalDirection*2][move.originalRow]
-      = board[move.originalColumn][move.originalRow];
+    board[move.originalColumn() + horizontalDirection*2][move.originalRow()]
+      = board[move.originalColumn()][move.originalRow()];
     
-    board[move.originalColumn][move.originalRow] = nullptr;
+    board[move.originalColumn()][move.originalRow()] = nullptr;
     
-    board[move.originalColumn + horizontalDirection][move.originalRow]
-      = board[move.targetColumn][move.targetRow];
+    board[move.originalColumn() + horizontalDirection][move.originalRow()]
+      = board[move.targetColumn()][move.targetRow()];
     
-    board[move.targetColumn][move.targetRow] = nullptr;
+    board[move.targetColumn()][move.targetRow()] = nullptr;
 
     // adjust king position after move.
     if (coloursTurn == BLACK)
-      blackKingColumn = move.originalColumn + horizontalDirection;
+      blackKingColumn = move.originalColumn() + horizontalDirection;
     else
-      whiteKingColumn = move.originalColumn + horizontalDirection;
+      whiteKingColumn = move.originalColumn() + horizontalDirection;
+
+    togglePiece(board[move.originalColumn() + horizontalDirection*2]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*2, move.originalRow());
+    togglePiece(board[move.originalColumn() + horizontalDirection]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection, move.originalRow());
   } 
 }
 
@@ -553,98 +744,111 @@ void ChessBoard::reverseCastlingMove(Move move) {
 
   // calculate direction of castling.
   HorizontalDirection horizontalDirection;
-  if (move.originalColumn == 0)
+  if (move.originalColumn() == 0)
     horizontalDirection = RIGHT;
   else
     horizontalDirection = LEFT;
 
   // if queen side castling.
-  if (move.originalColumn == 0) {
+  if (move.originalColumn() == 0) {
+
+    // hash keys drop the rook and king from their castled positions.
+    togglePiece(board[move.originalColumn() + horizontalDirection*3]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*3, move.originalRow());
+    togglePiece(board[move.originalColumn() + horizontalDirection*2]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*2, move.originalRow());
 
     // place king and rook back to original positions in move.
-    board[move.originalColumn][move.originalRow]
-      = board[move.originalColumn + horizontalDirection*3][move.originalRow];
+    board[move.originalColumn()][move.originalRow()]
+      = board[move.originalColumn() + horizontalDirection*3]
+	[move.originalRow()];
     
-    board[move.originalColumn + horizontalDirection*3][move.originalRow]
+    board[move.originalColumn() + horizontalDirection*3][move.originalRow()]
       = nullptr;
     
-    board[move.targetColumn][move.targetRow]
-      =  board[move.originalColumn + horizontalDirection*2][move.originalRow];
+    board[move.targetColumn()][move.targetRow()]
+      = board[move.originalColumn() + horizontalDirection*2]
+	[move.originalRow()];
     
-    board[move.originalColumn + horizontalDirection*2][move.originalRow]
+    board[move.originalColumn() + horizontalDirection*2][move.originalRow()]
       = nullptr;
   }
 
   // not queen side castle reverse.
   else {
+    togglePiece(board[move.originalColumn() + horizontalDirection*2]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection*2, move.originalRow());
+    togglePiece(board[move.originalColumn() + horizontalDirection]
+		[move.originalRow()],
+		move.originalColumn() + horizontalDirection, move.originalRow());
+
     // reverse positions of king and rook to original.
-    board[move.originalColumn][move.originalRow]
-      = board[move.originalColumn + horizontalDirection*2][move.originalRow];
+    board[move.originalColumn()][move.originalRow()]
+      = board[move.originalColumn() + horizontalDirection*2]
+	[move.originalRow()];
     
-    board[move.originalColumn + horizontalDirection*2][move.originalRow]
+    board[move.originalColumn() + horizontalDirection*2][move.originalRow()]
       = nullptr;
     
-    board[move.targetColumn][move.targetRow]
-      =  board[move.originalColumn + horizontalDirection][move.originalRow];
+    board[move.targetColumn()][move.targetRow()]
+      =  board[move.originalColumn() + horizontalDirection][move.originalRow()];
     
-    board[move.originalColumn + horizontalDirection][move.originalRow]
+    board[move.originalColumn() + horizontalDirection][move.originalRow()]
       = nullptr;
   }
 
   // reverse position of king.
   if (coloursTurn == BLACK)
-    blackKingColumn = move.targetColumn;
+    blackKingColumn = move.targetColumn();
   else
-    whiteKingColumn = move.targetColumn;
-    
+    whiteKingColumn = move.targetColumn();
+
+  // hash keys return to having the rook and king in original positions.
+  togglePiece(board[move.originalColumn()][move.originalRow()],
+	      move.originalColumn(), move.originalRow());
+  togglePiece(board[move.targetColumn()][move.targetRow()],
+	      move.targetColumn(), move.targetRow());
 }
 
 bool ChessBoard::legalCastle(Move move) {
 
+  int kingColumn = coloursTurn == WHITE ? whiteKingColumn : blackKingColumn;
+  int kingRow = coloursTurn == WHITE ? whiteKingRow : blackKingRow;
+
   // castle cannot occur when player is in check.
-  if (inCheck(coloursTurn))
+  if (squareAttacked(kingColumn, kingRow, !coloursTurn))
     return false;
 
   // calculate direction.
   HorizontalDirection horizontalDirection;
-  if (move.originalColumn == 0)
+  if (move.originalColumn() == 0)
     horizontalDirection = RIGHT;
   else
     horizontalDirection = LEFT;
 
   // ensure path is empty between king and rook.
-  if (board[move.originalColumn + horizontalDirection][move.originalRow]
+  if (board[move.originalColumn() + horizontalDirection][move.originalRow()]
       == nullptr
-      && board[move.originalColumn + horizontalDirection*2][move.originalRow]
-      == nullptr) {
-    // if queen side castle then check extra position is empty.
-    if (move.originalColumn == 0) {
-      if (board[move.originalColumn + horizontalDirection*3][move.originalRow]
-	  == nullptr) {
-       
-	makeCastlingMove(move);
-     
-	if (inCheck(coloursTurn)) {
-	  reverseCastlingMove(move);
-	  return false;
-	}
-	else {
-	  reverseCastlingMove(move);
-	  return true;
-	}  
-      }
+      && board[move.originalColumn() + horizontalDirection*2]
+      [move.originalRow()] == nullptr) {
+    /* the king is not in check, so any line onto its castled position that
+       the castle itself would block already passes through the king.
+       whether the castled king is attacked can therefore be asked of the
+       board as it is, without making the castling move. */
+    if (move.originalColumn() == 0) {
+      // if queen side castle then check extra position is empty.
+      if (board[move.originalColumn() + horizontalDirection*3]
+	  [move.originalRow()] != nullptr)
+	return false;
+      return !squareAttacked(move.originalColumn() + horizontalDirection*2,
+			     move.originalRow(), !coloursTurn);
     }
 
-    // if not queen side castle, perform move and determine if in check.
-    makeCastlingMove(move);
-    if (inCheck(coloursTurn)) {
-      reverseCastlingMove(move);
-      return false;
-    }
-    else {
-      reverseCastlingMove(move);
-      return true;
-    }  
+    return !squareAttacked(move.originalColumn() + horizontalDirection,
+			   move.originalRow(), !coloursTurn);
   }
   
   return false;
@@ -653,6 +857,9 @@ bool ChessBoard::legalCastle(Move move) {
 
 void ChessBoard::castlingAdjustments(Move move) {
 
+  // castling details are taken out of the hash key and put back once adjusted.
+  key ^= castlingKey();
+
   // if a castling move occurs then set king activity as has moved.
   if (isCastling(move)) {
     if (coloursTurn == BLACK)
@@ -664,20 +871,674 @@ void ChessBoard::castlingAdjustments(Move move) {
   
   /* depending on original position, adjust if rooks have moved, 
      stored in chess board. */
-  if (move.originalColumn == 0 && move.originalRow == 0)
+  if (move.originalColumn() == 0 && move.originalRow() == 0)
     leftWhiteRookInactive = false;
-  if (move.originalColumn == 7 && move.originalRow == 0)
+  if (move.originalColumn() == 7 && move.originalRow() == 0)
     rightWhiteRookInactive = false;
-  if (move.originalColumn == 0 && move.originalRow == 7)
+  if (move.originalColumn() == 0 && move.originalRow() == 7)
     leftBlackRookInactive = false;
-  if (move.originalColumn == 7 && move.originalRow == 7)
+  if (move.originalColumn() == 7 && move.originalRow() == 7)
+    rightBlackRookInactive = false;
+
+  // a rook taken on its first square can no longer castle either.
+  if (move.targetColumn() == 0 && move.targetRow() == 0)
+    leftWhiteRookInactive = false;
+  if (move.targetColumn() == 7 && move.targetRow() == 0)
+    rightWhiteRookInactive = false;
+  if (move.targetColumn() == 0 && move.targetRow() == 7)
+    leftBlackRookInactive = false;
+  if (move.targetColumn() == 7 && move.targetRow() == 7)
     rightBlackRookInactive = false;
 
   // adjust kings positions if they have moved.
-  if (move.originalColumn == 4 && move.originalRow == 0)
+  if (move.originalColumn() == 4 && move.originalRow() == 0)
     whiteKingInactive = false;
-  if (move.originalColumn == 4 && move.originalRow == 7)
+  if (move.originalColumn() == 4 && move.originalRow() == 7)
     blackKingInactive = false;
+
+  key ^= castlingKey();
+}
+
+
+MoveList ChessBoard::legalMoves() {
+
+  INSTRUMENT_SCOPE(PROBE_LEGAL_MOVES);
+
+  MoveList moves;
+
+  // checks and pins are worked out once instead of trying every move.
+  LegalityMasks masks;
+  computeLegalityMasks(coloursTurn, masks);
+
+  // loop through each position on the board for pieces of who's turn it is.
+  for (int column = 0; column < 8; column++) {
+    for (int row = 0; row < 8; row++) {
+      Piece* piece = board[column][row];
+      if (piece == nullptr || piece->getPieceColour() != coloursTurn)
+	continue;
+
+      /* squares the piece could reach on an empty board and, for pieces
+	 other than the king, may end on without leaving it in check. a
+	 rook reaches its king along the row, so castles pass too. */
+      PieceType type = piece->getPieceType();
+      bool king = type == KING;
+      int origin = row*NUMBER_FILES + column;
+      uint64_t allowed = type == PAWN ? reach.pawn[coloursTurn][origin]
+	: reach.squares[type][origin];
+      if (!king)
+	allowed &= masks.checkMask;
+      if ((masks.pinned >> origin) & 1)
+	allowed &= masks.pinRays[origin];
+
+      /* for each piece attempt the moves left, as submitMove would, column
+	 by column like the pieces themselves. */
+      for (uint64_t targets = byColumn(allowed); targets;
+	   targets &= targets - 1) {
+	int targetColumn = __builtin_ctzll(targets) / 8;
+	int targetRow = __builtin_ctzll(targets) % 8;
+	Move move(column, row, targetColumn, targetRow);
+	const Piece* target = board[targetColumn][targetRow];
+
+	// pieces cannot take their own colour, castling onto the king aside.
+	if (target != nullptr && target->getPieceColour() == coloursTurn) {
+	  if (isCastling(move) && legalCastle(move))
+	    moves.push_back(Move(column, row, targetColumn, targetRow,
+				 CASTLING));
+	  continue;
+	}
+
+	// only king moves need an attack test, others are settled by masks.
+	if (king) {
+	  if (piece->isValid(move) && kingMoveSafe(move, coloursTurn))
+	    moves.push_back(move);
+	}
+	else if (piece->isValid(move))
+	  moves.push_back(move);
+      }
+    }
+  }
+  return moves;
+}
+
+
+uint64_t ChessBoard::legalTargets(int column, int row) {
+  listLegalTargets();
+  return legalTargetTable[row*NUMBER_FILES + column];
+}
+
+
+bool ChessBoard::hasLegalMove() {
+  listLegalTargets();
+  return anyLegalMove;
+}
+
+
+void ChessBoard::listLegalTargets() {
+
+  if (legalTargetsListed)
+    return;
+
+  for (uint64_t& targets : legalTargetTable)
+    targets = 0;
+  MoveList moves = legalMoves();
+  for (Move move : moves)
+    legalTargetTable[move.originalSquare()] |= 1ULL << move.targetSquare();
+  anyLegalMove = !moves.empty();
+  legalTargetsListed = true;
+}
+
+
+void ChessBoard::computeLegalityMasks(Colour colour,
+				      LegalityMasks& masks) const {
+
+  int kingColumn = colour == WHITE ? whiteKingColumn : blackKingColumn;
+  int kingRow = colour == WHITE ? whiteKingRow : blackKingRow;
+
+  masks.checkMask = 0;
+  masks.pinned = 0;
+  masks.checkers = 0;
+
+  // knights and the enemy king give check from fixed offsets.
+  const int knightColumns[8] = {1, 2, 2, 1, -1, -2, -2, -1};
+  const int knightRows[8] = {2, 1, -1, -2, -2, -1, 1, 2};
+  for (int i = 0; i < 8; i++) {
+    int column = kingColumn + knightColumns[i];
+    int row = kingRow + knightRows[i];
+    if (column < 0 || column > 7 || row < 0 || row > 7)
+      continue;
+    const Piece* piece = board[column][row];
+    if (piece != nullptr && piece->getPieceColour() != colour
+	&& piece->getPieceType() == KNIGHT) {
+      masks.checkers++;
+      masks.checkMask |= 1ULL << (row*8 + column);
+    }
+  }
+
+  // enemy pawns attack the king from one row ahead of it.
+  int pawnRow = kingRow + (colour == WHITE ? UP : DOWN);
+  for (int side = -1; side <= 1; side += 2) {
+    int column = kingColumn + side;
+    if (column < 0 || column > 7 || pawnRow < 0 || pawnRow > 7)
+      continue;
+    const Piece* piece = board[column][pawnRow];
+    if (piece != nullptr && piece->getPieceColour() != colour
+	&& piece->getPieceType() == PAWN) {
+      masks.checkers++;
+      masks.checkMask |= 1ULL << (pawnRow*8 + column);
+    }
+  }
+
+  /* walk each line out from the king. the first enemy piece able to move
+     along the line gives check if nothing is in the way, and pins the
+     piece in the way if exactly one piece of the king's colour is. */
+  for (int vertical = DOWN; vertical <= UP; vertical++) {
+    for (int horizontal = LEFT; horizontal <= RIGHT; horizontal++) {
+      if (vertical == NOT_VERTICAL && horizontal == NOT_HORIZONTAL)
+	continue;
+      bool diagonal = vertical != NOT_VERTICAL
+	&& horizontal != NOT_HORIZONTAL;
+
+      uint64_t ray = 0;
+      int blocker = -1;
+      int column = kingColumn + horizontal;
+      int row = kingRow + vertical;
+      bool adjacent = true;
+
+      while (column >= 0 && column < 8 && row >= 0 && row < 8) {
+	ray |= 1ULL << (row*8 + column);
+	const Piece* piece = board[column][row];
+	if (piece != nullptr) {
+	  if (piece->getPieceColour() == colour) {
+	    // a second piece of the king's colour means no pin on this line.
+	    if (blocker >= 0)
+	      break;
+	    blocker = row*8 + column;
+	  }
+	  else {
+	    PieceType type = piece->getPieceType();
+	    bool slides = type == QUEEN
+	      || (type == (diagonal ? BISHOP : ROOK));
+	    if (slides || (type == KING && adjacent && blocker < 0)) {
+	      if (blocker < 0) {
+		masks.checkers++;
+		masks.checkMask |= ray;
+	      }
+	      else if (slides) {
+		masks.pinned |= 1ULL << blocker;
+		masks.pinRays[blocker] = ray;
+	      }
+	    }
+	    break;
+	  }
+	}
+	column += horizontal;
+	row += vertical;
+	adjacent = false;
+      }
+    }
+  }
+
+  // out of check every position is allowed, in double check none are.
+  if (masks.checkers == 0)
+    masks.checkMask = ~0ULL;
+  else if (masks.checkers > 1)
+    masks.checkMask = 0;
+}
+
+
+bool ChessBoard::passesMasks(Move move, const LegalityMasks& masks) const {
+
+  int origin = move.originalRow()*8 + move.originalColumn();
+  uint64_t target = 1ULL << (move.targetRow()*8 + move.targetColumn());
+
+  // the move must deal with any check.
+  if (!(masks.checkMask & target))
+    return false;
+
+  // a pinned piece may only move along its pin.
+  if ((masks.pinned >> origin) & 1)
+    return (masks.pinRays[origin] & target) != 0;
+  return true;
+}
+
+
+bool ChessBoard::kingMoveSafe(Move move, Colour colour) {
+
+  // attack maps account for the king shielding the line behind it.
+  if (attackMap)
+    return !attackMap->kingMoveAttacked(move.originalSquare(),
+					move.targetSquare(), !colour);
+
+  Piece* king = board[move.originalColumn()][move.originalRow()];
+  board[move.originalColumn()][move.originalRow()] = nullptr;
+  bool safe = !squareAttacked(move.targetColumn(), move.targetRow(), !colour);
+  board[move.originalColumn()][move.originalRow()] = king;
+  return safe;
+}
+
+
+bool ChessBoard::squareAttacked(int column, int row, Colour attacker) const {
+
+  if (attackMap)
+    return attackMap->attackers(row*NUMBER_FILES + column)
+      & attackMap->pieces(attacker);
+
+  // knights attack from fixed offsets.
+  const int knightColumns[8] = {1, 2, 2, 1, -1, -2, -2, -1};
+  const int knightRows[8] = {2, 1, -1, -2, -2, -1, 1, 2};
+  for (int i = 0; i < 8; i++) {
+    int c = column + knightColumns[i];
+    int r = row + knightRows[i];
+    if (c < 0 || c > 7 || r < 0 || r > 7)
+      continue;
+    const Piece* piece = board[c][r];
+    if (piece != nullptr && piece->getPieceColour() == attacker
+	&& piece->getPieceType() == KNIGHT)
+      return true;
+  }
+
+  // pawns attack diagonally forward, so look one row behind their direction.
+  int pawnRow = row + (attacker == WHITE ? DOWN : UP);
+  for (int side = -1; side <= 1; side += 2) {
+    int c = column + side;
+    if (c < 0 || c > 7 || pawnRow < 0 || pawnRow > 7)
+      continue;
+    const Piece* piece = board[c][pawnRow];
+    if (piece != nullptr && piece->getPieceColour() == attacker
+	&& piece->getPieceType() == PAWN)
+      return true;
+  }
+
+  // sliding pieces and the king attack along lines.
+  for (int vertical = DOWN; vertical <= UP; vertical++) {
+    for (int horizontal = LEFT; horizontal <= RIGHT; horizontal++) {
+      if (vertical == NOT_VERTICAL && horizontal == NOT_HORIZONTAL)
+	continue;
+      bool diagonal = vertical != NOT_VERTICAL
+	&& horizontal != NOT_HORIZONTAL;
+
+      int c = column + horizontal;
+      int r = row + vertical;
+      bool adjacent = true;
+      while (c >= 0 && c < 8 && r >= 0 && r < 8) {
+	const Piece* piece = board[c][r];
+	if (piece != nullptr) {
+	  if (piece->getPieceColour() == attacker) {
+	    PieceType type = piece->getPieceType();
+	    if (type == QUEEN || type == (diagonal ? BISHOP : ROOK)
+		|| (type == KING && adjacent))
+	      return true;
+	  }
+	  break;
+	}
+	c += horizontal;
+	r += vertical;
+	adjacent = false;
+      }
+    }
+  }
+  return false;
+}
+
+
+void ChessBoard::doMove(Move move, MoveRecord& record) {
+
+  // store everything the move can change so it can be taken back.
+  record.move = move;
+  record.captured = board[move.targetColumn()][move.targetRow()];
+  record.kingMove = board[move.originalColumn()][move.originalRow()]
+    ->getPieceType() == KING;
+  record.castling = isCastling(move);
+  record.castlingRights[0] = blackKingInactive;
+  record.castlingRights[1] = whiteKingInactive;
+  record.castlingRights[2] = leftWhiteRookInactive;
+  record.castlingRights[3] = rightWhiteRookInactive;
+  record.castlingRights[4] = leftBlackRookInactive;
+  record.castlingRights[5] = rightBlackRookInactive;
+  record.key = key;
+  record.halfmoves = halfmoves;
+  record.reversiblePlies = reversiblePlies;
+
+  uint64_t previousCastling = castlingKey();
+  bool captureOrPawn = (record.captured != nullptr && !record.castling)
+    || board[move.originalColumn()][move.originalRow()]->getPieceType()
+    == PAWN;
+
+  if (record.castling)
+    makeCastlingMove(move);
+  else
+    makeMove(move);
+  castlingAdjustments(move);
+  changeTurn();
+  recordHistory(record.key, previousCastling, captureOrPawn);
+}
+
+
+void ChessBoard::undoMove(const MoveRecord& record) {
+
+  // turn goes back first, castling reversal depends on who's turn it is.
+  coloursTurn = !coloursTurn;
+  legalTargetsListed = false;
+
+  if (record.castling)
+    reverseCastlingMove(record.move);
+  else
+    reverseMove(record.move, record.captured, record.kingMove);
+
+  blackKingInactive = record.castlingRights[0];
+  whiteKingInactive = record.castlingRights[1];
+  leftWhiteRookInactive = record.castlingRights[2];
+  rightWhiteRookInactive = record.castlingRights[3];
+  leftBlackRookInactive = record.castlingRights[4];
+  rightBlackRookInactive = record.castlingRights[5];
+  key = record.key;
+
+  keyHistory.pop_back();
+  halfmoves = record.halfmoves;
+  reversiblePlies = record.reversiblePlies;
+}
+
+
+int ChessBoard::repetitionCount() const {
+
+  int count = 0;
+  int size = (int)keyHistory.size();
+  int limit = reversiblePlies < size ? reversiblePlies : size;
+
+  // positions with the same player to move are two moves apart.
+  for (int back = 2; back <= limit; back += 2)
+    if (keyHistory[size - back] == key)
+      count++;
+  return count;
+}
+
+
+int ChessBoard::halfmoveClock() const {
+  return halfmoves;
+}
+
+
+bool ChessBoard::drawnByRule() const {
+  return repetitionCount() >= 2 || halfmoves >= 100;
+}
+
+
+void ChessBoard::recordHistory(uint64_t previousKey, uint64_t previousCastling,
+			       bool captureOrPawn) {
+
+  keyHistory.push_back(previousKey);
+  halfmoves = captureOrPawn ? 0 : halfmoves + 1;
+
+  // nothing before a capture, pawn move or lost castle can come back.
+  if (captureOrPawn || castlingKey() != previousCastling)
+    reversiblePlies = 0;
+  else
+    reversiblePlies++;
+}
+
+
+Colour ChessBoard::sideToMove() const {
+  return coloursTurn;
+}
+
+
+uint64_t ChessBoard::positionKey() const {
+  return key;
+}
+
+
+uint64_t ChessBoard::pawnStructureKey() const {
+  return pawnKey;
+}
+
+
+const Piece* ChessBoard::pieceAt(int column, int row) const {
+  return board[column][row];
+}
+
+
+void ChessBoard::keepAttackMaps(bool keep) {
+
+  // the maps are filled in along with the hash keys.
+  if (keep && !attackMap) {
+    attackMap.reset(new AttackMap());
+    computeKey();
+  }
+  else if (!keep)
+    attackMap.reset();
+}
+
+
+bool ChessBoard::attackMapsKept() const {
+  return attackMap != nullptr;
+}
+
+
+uint64_t ChessBoard::attackersOf(int column, int row, Colour attacker) const {
+
+  int square = row*NUMBER_FILES + column;
+  if (attackMap)
+    return attackMap->attackers(square) & attackMap->pieces(attacker);
+
+  AttackMap scratch;
+  for (int c = 0; c < 8; c++)
+    for (int r = 0; r < 8; r++)
+      if (board[c][r] != nullptr)
+	scratch.toggle(r*NUMBER_FILES + c, board[c][r]->getPieceColour()*6
+		       + board[c][r]->getPieceType());
+  return scratch.attackers(square) & scratch.pieces(attacker);
+}
+
+
+void ChessBoard::changeTurn() {
+  coloursTurn = !coloursTurn;
+  key ^= zobrist.blackToMove;
+  legalTargetsListed = false;
+}
+
+
+void ChessBoard::computeKey() {
+
+  if (attackMap)
+    attackMap->clear();
+  legalTargetsListed = false;
+  key = 0;
+  occupancy = 0;
+  pawnKey = 0;
+  for (int column = 0; column < 8; column++)
+    for (int row = 0; row < 8; row++)
+      togglePiece(board[column][row], column, row);
+
+  key ^= castlingKey();
+  if (coloursTurn == BLACK)
+    key ^= zobrist.blackToMove;
+}
+
+
+uint64_t ChessBoard::castlingKey() const {
+
+  /* only the castling moves still possible count, so positions that differ
+     in details that no longer matter (the other rook moved) hash the same. */
+  uint64_t castling = 0;
+  if (whiteKingInactive && rightWhiteRookInactive)
+    castling ^= zobrist.castling[0];
+  if (whiteKingInactive && leftWhiteRookInactive)
+    castling ^= zobrist.castling[1];
+  if (blackKingInactive && rightBlackRookInactive)
+    castling ^= zobrist.castling[2];
+  if (blackKingInactive && leftBlackRookInactive)
+    castling ^= zobrist.castling[3];
+  return castling;
+}
+
+
+bool ChessBoard::setPosition(const string& fen) {
+
+  istringstream fields(fen);
+  string placement, side, castling, enPassant;
+  int halfmoveField = 0;
+  if (!(fields >> placement >> side))
+    return false;
+  if (!(fields >> castling))
+    castling = "-";
+  if (!(fields >> enPassant >> halfmoveField) || halfmoveField < 0)
+    halfmoveField = 0;
+  int fullmoveField = 1;
+  if (!(fields >> fullmoveField) || fullmoveField < 1)
+    fullmoveField = 1;
+
+  // pieces are read into a scratch board first so a bad fen changes nothing.
+  Piece* scratch[NUMBER_FILES][NUMBER_RANKS] = {};
+  int kings[2] = {0, 0};
+  int kingColumn[2] = {0, 0};
+  int kingRow[2] = {0, 0};
+  int column = 0;
+  int row = 7;
+
+  for (char symbol : placement) {
+    if (symbol == '/') {
+      if (column != 8 || row == 0)
+	return false;
+      column = 0;
+      row--;
+      continue;
+    }
+    if (symbol >= '1' && symbol <= '8') {
+      column += symbol - '0';
+      if (column > 8)
+	return false;
+      continue;
+    }
+
+    // piece letters in the order of PieceType, upper case for white.
+    const string letters = "prnbqk";
+    size_t type = letters.find(tolower(symbol));
+    if (type == string::npos || column > 7)
+      return false;
+    Colour colour = isupper(symbol) ? WHITE : BLACK;
+    scratch[column][row] = pieceObjects[colour*6 + type];
+    if (type == KING) {
+      kings[colour]++;
+      kingColumn[colour] = column;
+      kingRow[colour] = row;
+    }
+    column++;
+  }
+
+  if (row != 0 || column != 8 || kings[WHITE] != 1 || kings[BLACK] != 1)
+    return false;
+  if (side != "w" && side != "b")
+    return false;
+
+  for (int c = 0; c < 8; c++)
+    for (int r = 0; r < 8; r++)
+      board[c][r] = scratch[c][r];
+
+  whiteKingColumn = kingColumn[WHITE];
+  whiteKingRow = kingRow[WHITE];
+  blackKingColumn = kingColumn[BLACK];
+  blackKingRow = kingRow[BLACK];
+
+  // a castle is only allowed with its king and rook on their first squares.
+  auto atHome = [&](int column, int row, PieceType type) {
+    const Piece* piece = board[column][row];
+    return piece != nullptr && piece->getPieceType() == type
+      && piece->getPieceColour() == (row == 0 ? WHITE : BLACK);
+  };
+  bool whiteKingHome = atHome(4, 0, KING);
+  bool blackKingHome = atHome(4, 7, KING);
+  rightWhiteRookInactive = castling.find('K') != string::npos
+    && whiteKingHome && atHome(7, 0, ROOK);
+  leftWhiteRookInactive = castling.find('Q') != string::npos
+    && whiteKingHome && atHome(0, 0, ROOK);
+  rightBlackRookInactive = castling.find('k') != string::npos
+    && blackKingHome && atHome(7, 7, ROOK);
+  leftBlackRookInactive = castling.find('q') != string::npos
+    && blackKingHome && atHome(0, 7, ROOK);
+  whiteKingInactive = rightWhiteRookInactive || leftWhiteRookInactive;
+  blackKingInactive = rightBlackRookInactive || leftBlackRookInactive;
+
+  coloursTurn = side == "w" ? WHITE : BLACK;
+  computeKey();
+  keyHistory.clear();
+  halfmoves = halfmoveField;
+  reversiblePlies = 0;
+  firstPly = 2*(fullmoveField - 1) + (coloursTurn == BLACK);
+  return true;
+}
+
+
+string ChessBoard::positionFen() const {
+
+  const string letters = "PRNBQKprnbqk";
+  string fen;
+
+  for (int row = 7; row >= 0; row--) {
+    int empty = 0;
+    for (int column = 0; column < 8; column++) {
+      const Piece* piece = board[column][row];
+      if (piece == nullptr) {
+	empty++;
+	continue;
+      }
+      if (empty > 0)
+	fen += char('0' + empty);
+      empty = 0;
+      fen += letters[piece->getPieceColour()*6 + piece->getPieceType()];
+    }
+    if (empty > 0)
+      fen += char('0' + empty);
+    if (row > 0)
+      fen += '/';
+  }
+
+  fen += coloursTurn == WHITE ? " w " : " b ";
+
+  string castling;
+  int rights = castlingRights();
+  for (int castle = 0; castle < 4; castle++)
+    if (rights & 1 << castle)
+      castling += "KQkq"[castle];
+  fen += castling.empty() ? "-" : castling;
+
+  // every move played since the position was set up is in the history.
+  int fullmoves = (firstPly + (int)keyHistory.size()) / 2 + 1;
+  return fen + " - " + to_string(halfmoves) + " " + to_string(fullmoves);
+}
+
+int ChessBoard::castlingRights() const {
+  return (whiteKingInactive && rightWhiteRookInactive)
+    | (whiteKingInactive && leftWhiteRookInactive) << 1
+    | (blackKingInactive && rightBlackRookInactive) << 2
+    | (blackKingInactive && leftBlackRookInactive) << 3;
+}
+
+
+void ChessBoard::togglePiece(const Piece* piece, int column, int row) {
+
+  uint64_t pieceHash = pieceKey(piece, column, row);
+  key ^= pieceHash;
+
+  // pawns also make up the pawn structure key.
+  if (piece != nullptr && piece->getPieceType() == PAWN)
+    pawnKey ^= pieceHash;
+
+  if (piece != nullptr)
+    occupancy ^= 1ULL << (row*NUMBER_FILES + column);
+
+  if (attackMap && piece != nullptr)
+    attackMap->toggle(row*NUMBER_FILES + column,
+		      piece->getPieceColour()*6 + piece->getPieceType());
+}
+
+
+uint64_t ChessBoard::pieceKey(const Piece* piece, int column, int row) const {
+
+  // empty positions do not contribute to the key.
+  if (piece == nullptr)
+    return 0;
+  return zobrist.pieces[piece->getPieceColour()*6 + piece->getPieceType()]
+    [row*NUMBER_FILES + column];
 }
 
 
@@ -718,6 +1579,13 @@ void ChessBoard::printBoard() {
 */
 
 
+std::ostream& operator << (std::ostream& out, Move move) {
+  out << (char)('A' + move.originalColumn()) << (char)('1' + move.originalRow())
+      << (char)('A' + move.targetColumn()) << (char)('1' + move.targetRow());
+  return out;
+}
+
+
 std::ostream& operator << (std::ostream& out, Colour colour) {
   if (colour == BLACK)
     out << "Black";
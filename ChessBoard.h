@@ -1,9 +1,13 @@
 #ifndef CHESSBOARD_H
 #define CHESSBOARD_H
+#include "AttackMap.h"
 #include "piece.h"
 #include <iostream>
+#include <memory>
 #include "supplementary.h"
 #include <string>
+#include <vector>
+#include <cstdint>
 
 // forward declaration to avoid cyclical header file issue.
 class Piece;
@@ -14,6 +18,35 @@ using namespace std;
 const int NUMBER_RANKS = 8;
 const int NUMBER_FILES = 8;
 
+// position in Forsyth-Edwards Notation every game starts from.
+const char* const START_POSITION =
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+/* struct holding everything needed to take back a move made with doMove. */
+struct MoveRecord {
+  Move move;
+  Piece* captured;
+  bool kingMove;
+  bool castling;
+  bool castlingRights[6];
+  uint64_t key;
+  int halfmoves;
+  int reversiblePlies;
+};
+
+/* struct holding what the legality of moves in a position depends on,
+   worked out once so moves can be checked without being tried. */
+struct LegalityMasks {
+  // positions a piece other than the king may move to, given any check.
+  uint64_t checkMask;
+  // positions of pieces pinned against their king.
+  uint64_t pinned;
+  // for each pinned piece, the positions along its pin it may move to.
+  uint64_t pinRays[NUMBER_RANKS*NUMBER_FILES];
+  // number of pieces giving check.
+  int checkers;
+};
+
 class ChessBoard{
 
 public:
@@ -22,6 +55,15 @@ public:
      and pointers to those pieces. */
   ChessBoard();
 
+  /* constructor for the chess board used by tools that run many boards,
+     e.g. one per thread.
+     @param announce is whether to print that a new game has started. */
+  explicit ChessBoard(bool announce);
+
+  /* boards own the piece objects bound to them, so cannot be copied. */
+  ChessBoard(const ChessBoard&) = delete;
+  ChessBoard& operator=(const ChessBoard&) = delete;
+
   /* destructor for the chess board */
   ~ChessBoard();
 
@@ -44,14 +86,10 @@ public:
   bool pawnKill(Move move, VerticalDirection verticalDirection) const;
 
   /* function that checks if the positions between the position of piece
-     that wants to move and the target position are empty.
-      @param move holds the column and row values of original and target positions.
-      @param verticalDirection determines whether the piece is
-       moving up or down on the board.
-      @param horizontalDirection determines whether the piece is 
-       moving left or right on the board. */
-  bool pathEmpty(Move move, VerticalDirection verticalDirection,
-		 HorizontalDirection horizontalDirection) const;
+     that wants to move and the target position are empty. the positions
+     must share a row, column or diagonal.
+      @param move holds the column and row values of original and target positions. */
+  bool pathEmpty(Move move) const;
 
   /* function that puts all the chess pieces to their original positions on the board
      and sets up all the original board information. */
@@ -66,6 +104,108 @@ public:
   
   void printBoard();
 
+  /* function that determines whether the player who's colour
+     is passed in is in check.
+     @param colour is the colour for which player
+      you wish to determine is in check. */
+  bool inCheck(Colour colour);
+
+  /* function that determines whether the player who's colour
+     is passed in is in checkmate.
+     @param colour is the colour for which player
+     you wish to determine is in checkmate. */
+  bool inCheckMate(Colour colour);
+
+  /* function that lists every move the player to move can make,
+     including castling, in a fixed board order. */
+  MoveList legalMoves();
+
+  /* getter function for the positions the piece in a position may legally
+     move to, as bits row*8+column, a castle being the rook moving onto its
+     king. the legal moves of a position are listed the first time they
+     are asked for and kept until the position changes, so checking
+     further moves in the same position costs a bit test.
+     @param column and row are the position of the piece. */
+  uint64_t legalTargets(int column, int row);
+
+  /* function that determines whether the player to move has any legal
+     move, answered from the same list as legalTargets. */
+  bool hasLegalMove();
+
+  /* function that silently makes a legal move, including castling, and
+     hands the turn to the other player. Used by the search.
+     @param move hold the column and row values of original 
+     and target positions.
+     @param record is filled with what undoMove needs to take the move back. */
+  void doMove(Move move, MoveRecord& record);
+
+  /* function that takes back a move made with doMove.
+     @param record is the record filled in when the move was made. */
+  void undoMove(const MoveRecord& record);
+
+  /* function that returns how many times the current position occurred
+     earlier in the game, looking back only as far as the last move that
+     cannot be undone (capture, pawn move or loss of a castle). */
+  int repetitionCount() const;
+
+  /* getter function for the number of moves by either player since the
+     last capture or pawn move. */
+  int halfmoveClock() const;
+
+  /* function that determines whether the game is drawn by threefold
+     repetition or the fifty-move rule. */
+  bool drawnByRule() const;
+
+  /* getter function for the colour of who's turn it is. */
+  Colour sideToMove() const;
+
+  /* getter function for the zobrist hash key of the current position,
+     covering pieces, castling details and who's turn it is. */
+  uint64_t positionKey() const;
+
+  /* getter function for the zobrist hash key of the pawns alone, used to
+     cache pawn structure evaluation. */
+  uint64_t pawnStructureKey() const;
+
+  /* function that sets up the board from a position in Forsyth-Edwards
+     Notation without printing anything. en passant is not part of these
+     rules, so that field is ignored, and castles whose king or rook is
+     not on its first square are dropped.
+     @param fen is the position to set up.
+     returns false, leaving the board untouched, if fen is malformed. */
+  bool setPosition(const string& fen);
+
+  /* function that returns the current position in Forsyth-Edwards Notation. */
+  string positionFen() const;
+
+  /* getter function for the castles still allowed by the moves so far, as
+     bits in the order of Forsyth-Edwards Notation: 1 for white on the
+     king's side, 2 for white on the queen's side, 4 and 8 for black. */
+  int castlingRights() const;
+
+  /* getter function for the piece in a position, nullptr if empty.
+     @param column and row are the position on the board. */
+  const Piece* pieceAt(int column, int row) const;
+
+  /* function that starts or stops keeping, move by move, which pieces
+     attack each position. with the maps kept, whether a player is in
+     check or a position is attacked is looked up rather than worked out,
+     at the cost of updating the maps on every move, which suits programs
+     that ask such questions more often than they search.
+     @param keep is whether to keep the maps. */
+  void keepAttackMaps(bool keep);
+
+  /* getter function for whether attack maps are kept. */
+  bool attackMapsKept() const;
+
+  /* function that returns the positions of the pieces of a colour that
+     attack a position, as bits row*8+column, e.g. for exchanges or the
+     safety of a king. looked up if attack maps are kept, worked out from
+     scratch otherwise.
+     @param column and row are the position on the board.
+     @param attacker is the colour of the attacking pieces. */
+  uint64_t attackersOf(int column, int row, Colour attacker) const;
+
   
   
 
@@ -92,21 +232,11 @@ private:
      checking if it is the correct players turn, if a piece actually 
      exists in original position etc.
      @param originalPosition holds location of piece that player wants to move.
-     @param move hold the column and row values of original 
+     @param targetPosition holds location player wants to move the piece to.
+     @param move is filled with the column and row values of original 
       and target positions. */
-  bool preliminaryChecks(const char originalPosition[], Move move);
-
-  /* function that determines whether the player who's colour
-     is passed in is in check.
-     @param colour is the colour for which player
-      you wish to determine is in check. */
-  bool inCheck(Colour colour);
-
-  /* function that determines whether the player who's colour
-     is passed in is in checkmate.
-     @param colour is the colour for which player
-     you wish to determine is in checkmate. */
-  bool inCheckMate(Colour colour);
+  bool preliminaryChecks(const char originalPosition[],
+			 const char targetPosition[], Move& move);
 
   /* function that makes a move on the chess board.
      @param move hold the column and row values of original 
@@ -153,6 +283,37 @@ private:
      and target positions. */
   void makeCastlingMove(Move move);
 
+  /* function that works out which pieces give check to and which are pinned
+     against the king of a colour.
+     @param colour is the colour of the king.
+     @param masks is filled with the check mask and pins. */
+  void computeLegalityMasks(Colour colour, LegalityMasks& masks) const;
+
+  /* function that checks whether a move of a piece other than the king
+     passes the check and pin masks. the move must already be valid for
+     the piece and not take a piece of its own colour.
+     @param move hold the column and row values of original 
+     and target positions.
+     @param masks are the legality masks of the moving colour. */
+  bool passesMasks(Move move, const LegalityMasks& masks) const;
+
+  /* function that checks whether a king move leaves the king attacked. the
+     king is lifted off the board meanwhile so it cannot hide behind itself.
+     @param move hold the column and row values of original 
+     and target positions.
+     @param colour is the colour of the king. */
+  bool kingMoveSafe(Move move, Colour colour);
+
+  /* function that determines whether a position is attacked by any piece
+     of a colour, looking outwards from the position.
+     @param column and row are the position on the board.
+     @param attacker is the colour of the attacking pieces. */
+  bool squareAttacked(int column, int row, Colour attacker) const;
+
+  /* function that lists the legal moves of the current position by the
+     position they start from, unless they are listed already. */
+  void listLegalTargets();
+
   /* function that reverses castling move and adjust board details accordingly.
      @param move hold the column and row values of original 
      and target positions. */
@@ -171,9 +332,70 @@ private:
   bool rightWhiteRookInactive = true;
   bool leftBlackRookInactive = true;
   bool rightBlackRookInactive = true;
-  
- 
-  
+
+  /* function that adds the position before a move to the history and
+     updates the move counters, once the move has been made.
+     @param previousKey is the hash key before the move.
+     @param previousCastling is the castling part of the key before the move.
+     @param captureOrPawn is whether the move took a piece or moved a pawn. */
+  void recordHistory(uint64_t previousKey, uint64_t previousCastling,
+		     bool captureOrPawn);
+
+  /* function that hands the turn to the other player,
+     adjusting the hash key. */
+  void changeTurn();
+
+  /* function that calculates the hash key and occupancy of the board,
+     and the attack maps if kept, from scratch. */
+  void computeKey();
+
+  /* function that returns the part of the hash key
+     made up by the castling details. */
+  uint64_t castlingKey() const;
+
+  /* function that adds or removes a piece standing in a position
+     from the hash keys, the occupancy and any attack maps.
+     @param piece is the piece in the position, nothing happens if nullptr.
+     @param column and row are the position on the board. */
+  void togglePiece(const Piece* piece, int column, int row);
+
+  /* function that returns the hash key of a piece standing in a position.
+     @param piece is the piece in the position.
+     @param column and row are the position on the board. */
+  uint64_t pieceKey(const Piece* piece, int column, int row) const;
+
+  // zobrist hash key of the current position.
+  uint64_t key = 0;
+
+  // bit row*8+column is set for each occupied position.
+  uint64_t occupancy = 0;
+
+  // zobrist hash key of the pawns in the current position.
+  uint64_t pawnKey = 0;
+
+  // hash keys of the positions earlier in the game, oldest first.
+  vector<uint64_t> keyHistory;
+
+  // moves since the last capture or pawn move, for the fifty-move rule.
+  int halfmoves = 0;
+
+  // moves since the last move that cannot be undone, bounding repetitions.
+  int reversiblePlies = 0;
+
+  // plies of the game before the position the board was set up from.
+  int firstPly = 0;
+
+  // for each position, the positions its piece may legally move to.
+  uint64_t legalTargetTable[NUMBER_RANKS*NUMBER_FILES];
+
+  // whether legalTargetTable holds the moves of the current position.
+  bool legalTargetsListed = false;
+
+  // whether the current position has any legal move, once listed.
+  bool anyLegalMove = false;
+
+  // attackers of every position, nullptr unless attack maps are kept.
+  unique_ptr<AttackMap> attackMap;
 };
 
 #endif
@@ -0,0 +1,263 @@
+#include "ChessBoard.h"
+#include "Search.h"
+#include "TrainingData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* plays games of shallow searches against themselves from random openings
+   on every core and writes the positions, labelled with the score of the
+   search and the result of the game, to a file of packed positions.
+   positions in check or whose best move is a capture are left out, as a
+   static evaluation cannot be expected to score them.
+
+   usage: datagen --output FILE [--threads N] [--games N] [--positions N]
+                  [--depth N] [--nodes N] [--random-plies N]
+                  [--maxplies N] [--hash MB] [--seed N]
+          datagen --dump FILE [--count N]
+
+   the search is limited to 5000 nodes a move unless told otherwise, and
+   openings are at most 40 random plies. */
+
+namespace {
+
+// a game is won once the search has seen a score this large for one side
+// on this many moves in a row.
+const int ADJUDICATION_SCORE = 2000;
+const int ADJUDICATION_PLIES = 8;
+
+// struct holding the options given on the command line.
+struct DatagenOptions {
+  string output;
+  int threads = max(1u, thread::hardware_concurrency());
+  uint64_t games = 0;
+  uint64_t positions = 0;
+  int depth = 0;
+  uint64_t nodes = 5000;
+  int randomPlies = 8;
+  int maxPlies = 400;
+  int hashMegabytes = 16;
+  uint64_t seed = chrono::steady_clock::now().time_since_epoch().count();
+};
+
+/* function that plays random moves from the starting position.
+   @param board is set to the opening.
+   @param random is the generator choosing the moves.
+   @param plies is the number of moves to play.
+   returns false if the game ends during or right after the opening. */
+bool randomOpening(ChessBoard& board, mt19937_64& random, int plies) {
+  board.setPosition(START_POSITION);
+  MoveRecord record;
+  for (int ply = 0; ply <= plies; ply++) {
+    MoveList moves = board.legalMoves();
+    if (moves.empty() || board.drawnByRule())
+      return false;
+    if (ply < plies)
+      board.doMove(moves[random() % moves.size()], record);
+  }
+  return true;
+}
+
+// result of a game won by the given colour.
+GameResult winFor(Colour colour) {
+  return colour == WHITE ? WHITE_WINS : BLACK_WINS;
+}
+
+/* function that plays a game from the position on the board.
+   @param board holds the opening and ends at the last position.
+   @param search is the search playing both sides.
+   @param options holds the limits of the search and the game.
+   @param positions is filled with the positions worth learning from. */
+GameResult playGame(ChessBoard& board, Search& search,
+		    const DatagenOptions& options,
+		    vector<PackedPosition>& positions) {
+
+  SearchLimits limits;
+  limits.depth = options.depth;
+  limits.nodes = options.nodes;
+  MoveRecord record;
+  int decisive = 0;
+
+  for (int ply = options.randomPlies; ; ply++) {
+    Colour colour = board.sideToMove();
+    if (board.inCheckMate(colour))
+      return board.inCheck(colour) ? winFor(!colour) : DRAWN;
+    if (board.drawnByRule() || ply >= options.maxPlies)
+      return DRAWN;
+
+    SearchResult found = search.think(board, limits);
+    if (found.bestMove == NO_MOVE)
+      return DRAWN;
+
+    decisive = abs(found.score) >= ADJUDICATION_SCORE ? decisive + 1 : 0;
+    if (decisive >= ADJUDICATION_PLIES)
+      return winFor(found.score > 0 ? colour : !colour);
+
+    Move move = found.bestMove;
+    bool quiet = move.flag() == CASTLING
+      || board.pieceAt(move.targetColumn(), move.targetRow()) == nullptr;
+    if (quiet && !board.inCheck(colour)
+	&& abs(found.score) < MATE_SCORE - MAX_PLY) {
+      positions.emplace_back();
+      packPosition(board, found.score, ply, positions.back());
+    }
+    board.doMove(move, record);
+  }
+}
+
+/* function that prints the positions of a file of training data.
+   @param file is the name of the file.
+   @param count is the most positions to print. */
+int dump(const string& file, uint64_t count) {
+  ifstream in(file, ios::binary);
+  if (!in) {
+    cerr << "datagen: cannot read " << file << endl;
+    return 1;
+  }
+  const char* results[3] = {"1-0", "0-1", "1/2-1/2"};
+  PackedPosition position;
+  for (uint64_t i = 0; i < count
+	 && in.read((char*)&position, sizeof(position)); i++)
+    cout << packedPositionFen(position) << " | " << position.score << " | "
+	 << results[position.result % 3] << endl;
+  return 0;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  DatagenOptions options;
+  string dumpFile;
+  uint64_t dumpCount = UINT64_MAX;
+  bool valid = true;
+
+  for (int i = 1; i < argc && valid; i++) {
+    bool hasValue = i + 1 < argc;
+    string option = argv[i];
+    if (option == "--output" && hasValue)
+      options.output = argv[++i];
+    else if (option == "--threads" && hasValue)
+      options.threads = max(1, atoi(argv[++i]));
+    else if (option == "--games" && hasValue)
+      options.games = strtoull(argv[++i], nullptr, 10);
+    else if (option == "--positions" && hasValue)
+      options.positions = strtoull(argv[++i], nullptr, 10);
+    else if (option == "--depth" && hasValue)
+      options.depth = max(0, atoi(argv[++i]));
+    else if (option == "--nodes" && hasValue)
+      options.nodes = strtoull(argv[++i], nullptr, 10);
+    else if (option == "--random-plies" && hasValue)
+      options.randomPlies = min(max(0, atoi(argv[++i])), 40);
+    else if (option == "--maxplies" && hasValue)
+      options.maxPlies = max(1, atoi(argv[++i]));
+    else if (option == "--hash" && hasValue)
+      options.hashMegabytes = max(1, atoi(argv[++i]));
+    else if (option == "--seed" && hasValue)
+      options.seed = strtoull(argv[++i], nullptr, 10);
+    else if (option == "--dump" && hasValue)
+      dumpFile = argv[++i];
+    else if (option == "--count" && hasValue)
+      dumpCount = strtoull(argv[++i], nullptr, 10);
+    else
+      valid = false;
+  }
+
+  if (valid && !dumpFile.empty())
+    return dump(dumpFile, dumpCount);
+
+  if (!valid || options.output.empty()
+      || (options.depth == 0 && options.nodes == 0)) {
+    cerr << "usage: datagen --output FILE [--threads N] [--games N]"
+	 << " [--positions N] [--depth N] [--nodes N] [--random-plies N]"
+	 << " [--maxplies N] [--hash MB] [--seed N]" << endl
+	 << "       datagen --dump FILE [--count N]" << endl;
+    return 1;
+  }
+
+  TrainingFile file;
+  if (!file.open(options.output)) {
+    cerr << "datagen: cannot write " << options.output << endl;
+    return 1;
+  }
+
+  atomic<uint64_t> gamesStarted(0);
+  atomic<uint64_t> gamesPlayed(0);
+  atomic<uint64_t> positionsKept(0);
+  atomic<int> running(options.threads);
+  atomic<bool> failed(false);
+
+  auto work = [&](int index) {
+    ChessBoard board(false);
+    Search search(options.hashMegabytes);
+    TrainingWriter writer(file);
+    mt19937_64 random(options.seed + index);
+    vector<PackedPosition> positions;
+
+    while (!failed
+	   && (options.games == 0 || gamesStarted++ < options.games)
+	   && (options.positions == 0
+	       || positionsKept < options.positions)) {
+      // openings short enough never run into the fifty-move rule, and
+      // mates or stalemates among them are rare, so retrying terminates.
+      while (!randomOpening(board, random, options.randomPlies))
+	;
+      search.clearHash();
+      positions.clear();
+      GameResult result = playGame(board, search, options, positions);
+
+      // the result is only known now, so the game is written in one go.
+      for (PackedPosition& position : positions) {
+	position.result = result;
+	if (!writer.add(position))
+	  failed = true;
+      }
+      positionsKept += positions.size();
+      gamesPlayed++;
+    }
+    if (!writer.flush())
+      failed = true;
+    running--;
+  };
+
+  auto start = chrono::steady_clock::now();
+  vector<thread> workers;
+  for (int i = 0; i < options.threads; i++)
+    workers.emplace_back(work, i);
+
+  // reports progress every ten seconds until the workers are done.
+  auto report = [&]() {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()
+					      - start).count();
+    cout << "Games " << gamesPlayed << ", positions " << positionsKept
+	 << ", " << fixed << setprecision(0)
+	 << positionsKept / max(seconds, 1e-9) << " positions/s" << endl;
+  };
+  for (int tick = 1; running > 0; tick++) {
+    this_thread::sleep_for(chrono::milliseconds(100));
+    if (tick % 100 == 0)
+      report();
+  }
+  for (thread& worker : workers)
+    worker.join();
+
+  report();
+  if (failed) {
+    cerr << "datagen: cannot write " << options.output << endl;
+    return 1;
+  }
+  return 0;
+}
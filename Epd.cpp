@@ -0,0 +1,145 @@
+#include "Epd.h"
+#include "piece.h"
+#include <cctype>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+const char PIECE_LETTERS[] = {'P', 'R', 'N', 'B', 'Q', 'K'};
+
+// castling is made by moving the rook onto the king.
+bool isCastlingMove(ChessBoard& board, Move move) {
+  const Piece* rook = board.pieceAt(move.originalColumn(), move.originalRow());
+  const Piece* king = board.pieceAt(move.targetColumn(), move.targetRow());
+  return rook != nullptr && king != nullptr
+    && rook->getPieceType() == ROOK && king->getPieceType() == KING
+    && rook->getPieceColour() == king->getPieceColour();
+}
+
+// move text without annotations and with castling written with letters.
+string normalise(const string& text) {
+  string result;
+  for (char symbol : text) {
+    if (symbol == '+' || symbol == '#' || symbol == '!' || symbol == '?')
+      continue;
+    result += symbol == '0' ? 'O' : symbol;
+  }
+  return result;
+}
+
+string trim(const string& text) {
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == string::npos)
+    return "";
+  size_t last = text.find_last_not_of(" \t\r\n");
+  return text.substr(first, last - first + 1);
+}
+
+}
+
+
+bool parseEpd(const string& line, EpdRecord& record) {
+
+  record = EpdRecord();
+  istringstream fields(line);
+  string placement, side, castling, enPassant;
+  if (!(fields >> placement >> side >> castling >> enPassant))
+    return false;
+  record.fen = placement + " " + side + " " + castling + " " + enPassant
+    + " 0 1";
+
+  string operations;
+  getline(fields, operations);
+  istringstream list(operations);
+  string operation;
+  while (getline(list, operation, ';')) {
+    istringstream words(trim(operation));
+    string opcode, operand;
+    if (!(words >> opcode))
+      continue;
+    if (opcode == "id") {
+      getline(words, operand);
+      operand = trim(operand);
+      if (operand.size() >= 2 && operand.front() == '"'
+	  && operand.back() == '"')
+	operand = operand.substr(1, operand.size() - 2);
+      record.id = operand;
+    }
+    else if (opcode == "bm")
+      while (words >> operand)
+	record.bestMoves.push_back(operand);
+    else if (opcode == "am")
+      while (words >> operand)
+	record.avoidMoves.push_back(operand);
+    else if (opcode == "dm")
+      words >> record.directMate;
+  }
+  return true;
+}
+
+
+string moveSan(ChessBoard& board, Move move) {
+
+  if (isCastlingMove(board, move))
+    return move.originalColumn() > move.targetColumn() ? "O-O" : "O-O-O";
+
+  const Piece* piece = board.pieceAt(move.originalColumn(), move.originalRow());
+  bool capture = board.pieceAt(move.targetColumn(), move.targetRow())
+    != nullptr;
+  string san;
+
+  if (piece->getPieceType() == PAWN) {
+    if (capture)
+      san += (char)('a' + move.originalColumn());
+  }
+  else {
+    san += PIECE_LETTERS[piece->getPieceType()];
+
+    // name the file, rank or both if another piece of the type can go there.
+    bool ambiguous = false, sameColumn = false, sameRow = false;
+    for (Move other : board.legalMoves()) {
+      if (other.targetColumn() != move.targetColumn()
+	  || other.targetRow() != move.targetRow() || other == move)
+	continue;
+      const Piece* rival = board.pieceAt(other.originalColumn(),
+					 other.originalRow());
+      if (rival->getPieceType() != piece->getPieceType()
+	  || isCastlingMove(board, other))
+	continue;
+      ambiguous = true;
+      sameColumn = sameColumn
+	|| other.originalColumn() == move.originalColumn();
+      sameRow = sameRow || other.originalRow() == move.originalRow();
+    }
+    if (ambiguous && (!sameColumn || sameRow))
+      san += (char)('a' + move.originalColumn());
+    if (ambiguous && sameColumn)
+      san += (char)('1' + move.originalRow());
+  }
+
+  if (capture)
+    san += 'x';
+  san += (char)('a' + move.targetColumn());
+  san += (char)('1' + move.targetRow());
+  return san;
+}
+
+
+bool parseMove(ChessBoard& board, const string& text, Move& move) {
+
+  string wanted = normalise(text);
+  for (Move legal : board.legalMoves()) {
+    ostringstream coordinates;
+    coordinates << legal;
+    string lower = coordinates.str();
+    for (char& symbol : lower)
+      symbol = tolower(symbol);
+    if (moveSan(board, legal) == wanted || lower == wanted) {
+      move = legal;
+      return true;
+    }
+  }
+  return false;
+}
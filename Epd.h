@@ -0,0 +1,37 @@
+#ifndef EPD_H
+#define EPD_H
+#include "ChessBoard.h"
+#include <string>
+#include <vector>
+
+// struct holding one position of a test suite and what should be played.
+struct EpdRecord {
+  std::string id;
+  std::string fen;
+  std::vector<std::string> bestMoves;
+  std::vector<std::string> avoidMoves;
+  // moves to the mate the side to move has, 0 if not given.
+  int directMate = 0;
+};
+
+/* function that reads one line of extended position description: the
+   four position fields followed by operations separated by semicolons,
+   of which id, bm, am and dm are kept.
+   @param line is the line to read.
+   @param record is filled with the position and operations. */
+bool parseEpd(const std::string& line, EpdRecord& record);
+
+/* function that writes a legal move in standard algebraic notation,
+   without check or mate marks.
+   @param board is the chess board holding the position.
+   @param move is the move to write. */
+std::string moveSan(ChessBoard& board, Move move);
+
+/* function that finds the legal move written in standard algebraic or
+   coordinate notation.
+   @param board is the chess board holding the position.
+   @param text is the move, e.g. Nf3, exd5, O-O or e2e4.
+   @param move is filled with the move if it is legal. */
+bool parseMove(ChessBoard& board, const std::string& text, Move& move);
+
+#endif
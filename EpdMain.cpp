@@ -0,0 +1,279 @@
+#include "ChessBoard.h"
+#include "Epd.h"
+#include "Search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* runs a test suite of positions with best (bm) or avoid (am) moves and
+   reports which are solved, and how long and how many nodes the search
+   took to settle on a correct move. positions are searched several at a
+   time, each by its own search.
+
+   usage: epd FILE [--movetime MS] [--nodes N] [--depth N] [--threads N]
+                   [--hash MB] [--evalcache KB] [--trace FILE]
+
+   with --trace, a build made with INSTRUMENT=1 records every node
+   searched into FILE for tracestat. */
+
+namespace {
+
+// struct holding the options given on the command line.
+struct EpdOptions {
+  string file;
+  SearchLimits limits;
+  int threads = max(1u, thread::hardware_concurrency());
+  int hashMegabytes = 16;
+  // size of the evaluation cache of each search, none to switch it off.
+  int evalKilobytes = 512;
+  string trace;
+};
+
+// struct holding the outcome of one position.
+struct EpdOutcome {
+  bool valid = false;
+  bool solved = false;
+  string played;
+  // when the search last switched to a correct move, -1 if it did not.
+  int solveTime = -1;
+  uint64_t solveNodes = 0;
+  int elapsed = 0;
+  uint64_t nodes = 0;
+  uint64_t evalProbes = 0;
+  uint64_t evalHits = 0;
+};
+
+// struct holding the moves of a record resolved on its board.
+struct EpdTargets {
+  vector<Move> best;
+  vector<Move> avoid;
+
+  bool correct(Move move) const {
+    if (!best.empty() && find(best.begin(), best.end(), move) == best.end())
+      return false;
+    return find(avoid.begin(), avoid.end(), move) == avoid.end();
+  }
+};
+
+/* function that searches one position, watching the best move as the
+   search deepens to find when it became and stayed correct. */
+EpdOutcome runPosition(Search& search, const EpdRecord& record,
+		       const SearchLimits& limits) {
+
+  EpdOutcome outcome;
+  ChessBoard board(false);
+  if (!board.setPosition(record.fen))
+    return outcome;
+
+  EpdTargets targets;
+  for (const string& text : record.bestMoves) {
+    Move move;
+    if (!parseMove(board, text, move))
+      return outcome;
+    targets.best.push_back(move);
+  }
+  for (const string& text : record.avoidMoves) {
+    Move move;
+    if (!parseMove(board, text, move))
+      return outcome;
+    targets.avoid.push_back(move);
+  }
+  if (targets.best.empty() && targets.avoid.empty())
+    return outcome;
+  outcome.valid = true;
+
+  search.clearHash();
+  search.start(board, limits);
+
+  Move lastMove = NO_MOVE;
+  auto track = [&](const SearchStatistics& statistics) {
+    if (statistics.bestMove == lastMove)
+      return;
+    lastMove = statistics.bestMove;
+    if (targets.correct(lastMove)) {
+      outcome.solveTime = statistics.elapsed;
+      outcome.solveNodes = statistics.nodes;
+    }
+    else
+      outcome.solveTime = -1;
+  };
+
+  while (true) {
+    SearchStatistics statistics = search.statistics();
+    if (!statistics.searching)
+      break;
+    if (!(statistics.bestMove == NO_MOVE))
+      track(statistics);
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+  SearchResult result = search.wait();
+  SearchStatistics statistics = search.statistics();
+  statistics.bestMove = result.bestMove;
+  track(statistics);
+
+  // the board is only read once the search has finished with it.
+  outcome.played = result.bestMove == NO_MOVE ? "none"
+    : moveSan(board, result.bestMove);
+  outcome.solved = targets.correct(result.bestMove);
+  outcome.elapsed = statistics.elapsed;
+  outcome.nodes = statistics.nodes;
+  outcome.evalProbes = statistics.evalProbes;
+  outcome.evalHits = statistics.evalHits;
+  if (!outcome.solved)
+    outcome.solveTime = -1;
+  return outcome;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  EpdOptions options;
+  bool valid = argc > 1;
+  for (int i = 1; i < argc && valid; i++) {
+    if (!strcmp(argv[i], "--movetime") && i + 1 < argc)
+      options.limits.moveTime = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--nodes") && i + 1 < argc)
+      options.limits.nodes = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--depth") && i + 1 < argc)
+      options.limits.depth = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      options.hashMegabytes = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--evalcache") && i + 1 < argc)
+      options.evalKilobytes = min(max(0, atoi(argv[++i])), 65536);
+    else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+      options.trace = argv[++i];
+    else if (argv[i][0] != '-' && options.file.empty())
+      options.file = argv[i];
+    else
+      valid = false;
+  }
+  if (!valid || options.file.empty()) {
+    cerr << "usage: epd FILE [--movetime MS] [--nodes N] [--depth N]"
+	 << " [--threads N] [--hash MB] [--evalcache KB] [--trace FILE]"
+	 << endl;
+    return 1;
+  }
+
+  // a fixed time is used unless the search is limited some other way.
+  if (options.limits.nodes == 0 && options.limits.depth == 0
+      && options.limits.moveTime == 0)
+    options.limits.moveTime = 1000;
+
+  ifstream in(options.file);
+  if (!in) {
+    cerr << "epd: cannot read " << options.file << endl;
+    return 1;
+  }
+  vector<EpdRecord> records;
+  string line;
+  while (getline(in, line)) {
+    EpdRecord record;
+    if (line.empty() || line[0] == '#' || !parseEpd(line, record))
+      continue;
+    if (record.id.empty())
+      record.id = to_string(records.size() + 1);
+    records.push_back(record);
+  }
+
+  TraceFile traceFile;
+  if (!options.trace.empty()) {
+#ifndef CHESS_INSTRUMENT
+    cerr << "epd: tracing needs a build made with INSTRUMENT=1" << endl;
+    return 1;
+#endif
+    if (!traceFile.open(options.trace)) {
+      cerr << "epd: cannot write " << options.trace << endl;
+      return 1;
+    }
+  }
+
+  vector<EpdOutcome> outcomes(records.size());
+  atomic<size_t> nextRecord(0);
+  mutex outputLock;
+
+  auto work = [&]() {
+    Search search(options.hashMegabytes);
+    search.resizeEvalCache(options.evalKilobytes * 1024 / EVAL_ENTRY_BYTES);
+    if (!options.trace.empty())
+      search.setTrace(&traceFile);
+    for (size_t i = nextRecord++; i < records.size(); i = nextRecord++) {
+      outcomes[i] = runPosition(search, records[i], options.limits);
+
+      const EpdRecord& record = records[i];
+      const EpdOutcome& outcome = outcomes[i];
+      lock_guard<mutex> lock(outputLock);
+      cout << left << setw(16) << record.id << right;
+      if (!outcome.valid) {
+	cout << " skipped, position or moves not understood" << endl;
+	continue;
+      }
+      cout << (outcome.solved ? " solved " : " failed ") << setw(7)
+	   << outcome.played << "  expected";
+      for (const string& move : record.bestMoves)
+	cout << " bm " << move;
+      for (const string& move : record.avoidMoves)
+	cout << " am " << move;
+      if (outcome.solved)
+	cout << "  time " << outcome.solveTime << " ms nodes "
+	     << outcome.solveNodes;
+      cout << endl;
+    }
+  };
+
+  vector<thread> workers;
+  for (int i = 0; i < options.threads; i++)
+    workers.emplace_back(work);
+  for (thread& worker : workers)
+    worker.join();
+
+  int counted = 0, solved = 0;
+  uint64_t solveTime = 0, solveNodes = 0, nodes = 0, elapsed = 0;
+  uint64_t evalProbes = 0, evalHits = 0;
+  for (const EpdOutcome& outcome : outcomes) {
+    if (!outcome.valid)
+      continue;
+    counted++;
+    nodes += outcome.nodes;
+    elapsed += outcome.elapsed;
+    evalProbes += outcome.evalProbes;
+    evalHits += outcome.evalHits;
+    if (outcome.solved) {
+      solved++;
+      solveTime += outcome.solveTime;
+      solveNodes += outcome.solveNodes;
+    }
+  }
+
+  cout << "solved " << solved << " of " << counted << " (" << fixed
+       << setprecision(1) << (counted ? 100.0 * solved / counted : 0.0)
+       << "%), " << records.size() - counted << " skipped" << endl;
+  if (solved > 0)
+    cout << "mean time to solution " << solveTime / solved
+	 << " ms, mean nodes to solution " << solveNodes / solved << endl;
+  cout << "total search time " << elapsed << " ms, nodes " << nodes
+       << ", nps " << (elapsed ? nodes * 1000 / elapsed : 0) << endl;
+  if (evalProbes > 0)
+    cout << "evaluation cache hits " << evalHits << " of " << evalProbes
+	 << " (" << 100.0 * evalHits / evalProbes << "%)" << endl;
+  if (!options.trace.empty())
+    cout << "trace of " << traceFile.size() << " nodes written to "
+	 << options.trace << endl;
+  return 0;
+}
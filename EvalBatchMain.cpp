@@ -0,0 +1,107 @@
+#include "BatchEvaluation.h"
+#include "ChessBoard.h"
+#include "Evaluation.h"
+#include "TrainingData.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* evaluates the positions of a file of training data, as written by
+   datagen, with every batch kernel the processor supports and with
+   evaluate one position at a time, checks that they agree and reports
+   how many positions each scores per second.
+
+   usage: evalbatch FILE [--repeat N]
+
+   --repeat evaluates the batch N times over to time small files. */
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now()
+				  - start).count();
+}
+
+void printRate(const string& name, uint64_t positions, double seconds) {
+  cout << left << setw(10) << name << right << fixed << setprecision(0)
+       << setw(14) << positions / max(seconds, 1e-9) << " positions/s"
+       << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  int repeat = 1;
+  if (argc == 4 && string(argv[2]) == "--repeat")
+    repeat = max(1, atoi(argv[3]));
+  else if (argc != 2) {
+    cerr << "usage: evalbatch FILE [--repeat N]" << endl;
+    return 1;
+  }
+
+  ifstream in(argv[1], ios::binary);
+  if (!in) {
+    cerr << "evalbatch: cannot read " << argv[1] << endl;
+    return 1;
+  }
+  vector<PackedPosition> positions;
+  PackedPosition position;
+  while (in.read((char*)&position, sizeof(position)))
+    positions.push_back(position);
+
+  auto start = chrono::steady_clock::now();
+  PositionBatch batch;
+  for (const PackedPosition& packed : positions)
+    batch.add(packed);
+  cout << "Loaded " << batch.size() << " positions into the batch in "
+       << fixed << setprecision(3) << secondsSince(start) << " s" << endl;
+
+  // evaluate needs a board per position; boards are set up in chunks
+  // outside the timing so only the evaluation is measured.
+  vector<int> expected(positions.size());
+  vector<unique_ptr<ChessBoard>> boards;
+  for (int i = 0; i < 1024; i++)
+    boards.emplace_back(new ChessBoard(false));
+  double scalarSeconds = 0;
+  for (size_t first = 0; first < positions.size(); first += boards.size()) {
+    size_t count = min(boards.size(), positions.size() - first);
+    for (size_t i = 0; i < count; i++)
+      boards[i]->setPosition(packedPositionFen(positions[first + i]));
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < repeat; round++)
+      for (size_t i = 0; i < count; i++)
+	expected[first + i] = evaluate(*boards[i]);
+    scalarSeconds += secondsSince(start);
+  }
+  printRate("evaluate", positions.size() * repeat, scalarSeconds);
+
+  vector<int> scores(batch.size());
+  bool agree = true;
+  for (int kernel = SCALAR_KERNEL; kernel <= bestBatchKernel(); kernel++) {
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < repeat; round++)
+      evaluateBatch(batch, scores.data(), (BatchKernel)kernel);
+    printRate(batchKernelName((BatchKernel)kernel), batch.size() * repeat,
+	      secondsSince(start));
+
+    for (size_t i = 0; i < scores.size(); i++)
+      if (scores[i] != expected[i]) {
+	cerr << "evalbatch: " << batchKernelName((BatchKernel)kernel)
+	     << " scores " << scores[i] << " rather than " << expected[i]
+	     << " for " << packedPositionFen(positions[i]) << endl;
+	agree = false;
+	break;
+      }
+  }
+  return agree ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "EvalCache.h"
+#include "Evaluation.h"
+#include "Instrumentation.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t SCORE_MASK = 0xFFFF;
+
+}
+
+
+EvalCache::EvalCache(int size) {
+  resize(size);
+}
+
+
+void EvalCache::resize(int size) {
+
+  entries.clear();
+  entries.shrink_to_fit();
+  mask = 0;
+  if (size <= 0)
+    return;
+
+  uint64_t count = 1;
+  while (count * 2 <= (uint64_t)size)
+    count *= 2;
+  entries.resize(count);
+  mask = count - 1;
+  clear();
+}
+
+
+void EvalCache::clear() {
+
+  // empty entries hold all ones, the top of no key a position is likely
+  // to have.
+  for (uint64_t& entry : entries)
+    entry = ~0ULL;
+  probes = 0;
+  hits = 0;
+}
+
+
+int EvalCache::evaluate(const ChessBoard& board, PawnTable& pawnTable) {
+
+  if (entries.empty())
+    return ::evaluate(board, pawnTable);
+
+  INSTRUMENT_COUNT(PROBE_EVAL_CACHE);
+  probes++;
+  uint64_t key = board.positionKey();
+  uint64_t& entry = entries[key & mask];
+  if ((entry & ~SCORE_MASK) == (key & ~SCORE_MASK)) {
+    INSTRUMENT_COUNT(PROBE_EVAL_CACHE_HIT);
+    hits++;
+    return (int16_t)(entry & SCORE_MASK);
+  }
+
+  // scores are a few thousand centipawns at most, well inside 16 bits.
+  int score = ::evaluate(board, pawnTable);
+  entry = (key & ~SCORE_MASK) | (uint16_t)score;
+  return score;
+}
+
+
+bool EvalCache::enabled() const {
+  return !entries.empty();
+}
+
+
+double EvalCache::hitRate() const {
+  return probes ? (double)hits / probes : 0.0;
+}
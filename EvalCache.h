@@ -0,0 +1,59 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+#include "ChessBoard.h"
+#include <cstdint>
+#include <vector>
+
+// forward declaration, only references to the table are passed here.
+class PawnTable;
+
+// bytes taken by each position kept in the evaluation cache.
+const int EVAL_ENTRY_BYTES = 8;
+
+/* direct-mapped cache of static evaluations keyed by the position key,
+   put in front of evaluate by the search. transpositions and re-searches
+   come back to positions already scored, and a hit costs one load where
+   an evaluation walks the whole board. a cache is used by one thread
+   only, so entries are plain words: the upper 48 bits of the key above
+   the 16-bit score. */
+class EvalCache {
+
+public:
+
+  /* constructor for the cache.
+     @param entries is the number of positions kept, rounded down to a
+     power of two. zero switches the cache off. */
+  EvalCache(int entries = 65536);
+
+  /* function that reallocates the cache, emptying it.
+     @param entries is the number of positions kept, zero for none. */
+  void resize(int entries);
+
+  /* function that forgets every cached score. */
+  void clear();
+
+  /* function that returns the static evaluation of a position, from the
+     cache if it holds the position, otherwise evaluating it and keeping
+     the score.
+     @param board is the chess board holding the position.
+     @param pawnTable caches the pawn structure terms of evaluations.
+     returns the score from the point of view of the player to move. */
+  int evaluate(const ChessBoard& board, PawnTable& pawnTable);
+
+  /* function that returns whether the cache keeps any positions. */
+  bool enabled() const;
+
+  /* function that returns the share of probes found in the cache. */
+  double hitRate() const;
+
+  // counters of probes and of probes found in the cache.
+  uint64_t probes = 0;
+  uint64_t hits = 0;
+
+private:
+
+  std::vector<uint64_t> entries;
+  uint64_t mask = 0;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "Evaluation.h"
+#include "Instrumentation.h"
+#include "PawnTable.h"
+
+namespace {
+
+/* piece-square tables from white's point of view, indexed [row][column]
+   with row 0 being white's back rank. black positions are mirrored. */
+const int PAWN_TABLE[8][8] = {
+  {  0,  0,  0,  0,  0,  0,  0,  0},
+  {  5, 10, 10,-20,-20, 10, 10,  5},
+  {  5, -5,-10,  0,  0,-10, -5,  5},
+  {  0,  0,  0, 20, 20,  0,  0,  0},
+  {  5,  5, 10, 25, 25, 10,  5,  5},
+  { 10, 10, 20, 30, 30, 20, 10, 10},
+  { 50, 50, 50, 50, 50, 50, 50, 50},
+  {  0,  0,  0,  0,  0,  0,  0,  0}};
+
+const int KNIGHT_TABLE[8][8] = {
+  {-50,-40,-30,-30,-30,-30,-40,-50},
+  {-40,-20,  0,  5,  5,  0,-20,-40},
+  {-30,  5, 10, 15, 15, 10,  5,-30},
+  {-30,  0, 15, 20, 20, 15,  0,-30},
+  {-30,  5, 15, 20, 20, 15,  5,-30},
+  {-30,  0, 10, 15, 15, 10,  0,-30},
+  {-40,-20,  0,  0,  0,  0,-20,-40},
+  {-50,-40,-30,-30,-30,-30,-40,-50}};
+
+const int BISHOP_TABLE[8][8] = {
+  {-20,-10,-10,-10,-10,-10,-10,-20},
+  {-10,  5,  0,  0,  0,  0,  5,-10},
+  {-10, 10, 10, 10, 10, 10, 10,-10},
+  {-10,  0, 10, 10, 10, 10,  0,-10},
+  {-10,  5,  5, 10, 10,  5,  5,-10},
+  {-10,  0,  5, 10, 10,  5,  0,-10},
+  {-10,  0,  0,  0,  0,  0,  0,-10},
+  {-20,-10,-10,-10,-10,-10,-10,-20}};
+
+const int ROOK_TABLE[8][8] = {
+  {  0,  0,  0,  5,  5,  0,  0,  0},
+  { -5,  0,  0,  0,  0,  0,  0, -5},
+  { -5,  0,  0,  0,  0,  0,  0, -5},
+  { -5,  0,  0,  0,  0,  0,  0, -5},
+  { -5,  0,  0,  0,  0,  0,  0, -5},
+  { -5,  0,  0,  0,  0,  0,  0, -5},
+  {  5, 10, 10, 10, 10, 10, 10,  5},
+  {  0,  0,  0,  0,  0,  0,  0,  0}};
+
+const int QUEEN_TABLE[8][8] = {
+  {-20,-10,-10, -5, -5,-10,-10,-20},
+  {-10,  0,  5,  0,  0,  0,  0,-10},
+  {-10,  5,  5,  5,  5,  5,  0,-10},
+  {  0,  0,  5,  5,  5,  5,  0, -5},
+  { -5,  0,  5,  5,  5,  5,  0, -5},
+  {-10,  0,  5,  5,  5,  5,  0,-10},
+  {-10,  0,  0,  0,  0,  0,  0,-10},
+  {-20,-10,-10, -5, -5,-10,-10,-20}};
+
+const int KING_TABLE[8][8] = {
+  { 20, 30, 10,  0,  0, 10, 30, 20},
+  { 20, 20,  0,  0,  0,  0, 20, 20},
+  {-10,-20,-20,-20,-20,-20,-20,-10},
+  {-20,-30,-30,-40,-40,-30,-30,-20},
+  {-30,-40,-40,-50,-50,-40,-40,-30},
+  {-30,-40,-40,-50,-50,-40,-40,-30},
+  {-30,-40,-40,-50,-50,-40,-40,-30},
+  {-30,-40,-40,-50,-50,-40,-40,-30}};
+
+// tables indexed by PieceType.
+const int (*const PIECE_TABLES[6])[8] = {PAWN_TABLE, ROOK_TABLE,
+					  KNIGHT_TABLE, BISHOP_TABLE,
+					  QUEEN_TABLE, KING_TABLE};
+
+}
+
+
+int pieceSquareScore(Colour colour, PieceType type, int column, int row) {
+  if (colour == WHITE)
+    return PIECE_VALUES[type] + PIECE_TABLES[type][row][column];
+  return -PIECE_VALUES[type] - PIECE_TABLES[type][7 - row][column];
+}
+
+
+int evaluate(const ChessBoard& board, PawnTable& pawnTable) {
+
+  INSTRUMENT_SCOPE(PROBE_EVALUATE);
+
+  // score is summed from white's point of view.
+  int score = 0;
+  uint64_t pawns[2] = {0, 0};
+  int kingColumn[2] = {0, 0};
+  int kingRow[2] = {0, 0};
+
+  for (int column = 0; column < 8; column++) {
+    for (int row = 0; row < 8; row++) {
+      const Piece* piece = board.pieceAt(column, row);
+      if (piece == nullptr)
+	continue;
+
+      PieceType type = piece->getPieceType();
+      Colour colour = piece->getPieceColour();
+      score += pieceSquareScore(colour, type, column, row);
+
+      if (type == PAWN)
+	pawns[colour] |= 1ULL << (row*8 + column);
+      else if (type == KING) {
+	kingColumn[colour] = column;
+	kingRow[colour] = row;
+      }
+    }
+  }
+
+  // pawn structure changes rarely, so its terms come from the pawn table.
+  const PawnEntry& entry = pawnTable.probe(board.pawnStructureKey(),
+					  pawns[WHITE], pawns[BLACK]);
+  score += entry.score;
+
+  for (int colour = WHITE; colour <= BLACK; colour++) {
+    int sign = colour == WHITE ? 1 : -1;
+
+    // pawn shield only counts while the king stays on its back rows.
+    int relativeKingRow = colour == WHITE ? kingRow[colour]
+      : 7 - kingRow[colour];
+    if (relativeKingRow <= 1)
+      score += sign * entry.shelter[colour][kingColumn[colour]];
+
+    // passed pawns are worth more with nothing standing in front of them.
+    for (uint64_t passed = entry.passed[colour]; passed;
+	 passed &= passed - 1) {
+      int square = __builtin_ctzll(passed);
+      int column = square % 8;
+      int row = square / 8;
+      int front = row + (colour == WHITE ? UP : DOWN);
+      if (front >= 0 && front <= 7 && board.pieceAt(column, front) == nullptr)
+	score += sign * FREE_PASSER_BONUS
+	  * (colour == WHITE ? row : 7 - row);
+    }
+  }
+
+  if (board.sideToMove() == BLACK)
+    return -score;
+  return score;
+}
+
+
+int evaluate(const ChessBoard& board) {
+  return evaluate(board, threadPawnTable());
+}
@@ -0,0 +1,33 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+#include "ChessBoard.h"
+
+// forward declaration, only references to the table are passed here.
+class PawnTable;
+
+// value of each type of piece in centipawns, indexed by PieceType.
+const int PIECE_VALUES[6] = {100, 500, 320, 330, 900, 0};
+
+// bonus per row advanced for a passed pawn with nothing in front of it.
+const int FREE_PASSER_BONUS = 3;
+
+/* function that returns the material and piece-square score of a piece
+   from white's point of view.
+   @param colour and type are those of the piece.
+   @param column and row are the position of the piece. */
+int pieceSquareScore(Colour colour, PieceType type, int column, int row);
+
+/* function that scores a position statically, using material,
+   piece-square tables and pawn structure.
+   @param board is the chess board holding the position.
+   @param pawnTable caches the pawn structure terms.
+   returns the score in centipawns from the point of view of the
+   player who's turn it is. */
+int evaluate(const ChessBoard& board, PawnTable& pawnTable);
+
+/* function that scores a position statically as above, caching pawn
+   structure terms in the pawn table of the calling thread.
+   @param board is the chess board holding the position. */
+int evaluate(const ChessBoard& board);
+
+#endif
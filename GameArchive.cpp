@@ -0,0 +1,328 @@
+#include "GameArchive.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[4] = {'C', 'H', 'G', 'A'};
+const uint16_t VERSION = 1;
+// flags of the header.
+const uint16_t ENTROPY_CODED = 1;
+// magic, version, flags, number of games and offset of the index.
+const int HEADER_SIZE = 4 + 2 + 2 + 4 + 8;
+// bit of the first byte of a record set when a position follows.
+const uint8_t HAS_POSITION = 1;
+
+void putInteger(vector<uint8_t>& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++)
+    out.push_back((uint8_t)(value >> 8 * i));
+}
+
+uint64_t getInteger(const uint8_t* in, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++)
+    value |= (uint64_t)in[i] << 8 * i;
+  return value;
+}
+
+// writes a number seven bits to a byte, the high bit marking more to come.
+void putVarint(vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+bool getVarint(const vector<uint8_t>& in, size_t& at, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; at < in.size() && shift < 64; shift += 7) {
+    uint8_t byte = in[at++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/* carry-less range coder after Subbotin. every symbol here is a move
+   index out of the number of legal moves, all equally likely, so a
+   symbol costs log2 of that number in bits rather than a whole byte. */
+const uint32_t TOP = 1u << 24;
+const uint32_t BOTTOM = 1u << 16;
+
+class RangeEncoder {
+
+public:
+
+  RangeEncoder(vector<uint8_t>& out) : out(out) {}
+
+  void encode(uint32_t symbol, uint32_t total) {
+    range /= total;
+    low += symbol * range;
+    while ((low ^ (low + range)) < TOP
+	   || (range < BOTTOM && ((range = -low & (BOTTOM - 1)), true))) {
+      out.push_back((uint8_t)(low >> 24));
+      low <<= 8;
+      range <<= 8;
+    }
+  }
+
+  void finish() {
+    for (int i = 0; i < 4; i++) {
+      out.push_back((uint8_t)(low >> 24));
+      low <<= 8;
+    }
+  }
+
+private:
+
+  vector<uint8_t>& out;
+  uint32_t low = 0;
+  uint32_t range = 0xffffffff;
+};
+
+class RangeDecoder {
+
+public:
+
+  RangeDecoder(const vector<uint8_t>& in, size_t at) : in(in), at(at) {
+    for (int i = 0; i < 4; i++)
+      code = code << 8 | next();
+  }
+
+  uint32_t decode(uint32_t total) {
+    range /= total;
+    uint32_t symbol = (code - low) / range;
+    // only a damaged record decodes past the end.
+    if (symbol >= total)
+      symbol = total - 1;
+    low += symbol * range;
+    while ((low ^ (low + range)) < TOP
+	   || (range < BOTTOM && ((range = -low & (BOTTOM - 1)), true))) {
+      code = code << 8 | next();
+      low <<= 8;
+      range <<= 8;
+    }
+    return symbol;
+  }
+
+private:
+
+  uint8_t next() { return at < in.size() ? in[at++] : 0; }
+
+  const vector<uint8_t>& in;
+  size_t at;
+  uint32_t low = 0;
+  uint32_t range = 0xffffffff;
+  uint32_t code = 0;
+};
+
+}
+
+
+GameArchiveWriter::~GameArchiveWriter() {
+  if (out.is_open())
+    close();
+}
+
+bool GameArchiveWriter::open(const string& file, bool entropyCoded) {
+  out.open(file, ios::binary | ios::trunc);
+  if (!out)
+    return false;
+  this->entropyCoded = entropyCoded;
+  offsets.clear();
+  // the header is written again once the index is known.
+  vector<uint8_t> header(HEADER_SIZE, 0);
+  out.write((const char*)header.data(), header.size());
+  position = HEADER_SIZE;
+  return (bool)out;
+}
+
+bool GameArchiveWriter::addGame(const string& fen, const vector<Move>& moves,
+				GameResult result) {
+  if (!out.is_open())
+    return false;
+
+  ChessBoard board(false);
+  bool hasPosition = !fen.empty() && fen != START_POSITION;
+  if (!board.setPosition(hasPosition ? fen : START_POSITION))
+    return false;
+
+  record.clear();
+  record.push_back((uint8_t)((hasPosition ? HAS_POSITION : 0)
+			     | result << 1));
+  if (hasPosition) {
+    putVarint(record, fen.size());
+    record.insert(record.end(), fen.begin(), fen.end());
+  }
+  putVarint(record, moves.size());
+
+  RangeEncoder encoder(record);
+  MoveRecord undo;
+  for (Move move : moves) {
+    MoveList legal = board.legalMoves();
+    size_t index = 0;
+    while (index < legal.size() && !(legal[index] == move))
+      index++;
+    if (index == legal.size())
+      return false;
+    if (entropyCoded)
+      encoder.encode(index, legal.size());
+    else
+      record.push_back((uint8_t)index);
+    board.doMove(legal[index], undo);
+  }
+  if (entropyCoded)
+    encoder.finish();
+
+  out.write((const char*)record.data(), record.size());
+  offsets.push_back(position);
+  position += record.size();
+  return (bool)out;
+}
+
+bool GameArchiveWriter::close() {
+  if (!out.is_open())
+    return false;
+
+  vector<uint8_t> bytes;
+  for (uint64_t offset : offsets)
+    putInteger(bytes, offset, 8);
+  out.write((const char*)bytes.data(), bytes.size());
+
+  bytes.clear();
+  bytes.insert(bytes.end(), MAGIC, MAGIC + 4);
+  putInteger(bytes, VERSION, 2);
+  putInteger(bytes, entropyCoded ? ENTROPY_CODED : 0, 2);
+  putInteger(bytes, offsets.size(), 4);
+  putInteger(bytes, position, 8);
+  out.seekp(0);
+  out.write((const char*)bytes.data(), bytes.size());
+
+  bool written = (bool)out;
+  out.close();
+  return written;
+}
+
+
+bool GameArchiveReader::open(const string& file) {
+  in.open(file, ios::binary);
+  uint8_t header[HEADER_SIZE];
+  if (!in.read((char*)header, HEADER_SIZE)
+      || memcmp(header, MAGIC, 4) != 0 || getInteger(header + 4, 2) != VERSION)
+    return false;
+
+  coded = getInteger(header + 6, 2) & ENTROPY_CODED;
+  uint64_t games = getInteger(header + 8, 4);
+  uint64_t indexOffset = getInteger(header + 12, 8);
+
+  // the index must fit between the games and the end of the file.
+  in.seekg(0, ios::end);
+  uint64_t fileSize = (uint64_t)in.tellg();
+  if (indexOffset < HEADER_SIZE || indexOffset > fileSize
+      || games > (fileSize - indexOffset) / 8)
+    return false;
+
+  vector<uint8_t> index(games * 8);
+  in.seekg(indexOffset);
+  if (!in.read((char*)index.data(), index.size()))
+    return false;
+
+  // games are stored in order, each starting where the one before ends.
+  offsets.resize(games + 1);
+  offsets[games] = indexOffset;
+  uint64_t previous = HEADER_SIZE;
+  for (uint64_t game = 0; game < games; game++) {
+    offsets[game] = getInteger(&index[game * 8], 8);
+    if (offsets[game] < previous || offsets[game] > indexOffset) {
+      offsets.clear();
+      return false;
+    }
+    previous = offsets[game];
+  }
+  return true;
+}
+
+uint64_t GameArchiveReader::gameBytes() const {
+  return offsets.empty() ? 0 : offsets.back() - HEADER_SIZE;
+}
+
+bool GameArchiveReader::load(size_t index) {
+  if (index >= size() || offsets[index + 1] < offsets[index])
+    return false;
+  record.resize(offsets[index + 1] - offsets[index]);
+  in.clear();
+  in.seekg(offsets[index]);
+  return (bool)in.read((char*)record.data(), record.size());
+}
+
+bool GameArchiveReader::read(size_t index, ArchivedGame& game) {
+  ChessBoard board(false);
+  game.moves.clear();
+  auto keep = [&game](ChessBoard&, Move move) {
+    if (!(move == NO_MOVE))
+      game.moves.push_back(move);
+    return true;
+  };
+  if (!replay(index, board, keep, &game.result))
+    return false;
+  // the position was read with the record, which is still loaded.
+  game.fen.clear();
+  if (record[0] & HAS_POSITION) {
+    size_t at = 1;
+    uint64_t length;
+    getVarint(record, at, length);
+    game.fen.assign(record.begin() + at, record.begin() + at + length);
+  }
+  return true;
+}
+
+bool GameArchiveReader::replay(size_t index, ChessBoard& board,
+			       const function<bool(ChessBoard&, Move)>& visit,
+			       GameResult* result) {
+  if (!load(index) || record.empty())
+    return false;
+
+  size_t at = 1;
+  string fen = START_POSITION;
+  if (record[0] & HAS_POSITION) {
+    uint64_t length;
+    if (!getVarint(record, at, length) || length > record.size() - at)
+      return false;
+    fen.assign(record.begin() + at, record.begin() + at + length);
+    at += length;
+  }
+  uint64_t plies;
+  int resultBits = record[0] >> 1 & 3;
+  if (!getVarint(record, at, plies) || resultBits > DRAWN
+      || !board.setPosition(fen))
+    return false;
+  if (result)
+    *result = (GameResult)resultBits;
+
+  if (!visit(board, NO_MOVE))
+    return true;
+
+  RangeDecoder decoder(record, at);
+  MoveRecord undo;
+  for (uint64_t ply = 0; ply < plies; ply++) {
+    MoveList legal = board.legalMoves();
+    if (legal.empty())
+      return false;
+    size_t move;
+    if (coded)
+      move = decoder.decode(legal.size());
+    else if (at < record.size())
+      move = record[at++];
+    else
+      return false;
+    if (move >= legal.size())
+      return false;
+    board.doMove(legal[move], undo);
+    if (!visit(board, legal[move]))
+      break;
+  }
+  return true;
+}
@@ -0,0 +1,111 @@
+#ifndef GAMEARCHIVE_H
+#define GAMEARCHIVE_H
+#include "ChessBoard.h"
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+/* an archive is a file of games stored move by move as the index of the
+   move in the list legalMoves returns, which the board generates in a
+   fixed order, so replaying the list recovers the move. it is laid out as
+
+     header    "CHGA", version, flags, number of games, offset of the index
+     games     one record after another
+     index     the offset of every record, 8 bytes each
+
+   a record holds a byte of kind and result, the starting position in
+   Forsyth-Edwards Notation when it is not the usual one, the number of
+   plies and then the moves. moves take a byte each, or, in archives
+   written with entropy coding, are range coded over the number of legal
+   moves, costing log2 of that number in bits. */
+
+// struct holding a game read from an archive.
+struct ArchivedGame {
+  // empty for the usual starting position.
+  std::string fen;
+  GameResult result = DRAWN;
+  std::vector<Move> moves;
+};
+
+class GameArchiveWriter {
+
+public:
+
+  ~GameArchiveWriter();
+
+  /* function that creates an archive, replacing any file of that name.
+     @param file is the name of the archive.
+     @param entropyCoded is whether to range code the moves. */
+  bool open(const std::string& file, bool entropyCoded);
+
+  /* function that appends a game to the archive.
+     @param fen is the starting position, empty for the usual one.
+     @param moves are the moves played, each legal in turn.
+     @param result is the outcome of the game.
+     returns false, writing nothing, if a move is illegal. */
+  bool addGame(const std::string& fen, const std::vector<Move>& moves,
+	       GameResult result);
+
+  /* function that writes the index and header and closes the archive. */
+  bool close();
+
+  /* getter function for the number of games added. */
+  size_t size() const { return offsets.size(); }
+
+private:
+
+  std::ofstream out;
+  bool entropyCoded = false;
+  std::vector<uint64_t> offsets;
+  uint64_t position = 0;
+  std::vector<uint8_t> record;
+};
+
+class GameArchiveReader {
+
+public:
+
+  /* function that opens an archive and reads its index.
+     @param file is the name of the archive. */
+  bool open(const std::string& file);
+
+  /* getter function for the number of games in the archive. */
+  size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+  /* getter function for whether the moves are range coded. */
+  bool entropyCoded() const { return coded; }
+
+  /* function that reads a game.
+     @param index is the number of the game, counted from zero.
+     @param game is filled with the game. */
+  bool read(size_t index, ArchivedGame& game);
+
+  /* function that plays a game through on a board without keeping the
+     moves, for tools that only look at the positions.
+     @param index is the number of the game, counted from zero.
+     @param board is set to the starting position and each move made on it.
+     @param visit is called with NO_MOVE for the starting position and
+     then after each move, and stops the game early by returning false.
+     @param result if not nullptr is filled with the outcome. */
+  bool replay(size_t index, ChessBoard& board,
+	      const std::function<bool(ChessBoard&, Move)>& visit,
+	      GameResult* result = nullptr);
+
+  /* function that returns the number of bytes games take in the file. */
+  uint64_t gameBytes() const;
+
+private:
+
+  /* function that reads the record of a game into the buffer. */
+  bool load(size_t index);
+
+  std::ifstream in;
+  bool coded = false;
+  // offset of every record and, last, of the index.
+  std::vector<uint64_t> offsets;
+  std::vector<uint8_t> record;
+};
+
+#endif
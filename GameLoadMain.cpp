@@ -0,0 +1,427 @@
+#include "GameProtocol.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/* load test of the game server over loopback. every game is created at
+   the start and stays open until it has played its moves, so the server
+   holds all the games at once, while each connection keeps a few requests
+   in flight for its games in turn. moves are picked at random from the
+   legal moves the server sends back, optionally after some attempts at
+   illegal ones, and a game that ends is taken back a move and played on.
+   the latency of every request is measured from when it is sent to when
+   its response arrives.
+
+   usage: gameload [--port N] [--connections N] [--games N] [--moves N]
+                   [--illegal N] [--inflight N] [--threads N] */
+
+namespace {
+
+// struct holding the options given on the command line.
+struct LoadOptions {
+  int port = 7070;
+  int connections = 1000;
+  int games = 100000;
+  int moves = 40;
+  int illegal = 0;
+  int inflight = 1;
+  int threads = 1;
+};
+
+// latencies are counted in buckets of a microsecond up to this.
+const int LATENCY_BUCKETS = 100000;
+
+// struct holding what one thread of the test counted.
+struct LoadTotals {
+  uint64_t requests = 0;
+  uint64_t moves = 0;
+  uint64_t illegal = 0;
+  uint64_t undos = 0;
+  uint64_t errors = 0;
+  uint64_t mostOpen = 0;
+  uint64_t slowest = 0;
+  vector<uint64_t> latencies = vector<uint64_t>(LATENCY_BUCKETS + 1);
+};
+
+// struct holding a connection to the server.
+struct LoadConnection {
+  int socket;
+  vector<uint8_t> input = vector<uint8_t>(1 << 16);
+  size_t inputEnd = 0;
+  vector<uint8_t> output;
+  size_t outputStart = 0;
+  uint32_t watched = EPOLLIN;
+  // games with a request ready to send, and how many are awaited.
+  deque<int> ready;
+  int inFlight = 0;
+};
+
+// struct holding a game played by the test.
+struct LoadGame {
+  LoadConnection* connection;
+  uint64_t id = 0;
+  int movesLeft;
+  int illegalLeft;
+  bool closing = false;
+  // the next request of the game and the status it should get.
+  GameRequest type = CREATE_GAME;
+  uint8_t body[10];
+  size_t bodyLength = 0;
+  GameStatus expected = GAME_OK;
+  chrono::steady_clock::time_point sent;
+};
+
+/* function that writes the next requests of the games of a connection
+   waiting their turn, as far as the number in flight allows. */
+void sendReady(LoadConnection& connection, vector<LoadGame>& games,
+	       const LoadOptions& options) {
+
+  auto now = chrono::steady_clock::now();
+  vector<uint8_t>& output = connection.output;
+  while (connection.inFlight < options.inflight && !connection.ready.empty()) {
+    int tag = connection.ready.front();
+    connection.ready.pop_front();
+    LoadGame& game = games[tag];
+    size_t start = output.size();
+    output.resize(start + LENGTH_BYTES + HEADER_BYTES + game.bodyLength);
+    uint8_t* out = output.data() + start;
+    out = putWord(out, HEADER_BYTES + game.bodyLength);
+    out = putByte(out, game.type);
+    out = putWord(out, tag);
+    memcpy(out, game.body, game.bodyLength);
+    game.sent = now;
+    connection.inFlight++;
+  }
+}
+
+/* function that sends what is queued on a connection, watching for room
+   to send the rest. returns false if the server has gone. */
+bool flushConnection(int epoll, LoadConnection& connection) {
+
+  while (connection.outputStart < connection.output.size()) {
+    ssize_t count = send(connection.socket,
+			 connection.output.data() + connection.outputStart,
+			 connection.output.size() - connection.outputStart,
+			 MSG_NOSIGNAL);
+    if (count < 0) {
+      if (errno == EINTR)
+	continue;
+      if (errno == EAGAIN)
+	break;
+      return false;
+    }
+    connection.outputStart += count;
+  }
+  if (connection.outputStart == connection.output.size()) {
+    connection.output.clear();
+    connection.outputStart = 0;
+  }
+
+  uint32_t watched = EPOLLIN
+    | (connection.output.empty() ? 0 : EPOLLOUT);
+  if (watched != connection.watched) {
+    epoll_event event;
+    event.events = watched;
+    event.data.ptr = &connection;
+    epoll_ctl(epoll, EPOLL_CTL_MOD, connection.socket, &event);
+    connection.watched = watched;
+  }
+  return true;
+}
+
+/* function that picks the next request of a game after a response,
+   returning false once the game is finished. */
+bool nextRequest(LoadGame& game, const GameReply& reply,
+		 const LoadOptions& options, mt19937_64& random,
+		 LoadTotals& totals) {
+
+  if (game.closing)
+    return false;
+  uint8_t* body = game.body;
+  putLong(body, game.id);
+  game.bodyLength = 8;
+  game.expected = GAME_OK;
+
+  if (game.movesLeft == 0) {
+    game.closing = true;
+    game.type = CLOSE_GAME;
+    return true;
+  }
+
+  // a game that has ended is taken back a move and played on.
+  if (reply.outcome != GAME_PLAYING) {
+    totals.undos++;
+    game.type = UNDO_MOVE;
+    return true;
+  }
+
+  int legal = reply.legalCount;
+  if (game.illegalLeft > 0) {
+    // any pair of squares that is not a legal move will do.
+    while (true) {
+      body[8] = random() % 64;
+      body[9] = random() % 64;
+      bool found = false;
+      for (int i = 0; i < legal && !found; i++)
+	found = reply.legal[2*i] == body[8]
+	  && reply.legal[2*i + 1] == body[9];
+      if (!found)
+	break;
+    }
+    game.illegalLeft--;
+    game.expected = MOVE_ILLEGAL;
+    totals.illegal++;
+  }
+  else {
+    int choice = random() % legal;
+    body[8] = reply.legal[2*choice];
+    body[9] = reply.legal[2*choice + 1];
+    game.movesLeft--;
+    game.illegalLeft = options.illegal;
+    totals.moves++;
+  }
+  game.type = SUBMIT_MOVE;
+  game.bodyLength = 10;
+  return true;
+}
+
+/* function run by each thread of the test, playing its share of the
+   games over its share of the connections. */
+void playGames(const LoadOptions& options, int connectionCount,
+	       int gameCount, uint64_t seed, LoadTotals& totals,
+	       atomic<bool>& failed) {
+
+  mt19937_64 random(seed);
+  int epoll = epoll_create1(0);
+  vector<LoadConnection> connections(connectionCount);
+  vector<LoadGame> games(gameCount);
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  for (LoadConnection& connection : connections) {
+    connection.socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(connection.socket, (sockaddr*)&address,
+		sizeof(address)) < 0) {
+      cerr << "gameload: cannot connect to port " << options.port << ": "
+	   << strerror(errno) << endl;
+      failed = true;
+      return;
+    }
+    int on = 1;
+    setsockopt(connection.socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    fcntl(connection.socket, F_SETFL, O_NONBLOCK);
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &connection;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, connection.socket, &event);
+  }
+
+  // games are dealt out to the connections in turn and all created.
+  for (int i = 0; i < gameCount; i++) {
+    games[i].connection = &connections[i % connectionCount];
+    games[i].movesLeft = options.moves;
+    games[i].illegalLeft = options.illegal;
+    games[i].connection->ready.push_back(i);
+  }
+  for (LoadConnection& connection : connections) {
+    sendReady(connection, games, options);
+    flushConnection(epoll, connection);
+  }
+
+  int playing = gameCount;
+  uint64_t open = 0;
+  epoll_event events[256];
+  GameReply reply;
+  while (playing > 0 && !failed) {
+    int count = epoll_wait(epoll, events, 256, -1);
+    if (count < 0 && errno != EINTR)
+      break;
+
+    for (int e = 0; e < count; e++) {
+      LoadConnection& connection = *(LoadConnection*)events[e].data.ptr;
+      bool connected = true;
+      if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+	ssize_t received = recv(connection.socket,
+				connection.input.data() + connection.inputEnd,
+				connection.input.size() - connection.inputEnd,
+				0);
+	connected = received > 0 || (received < 0 && errno == EAGAIN);
+	if (received > 0)
+	  connection.inputEnd += received;
+      }
+
+      // every complete response moves its game on.
+      size_t start = 0;
+      auto now = chrono::steady_clock::now();
+      while (connected && connection.inputEnd - start >= LENGTH_BYTES) {
+	const uint8_t* message = connection.input.data() + start;
+	uint32_t length = getWord(message);
+	if (connection.inputEnd - start < LENGTH_BYTES + length)
+	  break;
+	start += LENGTH_BYTES + length;
+	if (!readReply(message, length, reply) || reply.tag >= games.size()) {
+	  totals.errors++;
+	  continue;
+	}
+
+	LoadGame& game = games[reply.tag];
+	connection.inFlight--;
+	uint64_t latency = chrono::duration_cast<chrono::microseconds>
+	  (now - game.sent).count();
+	totals.latencies[min<uint64_t>(latency, LATENCY_BUCKETS)]++;
+	totals.slowest = max(totals.slowest, latency);
+	totals.requests++;
+
+	if (reply.status != game.expected
+	    || (!reply.hasState && !game.closing)) {
+	  totals.errors++;
+	  playing--;
+	  continue;
+	}
+	if (reply.type == CREATE_GAME) {
+	  game.id = reply.game;
+	  totals.mostOpen = max(totals.mostOpen, ++open);
+	}
+	if (reply.type == CLOSE_GAME)
+	  open--;
+	if (nextRequest(game, reply, options, random, totals))
+	  connection.ready.push_back(reply.tag);
+	else
+	  playing--;
+      }
+      memmove(connection.input.data(), connection.input.data() + start,
+	      connection.inputEnd - start);
+      connection.inputEnd -= start;
+
+      if (connected) {
+	sendReady(connection, games, options);
+	connected = flushConnection(epoll, connection);
+      }
+      if (!connected) {
+	cerr << "gameload: the server closed a connection" << endl;
+	failed = true;
+	break;
+      }
+    }
+  }
+
+  for (LoadConnection& connection : connections)
+    close(connection.socket);
+  close(epoll);
+}
+
+/* function that returns the latency below which a fraction of the
+   requests fell, in microseconds. */
+uint64_t percentile(const vector<uint64_t>& latencies, uint64_t requests,
+		    double fraction) {
+  uint64_t wanted = (uint64_t)(fraction * requests);
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < latencies.size(); bucket++) {
+    seen += latencies[bucket];
+    if (seen > wanted)
+      return bucket;
+  }
+  return latencies.size();
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  LoadOptions options;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc)
+      options.port = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--connections") && i + 1 < argc)
+      options.connections = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--games") && i + 1 < argc)
+      options.games = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--moves") && i + 1 < argc)
+      options.moves = max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--illegal") && i + 1 < argc)
+      options.illegal = max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--inflight") && i + 1 < argc)
+      options.inflight = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = max(1, atoi(argv[++i]));
+    else {
+      cerr << "usage: gameload [--port N] [--connections N] [--games N]"
+	   << " [--moves N] [--illegal N] [--inflight N] [--threads N]"
+	   << endl;
+      return 1;
+    }
+  }
+  options.threads = min(options.threads, options.connections);
+  options.connections = min(options.connections, options.games);
+
+  // connections and games are shared out as evenly as they go.
+  vector<LoadTotals> totals(options.threads);
+  vector<thread> threads;
+  atomic<bool> failed(false);
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < options.threads; i++) {
+    int connections = options.connections / options.threads
+      + (i < options.connections % options.threads);
+    int games = options.games / options.threads
+      + (i < options.games % options.threads);
+    threads.emplace_back(playGames, cref(options), connections, games,
+			 i + 1, ref(totals[i]), ref(failed));
+  }
+  for (thread& player : threads)
+    player.join();
+  double seconds = chrono::duration<double>
+    (chrono::steady_clock::now() - start).count();
+
+  LoadTotals all;
+  for (const LoadTotals& part : totals) {
+    all.requests += part.requests;
+    all.moves += part.moves;
+    all.illegal += part.illegal;
+    all.undos += part.undos;
+    all.errors += part.errors;
+    all.mostOpen += part.mostOpen;
+    all.slowest = max(all.slowest, part.slowest);
+    for (int bucket = 0; bucket <= LATENCY_BUCKETS; bucket++)
+      all.latencies[bucket] += part.latencies[bucket];
+  }
+
+  cout << options.games << " games over " << options.connections
+       << " connections on " << options.threads << " threads, "
+       << options.inflight << " requests in flight a connection, "
+       << all.mostOpen << " games open at most" << endl;
+  cout << all.requests << " requests in " << fixed << setprecision(2)
+       << seconds << " s, " << (uint64_t)(all.requests / seconds)
+       << " requests/s" << endl;
+  cout << all.moves << " moves, " << all.illegal << " illegal tries, "
+       << all.undos << " undos, " << all.errors << " errors" << endl;
+  cout << "latency us: p50 " << percentile(all.latencies, all.requests, 0.5)
+       << " p90 " << percentile(all.latencies, all.requests, 0.9)
+       << " p99 " << percentile(all.latencies, all.requests, 0.99)
+       << " p99.9 " << percentile(all.latencies, all.requests, 0.999)
+       << " max " << all.slowest << endl;
+  return failed || all.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+#include "GameProtocol.h"
+#include <cstring>
+
+using namespace std;
+
+
+bool readReply(const uint8_t* message, size_t length, GameReply& reply) {
+
+  if (length < HEADER_BYTES + 1)
+    return false;
+  const uint8_t* in = message;
+  const uint8_t* end = message + length;
+  reply.type = (GameRequest)*in++;
+  reply.tag = getWord(in);
+  reply.status = (GameStatus)*in++;
+
+  // a game that was not found and a request not understood have no state.
+  reply.hasState = in != end;
+  if (!reply.hasState)
+    return true;
+  if ((size_t)(end - in) < STATE_BYTES)
+    return false;
+  reply.game = getLong(in);
+  reply.outcome = (GameOutcome)*in++;
+  reply.check = *in++ != 0;
+  reply.sideToMove = *in++;
+  reply.plies = getShort(in);
+  reply.key = getLong(in);
+  memcpy(reply.board, in, sizeof(reply.board));
+  in += sizeof(reply.board);
+  reply.legalCount = *in++;
+  if (end - in != 2*reply.legalCount)
+    return false;
+  memcpy(reply.legal, in, 2*reply.legalCount);
+  return true;
+}
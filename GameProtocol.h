@@ -0,0 +1,129 @@
+#ifndef GAMEPROTOCOL_H
+#define GAMEPROTOCOL_H
+#include <cstddef>
+#include <cstdint>
+
+/* binary protocol of the game server. every message, either way, is a
+   32-bit length counting the bytes after it, then a type byte and a
+   32-bit tag chosen by the client and echoed in the response, then the
+   body of the type. numbers are little-endian and squares are numbered
+   row*8 + column, A1 being 0.
+
+   requests:
+     CREATE_GAME  [position in Forsyth-Edwards Notation, none for the start]
+     SUBMIT_MOVE  game (64) from (8) to (8), castles rook onto king
+     QUERY_STATE  game (64)
+     UNDO_MOVE    game (64)
+     CLOSE_GAME   game (64)
+   responses carry a status byte after the tag, followed by the state of
+   the game, except when no game was found or opened, the request was not
+   understood or the game was closed:
+     game (64) outcome (8) check (8) side to move (8) plies (16) key (64)
+     board (32 bytes, two squares a byte, lower square in the low four
+     bits, colour*6 + type or EMPTY_SQUARE) count (8) legal moves (count
+     pairs of from (8) to (8)) */
+
+// kinds of request.
+enum GameRequest : uint8_t {CREATE_GAME = 1, SUBMIT_MOVE, QUERY_STATE,
+			    UNDO_MOVE, CLOSE_GAME};
+
+// what became of a request.
+enum GameStatus : uint8_t {GAME_OK, MOVE_ILLEGAL, GAME_ENDED, NO_SUCH_GAME,
+			   BAD_REQUEST, ARENA_FULL, NOTHING_TO_UNDO};
+
+// state of play of a game.
+enum GameOutcome : uint8_t {GAME_PLAYING, GAME_CHECKMATE, GAME_STALEMATE,
+			    GAME_REPETITION, GAME_FIFTY_MOVES};
+
+// code of an empty square in the board of a state.
+const uint8_t EMPTY_SQUARE = 15;
+
+// bytes of the length in front of every message.
+const size_t LENGTH_BYTES = 4;
+
+// bytes of type and tag at the start of every message.
+const size_t HEADER_BYTES = 5;
+
+// longest request accepted, after its length.
+const size_t MAX_REQUEST = 256;
+
+// bytes of the state of a game before its legal moves.
+const size_t STATE_BYTES = 54;
+
+// longest response, after its length.
+const size_t MAX_RESPONSE = HEADER_BYTES + 1 + STATE_BYTES + 2*256;
+
+// struct holding a response taken apart.
+struct GameReply {
+  GameRequest type;
+  uint32_t tag;
+  GameStatus status;
+  // whether the state below was sent.
+  bool hasState;
+  uint64_t game;
+  GameOutcome outcome;
+  bool check;
+  uint8_t sideToMove;
+  uint16_t plies;
+  uint64_t key;
+  uint8_t board[32];
+  int legalCount;
+  uint8_t legal[2*256];
+};
+
+/* functions that write a number at a position in a buffer, returning the
+   position after it. */
+inline uint8_t* putByte(uint8_t* out, uint8_t value) {
+  *out = value;
+  return out + 1;
+}
+
+inline uint8_t* putShort(uint8_t* out, uint16_t value) {
+  for (int i = 0; i < 2; i++)
+    out[i] = (uint8_t)(value >> 8*i);
+  return out + 2;
+}
+
+inline uint8_t* putWord(uint8_t* out, uint32_t value) {
+  for (int i = 0; i < 4; i++)
+    out[i] = (uint8_t)(value >> 8*i);
+  return out + 4;
+}
+
+inline uint8_t* putLong(uint8_t* out, uint64_t value) {
+  for (int i = 0; i < 8; i++)
+    out[i] = (uint8_t)(value >> 8*i);
+  return out + 8;
+}
+
+/* functions that read a number at a position in a buffer, moving the
+   position past it. */
+inline uint16_t getShort(const uint8_t*& in) {
+  uint16_t value = (uint16_t)(in[0] | in[1] << 8);
+  in += 2;
+  return value;
+}
+
+inline uint32_t getWord(const uint8_t*& in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++)
+    value |= (uint32_t)in[i] << 8*i;
+  in += 4;
+  return value;
+}
+
+inline uint64_t getLong(const uint8_t*& in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++)
+    value |= (uint64_t)in[i] << 8*i;
+  in += 8;
+  return value;
+}
+
+/* function that takes apart a response.
+   @param message is the response after its length.
+   @param length is the length of the response.
+   returns false if the response is malformed. */
+bool readReply(const uint8_t* message, size_t length, GameReply& reply);
+
+#endif
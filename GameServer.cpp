@@ -0,0 +1,437 @@
+#include "GameServer.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+// bytes a connection reads into at a time, room for many requests.
+const size_t INPUT_BYTES = 16384;
+
+// bytes of responses left unsent beyond which a client is not read from
+// until it catches up.
+const size_t MAX_PENDING_OUTPUT = 1 << 20;
+
+// most events taken from epoll at once.
+const int MAX_EVENTS = 256;
+
+}
+
+
+GameServer::Connection::Connection(int socket)
+  : socket(socket), input(INPUT_BYTES), watched(EPOLLIN) {
+  output.reserve(INPUT_BYTES);
+}
+
+
+GameServer::Connection::~Connection() {
+  close(socket);
+}
+
+
+GameServer::GameServer(int reactorCount, int maxGames)
+  : games(new Game[maxGames]), maxGames(maxGames) {
+
+  // slots are handed out lowest first.
+  freeSlots.reserve(maxGames);
+  for (int64_t slot = maxGames - 1; slot >= 0; slot--)
+    freeSlots.push_back(slot);
+
+  for (int i = 0; i < reactorCount; i++)
+    reactors.emplace_back(new Reactor());
+}
+
+
+GameServer::~GameServer() {
+  for (auto& reactor : reactors) {
+    if (reactor->listener >= 0)
+      close(reactor->listener);
+    if (reactor->epoll >= 0)
+      close(reactor->epoll);
+  }
+}
+
+
+bool GameServer::listen(int port) {
+
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  for (auto& reactor : reactors) {
+    reactor->epoll = epoll_create1(0);
+    reactor->listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (reactor->epoll < 0 || reactor->listener < 0)
+      return false;
+
+    // every reactor listens on the port, the kernel sharing out clients.
+    int on = 1;
+    setsockopt(reactor->listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(reactor->listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    if (bind(reactor->listener, (sockaddr*)&address, sizeof(address)) < 0
+	|| ::listen(reactor->listener, SOMAXCONN) < 0)
+      return false;
+
+    // the listening socket is told apart from clients by having no data.
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(reactor->epoll, EPOLL_CTL_ADD, reactor->listener,
+		  &event) < 0)
+      return false;
+  }
+  return true;
+}
+
+
+void GameServer::run() {
+
+  vector<thread> threads;
+  for (size_t i = 1; i < reactors.size(); i++)
+    threads.emplace_back(&GameServer::react, this, ref(*reactors[i]));
+  react(*reactors[0]);
+  for (thread& reactorThread : threads)
+    reactorThread.join();
+}
+
+
+void GameServer::react(Reactor& reactor) {
+
+  epoll_event events[MAX_EVENTS];
+  while (true) {
+    int count = epoll_wait(reactor.epoll, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR)
+	continue;
+      return;
+    }
+
+    for (int i = 0; i < count; i++) {
+      if (events[i].data.ptr == nullptr) {
+	acceptClients(reactor);
+	continue;
+      }
+      Connection* client = (Connection*)events[i].data.ptr;
+      bool connected = true;
+      if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	connected = receive(reactor, *client);
+      if (connected && (events[i].events & EPOLLOUT))
+	connected = flush(reactor, *client);
+      // closing the socket also takes it out of the epoll set.
+      if (!connected)
+	delete client;
+    }
+  }
+}
+
+
+void GameServer::acceptClients(Reactor& reactor) {
+
+  while (true) {
+    int socket = accept4(reactor.listener, nullptr, nullptr, SOCK_NONBLOCK);
+    if (socket < 0)
+      return;
+
+    // responses are small and awaited, so are sent at once.
+    int on = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    Connection* client = new Connection(socket);
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = client;
+    if (epoll_ctl(reactor.epoll, EPOLL_CTL_ADD, socket, &event) < 0)
+      delete client;
+  }
+}
+
+
+bool GameServer::receive(Reactor& reactor, Connection& client) {
+
+  ssize_t count = recv(client.socket, client.input.data() + client.inputEnd,
+		       client.input.size() - client.inputEnd, 0);
+  if (count == 0)
+    return false;
+  if (count < 0)
+    return errno == EAGAIN || errno == EINTR;
+  client.inputEnd += count;
+
+  // every complete request is handled, a partial one waits for the rest.
+  while (client.inputEnd - client.inputStart >= LENGTH_BYTES) {
+    const uint8_t* request = client.input.data() + client.inputStart;
+    uint32_t length = getWord(request);
+    if (length > MAX_REQUEST)
+      return false;
+    if (client.inputEnd - client.inputStart < LENGTH_BYTES + length)
+      break;
+    handle(reactor, client, request, length);
+    client.inputStart += LENGTH_BYTES + length;
+  }
+
+  // a partial request is moved up once the buffer could not take it whole.
+  if (client.inputStart == client.inputEnd)
+    client.inputStart = client.inputEnd = 0;
+  else if (client.input.size() - client.inputStart
+	   < LENGTH_BYTES + MAX_REQUEST) {
+    memmove(client.input.data(), client.input.data() + client.inputStart,
+	    client.inputEnd - client.inputStart);
+    client.inputEnd -= client.inputStart;
+    client.inputStart = 0;
+  }
+  return flush(reactor, client);
+}
+
+
+bool GameServer::flush(Reactor& reactor, Connection& client) {
+
+  while (client.outputStart < client.output.size()) {
+    // a client that went away must not kill the server with SIGPIPE.
+    ssize_t count = send(client.socket,
+			 client.output.data() + client.outputStart,
+			 client.output.size() - client.outputStart,
+			 MSG_NOSIGNAL);
+    if (count < 0) {
+      if (errno == EINTR)
+	continue;
+      if (errno == EAGAIN)
+	break;
+      return false;
+    }
+    client.outputStart += count;
+  }
+
+  // the buffer keeps its capacity, so responses never allocate once warm.
+  size_t pending = client.output.size() - client.outputStart;
+  if (pending == 0) {
+    client.output.clear();
+    client.outputStart = 0;
+  }
+
+  uint32_t watched = (pending < MAX_PENDING_OUTPUT ? EPOLLIN : 0)
+    | (pending > 0 ? EPOLLOUT : 0);
+  if (watched != client.watched) {
+    epoll_event event;
+    event.events = watched;
+    event.data.ptr = &client;
+    if (epoll_ctl(reactor.epoll, EPOLL_CTL_MOD, client.socket, &event) < 0)
+      return false;
+    client.watched = watched;
+  }
+  return true;
+}
+
+
+void GameServer::handle(Reactor& reactor, Connection& client,
+			const uint8_t* request, size_t length) {
+
+  // the response is written straight into the output of the connection.
+  size_t start = client.output.size();
+  client.output.resize(start + LENGTH_BYTES + MAX_RESPONSE);
+  uint8_t* out = client.output.data() + start + LENGTH_BYTES;
+
+  GameRequest type = length >= HEADER_BYTES ? (GameRequest)request[0]
+    : (GameRequest)0;
+  const uint8_t* in = request + 1;
+  uint32_t tag = length >= HEADER_BYTES ? getWord(in) : 0;
+  out = putByte(out, type);
+  out = putWord(out, tag);
+  uint8_t* status = out++;
+  *status = BAD_REQUEST;
+
+  size_t bodyLength = length >= HEADER_BYTES ? length - HEADER_BYTES : 0;
+  if (type == CREATE_GAME && length >= HEADER_BYTES) {
+    string position((const char*)in, bodyLength);
+    if (position.empty())
+      position = START_POSITION;
+    else {
+      // the position is checked on the board, which then holds no game.
+      reactor.loadedSlot = -1;
+      if (!reactor.board.setPosition(position))
+	position.clear();
+    }
+
+    int64_t slot = position.empty() ? -1 : createGame(position);
+    if (!position.empty() && slot < 0)
+      *status = ARENA_FULL;
+    if (slot >= 0) {
+      lock_guard<mutex> lock(slotLock(slot));
+      loadGame(reactor, slot);
+      *status = GAME_OK;
+      out = writeState(reactor, slot, out);
+    }
+  }
+
+  else if (bodyLength == (type == SUBMIT_MOVE ? 10u : 8u)
+	   && type >= SUBMIT_MOVE && type <= CLOSE_GAME) {
+    uint64_t id = getLong(in);
+    lock_guard<mutex> lock(slotLock(id & 0xffffffff));
+    int64_t slot = findGame(id);
+    if (slot < 0)
+      *status = NO_SUCH_GAME;
+    else if (type == CLOSE_GAME) {
+      // the moves are let go so a closed game holds no memory.
+      Game& game = games[slot];
+      game.open = false;
+      game.generation++;
+      game.version++;
+      vector<uint16_t>().swap(game.moves);
+      string().swap(game.start);
+      lock_guard<mutex> freeLock(freeSlotsLock);
+      freeSlots.push_back(slot);
+      *status = GAME_OK;
+    }
+    else {
+      Game& game = games[slot];
+      *status = GAME_OK;
+      if (type == UNDO_MOVE) {
+	if (game.moves.empty())
+	  *status = NOTHING_TO_UNDO;
+	else {
+	  game.moves.pop_back();
+	  game.version++;
+	}
+      }
+      loadGame(reactor, slot);
+      ChessBoard& board = reactor.board;
+
+      if (type == SUBMIT_MOVE) {
+	int from = *in++;
+	int to = *in++;
+	if (from > 63 || to > 63)
+	  *status = BAD_REQUEST;
+	else if (!board.hasLegalMove() || board.drawnByRule())
+	  *status = GAME_ENDED;
+	else if (!(board.legalTargets(from % 8, from / 8) >> to & 1))
+	  *status = MOVE_ILLEGAL;
+	else {
+	  // the board moves on with the game, so stays loaded.
+	  Move move(from % 8, from / 8, to % 8, to / 8);
+	  MoveRecord record;
+	  board.doMove(move, record);
+	  game.moves.push_back(move.raw());
+	  reactor.loadedVersion = ++game.version;
+	}
+      }
+      if (*status != BAD_REQUEST)
+	out = writeState(reactor, slot, out);
+    }
+  }
+
+  uint8_t* begin = client.output.data() + start;
+  putWord(begin, (uint32_t)(out - begin - LENGTH_BYTES));
+  client.output.resize(out - client.output.data());
+}
+
+
+int64_t GameServer::createGame(const string& start) {
+
+  int64_t slot;
+  {
+    lock_guard<mutex> lock(freeSlotsLock);
+    if (freeSlots.empty())
+      return -1;
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  }
+
+  lock_guard<mutex> lock(slotLock(slot));
+  Game& game = games[slot];
+  game.open = true;
+  game.version++;
+  if (start != START_POSITION)
+    game.start = start;
+  return slot;
+}
+
+
+int64_t GameServer::findGame(uint64_t id) const {
+
+  uint64_t slot = id & 0xffffffff;
+  if (slot >= (uint64_t)maxGames || !games[slot].open
+      || games[slot].generation != id >> 32)
+    return -1;
+  return slot;
+}
+
+
+mutex& GameServer::slotLock(uint64_t slot) {
+  return slotLocks[slot % SLOT_LOCKS];
+}
+
+
+void GameServer::loadGame(Reactor& reactor, int64_t slot) {
+
+  const Game& game = games[slot];
+  if (reactor.loadedSlot == slot && reactor.loadedVersion == game.version)
+    return;
+
+  // the position was checked when the game was created.
+  reactor.board.setPosition(game.start.empty() ? START_POSITION
+			    : game.start);
+  MoveRecord record;
+  for (uint16_t move : game.moves)
+    reactor.board.doMove(Move(move), record);
+  reactor.loadedSlot = slot;
+  reactor.loadedVersion = game.version;
+}
+
+
+uint8_t* GameServer::writeState(Reactor& reactor, int64_t slot,
+				uint8_t* out) {
+
+  const Game& game = games[slot];
+  ChessBoard& board = reactor.board;
+  Colour colour = board.sideToMove();
+
+  // checkmate and stalemate take precedence over draws by rule.
+  GameOutcome outcome = GAME_PLAYING;
+  bool check = board.inCheck(colour);
+  if (!board.hasLegalMove())
+    outcome = check ? GAME_CHECKMATE : GAME_STALEMATE;
+  else if (board.repetitionCount() >= 2)
+    outcome = GAME_REPETITION;
+  else if (board.halfmoveClock() >= 100)
+    outcome = GAME_FIFTY_MOVES;
+
+  out = putLong(out, (uint64_t)game.generation << 32 | slot);
+  out = putByte(out, outcome);
+  out = putByte(out, check);
+  out = putByte(out, colour);
+  out = putShort(out, (uint16_t)game.moves.size());
+  out = putLong(out, board.positionKey());
+
+  for (int square = 0; square < 64; square += 2) {
+    uint8_t codes = 0;
+    for (int half = 0; half < 2; half++) {
+      const Piece* piece = board.pieceAt((square + half) % 8,
+					 (square + half) / 8);
+      uint8_t code = piece == nullptr ? EMPTY_SQUARE
+	: piece->getPieceColour()*6 + piece->getPieceType();
+      codes |= code << 4*half;
+    }
+    out = putByte(out, codes);
+  }
+
+  // the moves come from the table the board keeps for the position.
+  uint8_t* count = out++;
+  *count = 0;
+  if (outcome == GAME_PLAYING)
+    for (int square = 0; square < 64; square++) {
+      uint64_t targets = board.legalTargets(square % 8, square / 8);
+      for (; targets; targets &= targets - 1) {
+	out = putByte(out, square);
+	out = putByte(out, __builtin_ctzll(targets));
+	(*count)++;
+      }
+    }
+  return out;
+}
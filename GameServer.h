@@ -0,0 +1,141 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+#include "ChessBoard.h"
+#include "GameProtocol.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* server playing many games at once for clients on local TCP, speaking
+   the binary protocol of GameProtocol.h. each of a few reactor threads
+   waits on its own epoll set and its own listening socket, the kernel
+   spreading new connections between them, and serves every request of
+   its connections itself without blocking, so connections cost memory
+   rather than threads.
+
+   games live in an arena of fixed size and keep no board of their own,
+   only their starting position and the moves played, two bytes a move.
+   a reactor plays a game through on its own board to answer a request
+   about it, unless its board still holds the game from the request
+   before, as when one client plays one game move after move. */
+class GameServer {
+
+public:
+
+  /* constructor for the server.
+     @param reactors is the number of reactor threads.
+     @param maxGames is the most games open at once. */
+  GameServer(int reactors, int maxGames);
+
+  /* destructor for the server, closing its sockets. */
+  ~GameServer();
+
+  /* function that creates the listening socket of every reactor on the
+     loopback interface.
+     @param port is the TCP port to listen on. */
+  bool listen(int port);
+
+  /* function that serves clients until a socket fails. */
+  void run();
+
+private:
+
+  // struct holding a game of the arena.
+  struct Game {
+    // bumped when the game is closed, so ids of closed games go stale.
+    uint32_t generation = 0;
+    // bumped on every change, telling reactors their board is out of date.
+    uint32_t version = 0;
+    bool open = false;
+    // position the game started from, empty for the usual start.
+    std::string start;
+    std::vector<uint16_t> moves;
+  };
+
+  // struct holding a client connected to a reactor.
+  struct Connection {
+    int socket;
+    // bytes received and not yet handled, from inputStart on.
+    std::vector<uint8_t> input;
+    size_t inputStart = 0;
+    size_t inputEnd = 0;
+    // responses not yet sent, from outputStart on.
+    std::vector<uint8_t> output;
+    size_t outputStart = 0;
+    // events the connection is watched for by epoll.
+    uint32_t watched;
+
+    Connection(int socket);
+    ~Connection();
+  };
+
+  // struct holding a reactor thread and the board it plays games on.
+  struct Reactor {
+    int epoll = -1;
+    int listener = -1;
+    ChessBoard board{false};
+    // game and version the board holds, slot -1 for none.
+    int64_t loadedSlot = -1;
+    uint32_t loadedVersion = 0;
+  };
+
+  /* function run by each reactor, waiting for and handling events. */
+  void react(Reactor& reactor);
+
+  /* function that accepts every connection waiting on a reactor. */
+  void acceptClients(Reactor& reactor);
+
+  /* function that reads what a client sent and handles each complete
+     request, returning false once the client is gone. */
+  bool receive(Reactor& reactor, Connection& client);
+
+  /* function that sends as much of the waiting output as the socket
+     takes, watching for room to write the rest, returning false once the
+     client is gone. */
+  bool flush(Reactor& reactor, Connection& client);
+
+  /* function that handles one request and writes its response.
+     @param request is the request after its length.
+     @param length is the length of the request. */
+  void handle(Reactor& reactor, Connection& client, const uint8_t* request,
+	      size_t length);
+
+  /* function that opens a game, returning its slot or -1 if the arena
+     is full.
+     @param start is the starting position, empty for the usual start. */
+  int64_t createGame(const std::string& start);
+
+  /* function that returns the slot of an open game, or -1. must be
+     called holding the lock of the slot, the low 32 bits of the id. */
+  int64_t findGame(uint64_t id) const;
+
+  /* function that returns the lock guarding a slot of the arena. */
+  std::mutex& slotLock(uint64_t slot);
+
+  /* function that puts a game on the board of a reactor, unless the
+     board holds it already. */
+  void loadGame(Reactor& reactor, int64_t slot);
+
+  /* function that writes the state of the game on the board of a
+     reactor, its legal moves included.
+     @param out is where to write, with room for STATE_BYTES plus two
+     bytes a legal move.
+     returns the position after the state. */
+  uint8_t* writeState(Reactor& reactor, int64_t slot, uint8_t* out);
+
+  std::unique_ptr<Game[]> games;
+  int maxGames;
+  std::vector<int64_t> freeSlots;
+  std::mutex freeSlotsLock;
+
+  // games are guarded by one of these locks, picked by slot.
+  static const int SLOT_LOCKS = 64;
+  std::mutex slotLocks[SLOT_LOCKS];
+
+  std::vector<std::unique_ptr<Reactor>> reactors;
+};
+
+#endif
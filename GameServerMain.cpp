@@ -0,0 +1,43 @@
+#include "GameServer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+/* runs the game server on the loopback interface until it is killed.
+
+   usage: gamed [--port N] [--reactors N] [--games N] */
+
+int main(int argc, char* argv[]) {
+
+  int port = 7070;
+  int reactors = max(1u, thread::hardware_concurrency());
+  int games = 131072;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--port") && i + 1 < argc)
+      port = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--reactors") && i + 1 < argc)
+      reactors = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--games") && i + 1 < argc)
+      games = max(1, atoi(argv[++i]));
+    else {
+      cerr << "usage: gamed [--port N] [--reactors N] [--games N]" << endl;
+      return 1;
+    }
+  }
+
+  GameServer server(reactors, games);
+  if (!server.listen(port)) {
+    cerr << "gamed: cannot listen on port " << port << endl;
+    return 1;
+  }
+  cerr << "gamed: listening on 127.0.0.1:" << port << " with " << reactors
+       << " reactors and room for " << games << " games" << endl;
+  server.run();
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include "Instrumentation.h"
+
+#ifdef CHESS_INSTRUMENT
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+using namespace std;
+
+namespace {
+
+// names of the probes as shown in reports, indexed by Probe.
+const char* const PROBE_NAMES[PROBE_COUNT] = {
+  "submitMove", "isValid", "legalMove", "makeMove", "reverseMove",
+  "inCheck", "inCheckMate", "legalMoves", "evaluate", "evalCache",
+  "evalCacheHit"};
+
+}
+
+#ifdef CHESS_INSTRUMENT
+
+thread_local ProbeCounters* localProbeCounters = nullptr;
+
+namespace {
+
+// totals of every thread, living and finished.
+struct Totals {
+  uint64_t calls[PROBE_COUNT];
+  uint64_t cycles[PROBE_COUNT];
+};
+
+// counters of threads still running, and totals of threads that finished.
+mutex registryLock;
+vector<ProbeCounters*> liveCounters;
+Totals retired = {};
+
+void writeExitReport();
+
+// owner of a thread's counters, folding them into retired when it exits.
+struct CounterOwner {
+  ProbeCounters* counters = nullptr;
+  ~CounterOwner() {
+    if (counters == nullptr)
+      return;
+    lock_guard<mutex> lock(registryLock);
+    for (int probe = 0; probe < PROBE_COUNT; probe++) {
+      retired.calls[probe] += counters->calls[probe].load();
+      retired.cycles[probe] += counters->cycles[probe].load();
+    }
+    for (size_t i = 0; i < liveCounters.size(); i++)
+      if (liveCounters[i] == counters) {
+	liveCounters.erase(liveCounters.begin() + i);
+	break;
+      }
+    localProbeCounters = nullptr;
+    delete counters;
+  }
+};
+
+thread_local CounterOwner owner;
+
+Totals collect() {
+  lock_guard<mutex> lock(registryLock);
+  Totals totals = retired;
+  for (ProbeCounters* counters : liveCounters)
+    for (int probe = 0; probe < PROBE_COUNT; probe++) {
+      totals.calls[probe] += counters->calls[probe].load();
+      totals.cycles[probe] += counters->cycles[probe].load();
+    }
+  return totals;
+}
+
+/* timestamp counter ticks per nanosecond, measured once against the
+   steady clock so reports can give times as well as cycles. */
+double cyclesPerNanosecond() {
+  // the first thread to ask measures it, any others wait for it.
+  static const double rate = [] {
+    auto start = chrono::steady_clock::now();
+    uint64_t begin = __rdtsc();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    uint64_t end = __rdtsc();
+    auto nanoseconds = chrono::duration_cast<chrono::nanoseconds>
+      (chrono::steady_clock::now() - start).count();
+    return nanoseconds > 0 ? (double)(end - begin) / nanoseconds : 1.0;
+  }();
+  return rate;
+}
+
+void writeExitReport() {
+  instrumentationReport(cerr);
+
+  // JSON report is written where CHESS_INSTRUMENT_JSON says, if anywhere.
+  const char* path = getenv("CHESS_INSTRUMENT_JSON");
+  if (path != nullptr) {
+    ofstream out(path);
+    instrumentationReportJson(out);
+  }
+}
+
+}
+
+
+ProbeCounters* registerProbeCounters() {
+
+  static once_flag exitReport;
+  call_once(exitReport, [] { atexit(writeExitReport); });
+
+  ProbeCounters* counters = new ProbeCounters();
+  for (int probe = 0; probe < PROBE_COUNT; probe++) {
+    counters->calls[probe] = 0;
+    counters->cycles[probe] = 0;
+  }
+
+  lock_guard<mutex> lock(registryLock);
+  liveCounters.push_back(counters);
+  owner.counters = counters;
+  return counters;
+}
+
+
+void instrumentationReport(ostream& out) {
+
+  Totals totals = collect();
+  double rate = cyclesPerNanosecond();
+  uint64_t submits = totals.calls[PROBE_SUBMIT_MOVE];
+
+  // cycles are inclusive: a probe's time includes the probes it calls.
+  out << "instrumentation report (inclusive cycles)" << endl;
+  out << left << setw(14) << "function" << right << setw(14) << "calls"
+      << setw(14) << "per submit" << setw(16) << "cycles"
+      << setw(12) << "cyc/call" << setw(12) << "ms" << endl;
+  for (int probe = 0; probe < PROBE_COUNT; probe++) {
+    uint64_t calls = totals.calls[probe];
+    uint64_t cycles = totals.cycles[probe];
+    out << left << setw(14) << PROBE_NAMES[probe] << right << setw(14)
+	<< calls << setw(14) << fixed << setprecision(1)
+	<< (submits ? (double)calls / submits : 0.0) << setw(16) << cycles
+	<< setw(12) << (calls ? (double)cycles / calls : 0.0) << setw(12)
+	<< setprecision(3) << cycles / rate / 1e6 << endl;
+  }
+}
+
+
+void instrumentationReportJson(ostream& out) {
+
+  Totals totals = collect();
+  double rate = cyclesPerNanosecond();
+
+  out << "{\"cyclesPerNanosecond\": " << rate << ", \"probes\": {";
+  for (int probe = 0; probe < PROBE_COUNT; probe++) {
+    out << (probe ? ", " : "") << "\"" << PROBE_NAMES[probe]
+	<< "\": {\"calls\": " << totals.calls[probe] << ", \"cycles\": "
+	<< totals.cycles[probe] << "}";
+  }
+  out << "}}" << endl;
+}
+
+
+void instrumentationReset() {
+  lock_guard<mutex> lock(registryLock);
+  retired = Totals();
+  for (ProbeCounters* counters : liveCounters)
+    for (int probe = 0; probe < PROBE_COUNT; probe++) {
+      counters->calls[probe] = 0;
+      counters->cycles[probe] = 0;
+    }
+}
+
+#else
+
+void instrumentationReport(ostream& out) {
+  out << "instrumentation compiled out, rebuild with make INSTRUMENT=1"
+      << endl;
+}
+
+
+void instrumentationReportJson(ostream& out) {
+  out << "{\"probes\": {}}" << endl;
+  (void)PROBE_NAMES;
+}
+
+
+void instrumentationReset() {
+}
+
+#endif
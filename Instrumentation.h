@@ -0,0 +1,85 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#include <iostream>
+#include <cstdint>
+
+/* hot-path instrumentation of the rules engine. probes are compiled in
+   only when CHESS_INSTRUMENT is defined (make INSTRUMENT=1), otherwise
+   the macros below expand to nothing and cost nothing. */
+
+// enum of the functions that are counted and timed, the last two counting
+// probes of the evaluation cache and the hits among them.
+enum Probe {PROBE_SUBMIT_MOVE, PROBE_IS_VALID, PROBE_LEGAL_MOVE,
+	    PROBE_MAKE_MOVE, PROBE_REVERSE_MOVE, PROBE_IN_CHECK,
+	    PROBE_IN_CHECK_MATE, PROBE_LEGAL_MOVES, PROBE_EVALUATE,
+	    PROBE_EVAL_CACHE, PROBE_EVAL_CACHE_HIT, PROBE_COUNT};
+
+/* function that writes the totals of every thread as a text table.
+   @param out is the stream the report is written to. */
+void instrumentationReport(std::ostream& out);
+
+/* function that writes the totals of every thread as a JSON object.
+   @param out is the stream the report is written to. */
+void instrumentationReportJson(std::ostream& out);
+
+/* function that sets every counter of every thread back to zero. */
+void instrumentationReset();
+
+#ifdef CHESS_INSTRUMENT
+#include <atomic>
+#include <x86intrin.h>
+
+/* counters of one thread. only the owning thread writes them, so they are
+   bumped with relaxed load and store rather than locked instructions, and
+   each block sits on its own cache lines. */
+struct alignas(64) ProbeCounters {
+  std::atomic<uint64_t> calls[PROBE_COUNT];
+  std::atomic<uint64_t> cycles[PROBE_COUNT];
+};
+
+/* function that creates and registers the counters of the calling thread. */
+ProbeCounters* registerProbeCounters();
+
+extern thread_local ProbeCounters* localProbeCounters;
+
+/* function that returns the counters of the calling thread. */
+inline ProbeCounters& threadProbeCounters() {
+  if (localProbeCounters == nullptr)
+    localProbeCounters = registerProbeCounters();
+  return *localProbeCounters;
+}
+
+inline void bumpCounter(std::atomic<uint64_t>& counter, uint64_t amount) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+		std::memory_order_relaxed);
+}
+
+// object that counts a call and the cycles spent until it goes out of scope.
+class ScopedProbe {
+public:
+  ScopedProbe(Probe probe_) : probe(probe_), begin(__rdtsc()) {}
+  ~ScopedProbe() {
+    ProbeCounters& counters = threadProbeCounters();
+    bumpCounter(counters.calls[probe], 1);
+    bumpCounter(counters.cycles[probe], __rdtsc() - begin);
+  }
+private:
+  Probe probe;
+  uint64_t begin;
+};
+
+#define INSTRUMENT_CONCAT_(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_(a, b)
+#define INSTRUMENT_COUNT(probe) \
+  bumpCounter(threadProbeCounters().calls[probe], 1)
+#define INSTRUMENT_SCOPE(probe) \
+  ScopedProbe INSTRUMENT_CONCAT(scopedProbe, __LINE__)(probe)
+
+#else
+
+#define INSTRUMENT_COUNT(probe) ((void)0)
+#define INSTRUMENT_SCOPE(probe) ((void)0)
+
+#endif
+
+#endif
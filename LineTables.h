@@ -0,0 +1,55 @@
+#ifndef LINETABLES_H
+#define LINETABLES_H
+#include <cstdint>
+
+/* bitboards, bit row*8+column per square, for every pair of squares: the
+   squares strictly between them and the whole line through both, edge to
+   edge. pairs of squares not on a common row, column or diagonal, and a
+   square paired with itself, have empty entries. */
+struct LineTables {
+  uint64_t between[64][64];
+  uint64_t line[64][64];
+};
+
+/* function that works out the line tables, run by the compiler. */
+constexpr LineTables makeLineTables() {
+
+  LineTables tables = {};
+  const int columns[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+  const int rows[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+  for (int from = 0; from < 64; from++)
+    for (int direction = 0; direction < 8; direction++) {
+      // the line runs both ways out of the square.
+      uint64_t whole = 1ULL << from;
+      for (int sign = -1; sign <= 1; sign += 2) {
+	int column = from % 8 + sign*columns[direction];
+	int row = from / 8 + sign*rows[direction];
+	for (; column >= 0 && column < 8 && row >= 0 && row < 8;
+	     column += sign*columns[direction], row += sign*rows[direction])
+	  whole |= 1ULL << (row*8 + column);
+      }
+
+      uint64_t passed = 0;
+      int column = from % 8 + columns[direction];
+      int row = from / 8 + rows[direction];
+      for (; column >= 0 && column < 8 && row >= 0 && row < 8;
+	   column += columns[direction], row += rows[direction]) {
+	int to = row*8 + column;
+	tables.between[from][to] = passed;
+	tables.line[from][to] = whole;
+	passed |= 1ULL << to;
+      }
+    }
+  return tables;
+}
+
+// the tables, built at compile time so they cost nothing at startup.
+inline constexpr LineTables LINES = makeLineTables();
+
+static_assert(LINES.between[0][63] == 0x0040201008040200ULL,
+	      "between holds the squares strictly between two squares");
+static_assert(LINES.line[8][15] == 0xff00ULL,
+	      "line holds the whole line through two squares");
+
+#endif
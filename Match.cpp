@@ -0,0 +1,182 @@
+#include "Match.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+
+// Elo difference at which a player is expected to score the given share.
+double eloFromScore(double score) {
+  if (score <= 0)
+    return -INFINITY;
+  if (score >= 1)
+    return INFINITY;
+  return -400 * log10(1 / score - 1);
+}
+
+// share of points a player is expected to score at an Elo difference.
+double scoreFromElo(double elo) {
+  return 1 / (1 + pow(10, -elo / 400));
+}
+
+// spread of the score of one game around the mean score.
+double scoreVariance(const MatchScore& match) {
+  double mean = match.score();
+  return (match.wins * (1 - mean) * (1 - mean)
+	  + match.losses * mean * mean
+	  + match.draws * (0.5 - mean) * (0.5 - mean)) / match.games();
+}
+
+// result of a game won by the given colour.
+GameResult winFor(Colour colour) {
+  return colour == WHITE ? WHITE_WINS : BLACK_WINS;
+}
+
+}
+
+
+bool playGame(const string& opening,
+	      Search& white, const EngineSettings& whiteSettings,
+	      Search& black, const EngineSettings& blackSettings,
+	      int maxPlies, GameRecord& game) {
+
+  // the referee asks about checks every move and never searches. the
+  // engines search a board of their own that does not pay for the maps.
+  ChessBoard board(false);
+  board.keepAttackMaps(true);
+  ChessBoard searchBoard(false);
+  if (!board.setPosition(opening) || !searchBoard.setPosition(opening))
+    return false;
+
+  game = GameRecord();
+  Search* searches[2] = {&white, &black};
+  const EngineSettings* settings[2] = {&whiteSettings, &blackSettings};
+  int clock[2] = {whiteSettings.time, blackSettings.time};
+  MoveRecord record;
+
+  for (int ply = 0; ; ply++) {
+    Colour colour = board.sideToMove();
+
+    // the game ends on the board before the clock is looked at.
+    if (board.inCheckMate(colour)) {
+      if (board.inCheck(colour)) {
+	game.result = winFor(!colour);
+	game.reason = "checkmate";
+      }
+      else {
+	game.result = DRAWN;
+	game.reason = "stalemate";
+      }
+      return true;
+    }
+    if (board.repetitionCount() >= 2) {
+      game.result = DRAWN;
+      game.reason = "threefold repetition";
+      return true;
+    }
+    if (board.halfmoveClock() >= 100) {
+      game.result = DRAWN;
+      game.reason = "fifty-move rule";
+      return true;
+    }
+    if (ply >= maxPlies) {
+      game.result = DRAWN;
+      game.reason = "move limit";
+      return true;
+    }
+
+    SearchLimits limits;
+    limits.depth = settings[colour]->depth;
+    limits.nodes = settings[colour]->nodes;
+    for (int side = 0; side < 2; side++) {
+      limits.time[side] = clock[side];
+      limits.increment[side] = settings[side]->increment;
+    }
+
+    auto start = chrono::steady_clock::now();
+    SearchResult result = searches[colour]->think(searchBoard, limits);
+    clock[colour] -= (int)chrono::duration_cast<chrono::milliseconds>
+      (chrono::steady_clock::now() - start).count();
+
+    // games without a clock are limited by depth or nodes instead.
+    if (settings[colour]->time > 0 && clock[colour] < 0) {
+      game.result = winFor(!colour);
+      game.reason = "time forfeit";
+      return true;
+    }
+    clock[colour] += settings[colour]->increment;
+
+    // castling is not covered by legalMove, so the move is looked up.
+    MoveList moves = board.legalMoves();
+    if (find(moves.begin(), moves.end(), result.bestMove) == moves.end()) {
+      game.result = winFor(!colour);
+      game.reason = "illegal move";
+      return true;
+    }
+    board.doMove(result.bestMove, record);
+    searchBoard.doMove(result.bestMove, record);
+    game.moves.push_back(result.bestMove);
+  }
+}
+
+
+int MatchScore::games() const {
+  return wins + losses + draws;
+}
+
+
+double MatchScore::score() const {
+  if (games() == 0)
+    return 0.5;
+  return (wins + 0.5 * draws) / games();
+}
+
+
+double MatchScore::elo() const {
+  return eloFromScore(score());
+}
+
+
+double MatchScore::eloMargin() const {
+
+  int count = games();
+  if (count == 0)
+    return INFINITY;
+
+  double mean = score();
+  double variance = scoreVariance(*this);
+  double deviation = sqrt(variance / count);
+
+  return (eloFromScore(mean + 1.96 * deviation)
+	  - eloFromScore(mean - 1.96 * deviation)) / 2;
+}
+
+
+double MatchScore::logLikelihoodRatio(double elo0, double elo1) const {
+
+  int count = games();
+  if (count == 0 || wins + losses == 0)
+    return 0;
+
+  double mean = score();
+  double variance = scoreVariance(*this);
+  if (variance <= 0)
+    return 0;
+
+  double score0 = scoreFromElo(elo0);
+  double score1 = scoreFromElo(elo1);
+  return count * (score1 - score0) * (2 * mean - score0 - score1)
+    / (2 * variance);
+}
+
+
+double SprtTest::lowerBound() const {
+  return log(beta / (1 - alpha));
+}
+
+
+double SprtTest::upperBound() const {
+  return log((1 - beta) / alpha);
+}
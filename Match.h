@@ -0,0 +1,79 @@
+#ifndef MATCH_H
+#define MATCH_H
+#include "ChessBoard.h"
+#include "Search.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// struct holding how one engine of a match plays. zero means no limit.
+struct EngineSettings {
+  std::string name;
+  int hashMegabytes = 16;
+  int depth = 0;
+  uint64_t nodes = 0;
+  // clock for the whole game and increment per move in milliseconds.
+  int time = 10000;
+  int increment = 100;
+};
+
+// struct holding a finished game.
+struct GameRecord {
+  GameResult result = DRAWN;
+  std::string reason;
+  std::vector<Move> moves;
+};
+
+/* function that plays a game between two searches from an opening and
+   adjudicates it by checkmate, stalemate, repetition, the fifty-move rule,
+   the clock or the move limit.
+   @param opening is the starting position in Forsyth-Edwards Notation.
+   @param white and black are the searches of each player.
+   @param whiteSettings and blackSettings hold the limits of each player.
+   @param maxPlies is the number of plies after which the game is drawn.
+   @param game is filled with the result and the moves. */
+bool playGame(const std::string& opening,
+	      Search& white, const EngineSettings& whiteSettings,
+	      Search& black, const EngineSettings& blackSettings,
+	      int maxPlies, GameRecord& game);
+
+// struct holding the games of a match from the point of view of one engine.
+struct MatchScore {
+  int wins = 0;
+  int losses = 0;
+  int draws = 0;
+
+  /* function that returns the number of games played. */
+  int games() const;
+
+  /* function that returns the share of points scored. */
+  double score() const;
+
+  /* function that returns the Elo difference implied by the score. */
+  double elo() const;
+
+  /* function that returns the half width of the 95% confidence
+     interval of the Elo difference. */
+  double eloMargin() const;
+
+  /* function that returns the log likelihood ratio of the hypothesis that
+     the difference is elo1 over the hypothesis that it is elo0, using the
+     normal approximation of the game scores.
+     @param elo0 and elo1 are the Elo differences of the two hypotheses. */
+  double logLikelihoodRatio(double elo0, double elo1) const;
+};
+
+// struct holding a sequential probability ratio test.
+struct SprtTest {
+  double elo0 = 0;
+  double elo1 = 5;
+  double alpha = 0.05;
+  double beta = 0.05;
+
+  /* functions that return the ratios at which the test accepts
+     elo0 and elo1 respectively. */
+  double lowerBound() const;
+  double upperBound() const;
+};
+
+#endif
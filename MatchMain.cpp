@@ -0,0 +1,267 @@
+#include "ChessBoard.h"
+#include "GameArchive.h"
+#include "Match.h"
+#include "Search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* plays games between two engine settings, several at a time, and
+   reports the Elo difference of the first over the second with a running
+   sequential probability ratio test. every opening is played twice with
+   colours reversed. --archive keeps the games in a game archive.
+
+   usage: match [--games N] [--concurrency N] [--openings FILE]
+                [--tc MS+MS] [--maxplies N] [--sprt ELO0 ELO1]
+                [--alpha P] [--beta P] [--archive FILE]
+                [--hash-a MB] [--depth-a N] [--nodes-a N] [--tc-a MS+MS]
+                [--hash-b MB] [--depth-b N] [--nodes-b N] [--tc-b MS+MS]
+
+   the exit status is 1 if the test accepts elo0, 0 otherwise. */
+
+namespace {
+
+// struct holding the options given on the command line.
+struct MatchOptions {
+  int games = 100;
+  int concurrency = max(1u, thread::hardware_concurrency());
+  string openings;
+  string archive;
+  int maxPlies = 400;
+  bool sprt = false;
+  SprtTest test;
+  EngineSettings engines[2];
+};
+
+/* function that reads a time control written as time+increment.
+   @param text is the time control in milliseconds, e.g. 10000+100.
+   @param settings is filled with the time control. */
+bool parseTimeControl(const string& text, EngineSettings& settings) {
+  size_t plus = text.find('+');
+  settings.time = atoi(text.substr(0, plus).c_str());
+  settings.increment = plus == string::npos ? 0
+    : atoi(text.substr(plus + 1).c_str());
+  return settings.time >= 0 && settings.increment >= 0;
+}
+
+/* function that reads one opening position per line, skipping blank
+   lines and lines starting with #.
+   @param file is the name of the file of openings.
+   @param openings is filled with the positions. */
+bool readOpenings(const string& file, vector<string>& openings) {
+  ifstream in(file);
+  if (!in)
+    return false;
+
+  ChessBoard board(false);
+  string line;
+  while (getline(in, line)) {
+    if (line.empty() || line[0] == '#')
+      continue;
+    if (!board.setPosition(line)) {
+      cerr << "match: bad opening " << line << endl;
+      return false;
+    }
+    openings.push_back(line);
+  }
+  return !openings.empty();
+}
+
+/* function that writes the score so far from the point of view of the
+   first engine. */
+void printScore(ostream& out, const MatchOptions& options,
+		const MatchScore& match) {
+
+  out << "Score of " << options.engines[0].name << " vs "
+      << options.engines[1].name << ": " << match.wins << " - "
+      << match.losses << " - " << match.draws << " [" << fixed
+      << setprecision(3) << match.score() << "] " << match.games() << endl;
+  out << "Elo difference: " << setprecision(1) << match.elo() << " +/- "
+      << match.eloMargin() << endl;
+  if (options.sprt)
+    out << "SPRT: llr " << setprecision(2)
+	<< match.logLikelihoodRatio(options.test.elo0, options.test.elo1)
+	<< " (" << options.test.lowerBound() << ", "
+	<< options.test.upperBound() << ") [" << options.test.elo0 << ", "
+	<< options.test.elo1 << "]" << endl;
+  out.unsetf(ios::floatfield);
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  MatchOptions options;
+  options.engines[0].name = "A";
+  options.engines[1].name = "B";
+  bool valid = true;
+
+  for (int i = 1; i < argc && valid; i++) {
+    bool hasValue = i + 1 < argc;
+    string option = argv[i];
+    // options ending in -a or -b apply to one engine only.
+    int first = 0, last = 1;
+    if (option.size() > 2 && option[option.size() - 2] == '-'
+	&& (option.back() == 'a' || option.back() == 'b')) {
+      first = last = option.back() - 'a';
+      option.resize(option.size() - 2);
+    }
+
+    if (option == "--games" && hasValue)
+      options.games = max(1, atoi(argv[++i]));
+    else if (option == "--concurrency" && hasValue)
+      options.concurrency = max(1, atoi(argv[++i]));
+    else if (option == "--openings" && hasValue)
+      options.openings = argv[++i];
+    else if (option == "--archive" && hasValue)
+      options.archive = argv[++i];
+    else if (option == "--maxplies" && hasValue)
+      options.maxPlies = max(1, atoi(argv[++i]));
+    else if (option == "--sprt" && i + 2 < argc) {
+      options.sprt = true;
+      options.test.elo0 = atof(argv[++i]);
+      options.test.elo1 = atof(argv[++i]);
+    }
+    else if (option == "--alpha" && hasValue)
+      options.test.alpha = atof(argv[++i]);
+    else if (option == "--beta" && hasValue)
+      options.test.beta = atof(argv[++i]);
+    else if (option == "--tc" && hasValue) {
+      i++;
+      for (int engine = first; engine <= last; engine++)
+	valid = valid && parseTimeControl(argv[i], options.engines[engine]);
+    }
+    else if (option == "--hash" && hasValue) {
+      i++;
+      for (int engine = first; engine <= last; engine++)
+	options.engines[engine].hashMegabytes = max(1, atoi(argv[i]));
+    }
+    else if (option == "--depth" && hasValue) {
+      i++;
+      for (int engine = first; engine <= last; engine++)
+	options.engines[engine].depth = max(0, atoi(argv[i]));
+    }
+    else if (option == "--nodes" && hasValue) {
+      i++;
+      for (int engine = first; engine <= last; engine++)
+	options.engines[engine].nodes = strtoull(argv[i], nullptr, 10);
+    }
+    else
+      valid = false;
+  }
+
+  if (!valid || options.test.alpha <= 0 || options.test.beta <= 0
+      || options.test.alpha >= 1 || options.test.beta >= 1) {
+    cerr << "usage: match [--games N] [--concurrency N] [--openings FILE]"
+	 << " [--tc MS+MS] [--maxplies N] [--sprt ELO0 ELO1] [--alpha P]"
+	 << " [--beta P] [--archive FILE] [--hash-a MB] [--depth-a N] [--nodes-a N]"
+	 << " [--tc-a MS+MS] [--hash-b MB] [--depth-b N] [--nodes-b N]"
+	 << " [--tc-b MS+MS]" << endl;
+    return 1;
+  }
+
+  vector<string> openings;
+  if (options.openings.empty())
+    openings.push_back(START_POSITION);
+  else if (!readOpenings(options.openings, openings)) {
+    cerr << "match: cannot read openings from " << options.openings << endl;
+    return 1;
+  }
+
+  GameArchiveWriter archive;
+  if (!options.archive.empty() && !archive.open(options.archive, true)) {
+    cerr << "match: cannot write " << options.archive << endl;
+    return 1;
+  }
+
+  // games come in pairs so each opening is played from both sides.
+  int games = options.games + options.games % 2;
+
+  MatchScore match;
+  mutex matchLock;
+  atomic<int> nextGame(0);
+  atomic<bool> finished(false);
+  bool acceptedNull = false;
+
+  auto work = [&]() {
+    // each thread keeps its own searches and so its own tables.
+    Search searches[2] = {Search(options.engines[0].hashMegabytes),
+			  Search(options.engines[1].hashMegabytes)};
+    GameRecord game;
+
+    for (int index = nextGame++; index < games && !finished;
+	 index = nextGame++) {
+      const string& opening = openings[(index / 2) % openings.size()];
+      // the first engine has white in even games.
+      int whiteEngine = index % 2;
+      int blackEngine = 1 - whiteEngine;
+      searches[0].clearHash();
+      searches[1].clearHash();
+
+      if (!playGame(opening, searches[whiteEngine],
+		    options.engines[whiteEngine], searches[blackEngine],
+		    options.engines[blackEngine], options.maxPlies, game))
+	continue;
+
+      lock_guard<mutex> lock(matchLock);
+      if (!options.archive.empty())
+	archive.addGame(opening, game.moves, game.result);
+      if (game.result == DRAWN)
+	match.draws++;
+      else if ((game.result == WHITE_WINS) == (whiteEngine == 0))
+	match.wins++;
+      else
+	match.losses++;
+
+      cout << "Finished game " << index + 1 << " ("
+	   << options.engines[whiteEngine].name << " vs "
+	   << options.engines[blackEngine].name << "): "
+	   << (game.result == WHITE_WINS ? "1-0"
+	       : game.result == BLACK_WINS ? "0-1" : "1/2-1/2")
+	   << " {" << game.reason << ", " << game.moves.size()
+	   << " plies}" << endl;
+      printScore(cout, options, match);
+
+      if (options.sprt) {
+	double ratio = match.logLikelihoodRatio(options.test.elo0,
+						options.test.elo1);
+	if (ratio <= options.test.lowerBound()
+	    || ratio >= options.test.upperBound()) {
+	  acceptedNull = ratio <= options.test.lowerBound();
+	  finished = true;
+	}
+      }
+    }
+  };
+
+  vector<thread> workers;
+  for (int i = 0; i < options.concurrency; i++)
+    workers.emplace_back(work);
+  for (thread& worker : workers)
+    worker.join();
+
+  if (!options.archive.empty() && !archive.close())
+    cerr << "match: cannot write " << options.archive << endl;
+
+  cout << "Finished match" << endl;
+  printScore(cout, options, match);
+  if (options.sprt && finished)
+    cout << "SPRT: " << (acceptedNull ? "H0" : "H1") << " accepted" << endl;
+  else if (options.sprt)
+    cout << "SPRT: inconclusive" << endl;
+
+  return acceptedNull ? 1 : 0;
+}
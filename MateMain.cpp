@@ -0,0 +1,190 @@
+#include "ChessBoard.h"
+#include "Epd.h"
+#include "MateSolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* proves or disproves mates in positions of an EPD file with the
+   proof-number mate solver, several positions at a time, each thread
+   with its own solver. every position is searched for its shortest
+   mate, of at most as many moves as its dm operation gives or else of
+   at most --moves moves, 5 unless told otherwise. a position with a dm
+   is confirmed by a mate in exactly that many moves and reported as
+   cooked if a shorter mate is found.
+
+   usage: mate FILE [--moves N] [--nodes N] [--threads N] [--hash MB] */
+
+namespace {
+
+// struct holding the options given on the command line.
+struct MateOptions {
+  string file;
+  int moves = 5;
+  uint64_t nodes = 0;
+  int threads = max(1u, thread::hardware_concurrency());
+  int hashMegabytes = 64;
+};
+
+// struct holding the outcome of one position.
+struct MateOutcome {
+  bool valid = false;
+  MateResult result;
+  string line;
+  int elapsed = 0;
+};
+
+/* function that writes a mating line in standard algebraic notation,
+   marking checks and the mate.
+   @param board holds the position the line starts from. */
+string lineText(ChessBoard& board, const vector<Move>& line) {
+  string text;
+  vector<MoveRecord> records(line.size());
+  for (size_t i = 0; i < line.size(); i++) {
+    text += (i ? " " : "") + moveSan(board, line[i]);
+    board.doMove(line[i], records[i]);
+    if (board.inCheck(board.sideToMove()))
+      text += i + 1 == line.size() ? "#" : "+";
+  }
+  for (size_t i = line.size(); i > 0; i--)
+    board.undoMove(records[i - 1]);
+  return text;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  MateOptions options;
+  bool valid = argc > 1;
+  for (int i = 1; i < argc && valid; i++) {
+    if (!strcmp(argv[i], "--moves") && i + 1 < argc)
+      options.moves = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--nodes") && i + 1 < argc)
+      options.nodes = strtoull(argv[++i], nullptr, 10);
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      options.hashMegabytes = max(1, atoi(argv[++i]));
+    else if (argv[i][0] != '-' && options.file.empty())
+      options.file = argv[i];
+    else
+      valid = false;
+  }
+  if (!valid || options.file.empty()) {
+    cerr << "usage: mate FILE [--moves N] [--nodes N] [--threads N]"
+	 << " [--hash MB]" << endl;
+    return 1;
+  }
+
+  ifstream in(options.file);
+  if (!in) {
+    cerr << "mate: cannot read " << options.file << endl;
+    return 1;
+  }
+  vector<EpdRecord> records;
+  string line;
+  while (getline(in, line)) {
+    EpdRecord record;
+    if (line.empty() || line[0] == '#' || !parseEpd(line, record))
+      continue;
+    if (record.id.empty())
+      record.id = to_string(records.size() + 1);
+    records.push_back(record);
+  }
+
+  vector<MateOutcome> outcomes(records.size());
+  atomic<size_t> nextRecord(0);
+  mutex outputLock;
+
+  auto work = [&]() {
+    MateSolver solver(options.hashMegabytes);
+    ChessBoard board(false);
+    for (size_t i = nextRecord++; i < records.size(); i = nextRecord++) {
+      const EpdRecord& record = records[i];
+      MateOutcome& outcome = outcomes[i];
+      int moves = record.directMate > 0 ? record.directMate : options.moves;
+      if (board.setPosition(record.fen)) {
+	// proof numbers hold for a position whatever puzzle it came from,
+	// so the table is kept from one position to the next.
+	auto start = chrono::steady_clock::now();
+	outcome.result = solver.solve(board, moves, options.nodes);
+	outcome.elapsed = (int)chrono::duration_cast<chrono::milliseconds>
+	  (chrono::steady_clock::now() - start).count();
+	outcome.line = lineText(board, outcome.result.line);
+	outcome.valid = true;
+      }
+
+      lock_guard<mutex> lock(outputLock);
+      cout << left << setw(16) << record.id << right;
+      if (!outcome.valid) {
+	cout << " skipped, position not understood" << endl;
+	continue;
+      }
+      if (outcome.result.status == MATE_FOUND)
+	cout << " mate in " << outcome.result.moves << ": " << outcome.line;
+      else if (outcome.result.status == NO_MATE)
+	cout << " no mate in " << moves;
+      else
+	cout << " unknown, out of nodes";
+      if (record.directMate > 0 && outcome.result.status == MATE_FOUND
+	  && outcome.result.moves < record.directMate)
+	cout << "  cooked, expected dm " << record.directMate;
+      else if (record.directMate > 0)
+	cout << "  expected dm " << record.directMate;
+      cout << "  nodes " << outcome.result.nodes << " time "
+	   << outcome.elapsed << " ms" << endl;
+    }
+  };
+
+  vector<thread> workers;
+  for (int i = 0; i < options.threads; i++)
+    workers.emplace_back(work);
+  for (thread& worker : workers)
+    worker.join();
+
+  int counted = 0, mates = 0, unknown = 0, expected = 0, confirmed = 0;
+  int cooked = 0;
+  uint64_t nodes = 0, elapsed = 0;
+  for (size_t i = 0; i < records.size(); i++) {
+    const MateOutcome& outcome = outcomes[i];
+    if (!outcome.valid)
+      continue;
+    counted++;
+    nodes += outcome.result.nodes;
+    elapsed += outcome.elapsed;
+    mates += outcome.result.status == MATE_FOUND;
+    unknown += outcome.result.status == MATE_UNKNOWN;
+    if (records[i].directMate > 0) {
+      expected++;
+      if (outcome.result.status == MATE_FOUND) {
+	confirmed += outcome.result.moves == records[i].directMate;
+	cooked += outcome.result.moves < records[i].directMate;
+      }
+    }
+  }
+
+  cout << "mates " << mates << ", no mate " << counted - mates - unknown
+       << ", unknown " << unknown << " of " << counted << ", "
+       << records.size() - counted << " skipped" << endl;
+  if (expected > 0)
+    cout << "confirmed " << confirmed << " of " << expected
+	 << " positions with dm, " << cooked << " cooked" << endl;
+  cout << "total solve time " << elapsed << " ms, nodes " << nodes
+       << ", nps " << (elapsed ? nodes * 1000 / elapsed : 0) << endl;
+  return confirmed == expected ? 0 : 1;
+}
@@ -0,0 +1,274 @@
+#include "MateSolver.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// proof or disproof number standing for infinity, that of a solved node.
+const uint32_t INFINITE_PROOF = 1u << 30;
+
+// entries of the table sharing an index.
+const int BUCKET_SIZE = 2;
+
+// mixes what a position stands for in the search into its key, so the
+// same position with other moves left or the other side mating differs.
+uint64_t nodeSalt(bool attacking, int movesLeft) {
+  return ((uint64_t)movesLeft * 2 + attacking + 1) * 0x9E3779B97F4A7C15ULL;
+}
+
+// sum of two proof numbers, infinite if either is and short of it if not.
+uint32_t addProof(uint32_t sum, uint32_t term) {
+  if (sum >= INFINITE_PROOF || term >= INFINITE_PROOF)
+    return INFINITE_PROOF;
+  return min(sum + term, INFINITE_PROOF - 1);
+}
+
+}
+
+
+MateSolver::MateSolver(int hashMegabytes) {
+
+  uint64_t count = BUCKET_SIZE;
+  uint64_t bytes = (uint64_t)(hashMegabytes > 0 ? hashMegabytes : 1) << 20;
+  while (count * 2 * sizeof(Entry) <= bytes)
+    count *= 2;
+
+  entries.reset(new Entry[count]);
+  mask = count / BUCKET_SIZE - 1;
+  clear();
+}
+
+
+void MateSolver::clear() {
+  for (uint64_t i = 0; i < (mask + 1) * BUCKET_SIZE; i++)
+    entries[i] = {0, 1, 1, 0, 0};
+}
+
+
+MateResult MateSolver::solve(ChessBoard& board, int maxMoves,
+			     uint64_t nodeLimit) {
+
+  this->board = &board;
+  this->nodeLimit = nodeLimit;
+  nodes = 0;
+
+  // each length is tried in turn, so the first mate proved is the shortest.
+  MateResult result;
+  result.status = NO_MATE;
+  for (int moves = 1; moves <= maxMoves; moves++) {
+    ProofNumbers numbers;
+    proofSearch(true, moves, INFINITE_PROOF, INFINITE_PROOF, numbers);
+    if (numbers.proof == 0) {
+      result.status = MATE_FOUND;
+      result.moves = moves;
+      this->nodeLimit = 0;
+      mateLine(moves, result.line);
+      break;
+    }
+    // a node neither proved nor disproved ran out of nodes.
+    if (numbers.disproof != 0) {
+      result.status = MATE_UNKNOWN;
+      break;
+    }
+  }
+  result.nodes = nodes;
+  return result;
+}
+
+
+void MateSolver::proofSearch(bool attacking, int movesLeft,
+			     uint32_t proofLimit, uint32_t disproofLimit,
+			     ProofNumbers& numbers) {
+
+  uint64_t key = nodeKey(attacking, movesLeft);
+  lookup(key, numbers);
+  if (numbers.proof >= proofLimit || numbers.disproof >= disproofLimit)
+    return;
+  uint64_t startNodes = nodes++;
+
+  // with no moves left only a mate already on the board counts, and a
+  // side not in check cannot be mated.
+  Colour colour = board->sideToMove();
+  if (!attacking && movesLeft == 0 && !board->inCheck(colour)) {
+    numbers = {INFINITE_PROOF, 0, 0};
+    store(key, numbers, 1);
+    return;
+  }
+
+  MoveList moves = board->legalMoves();
+  if (moves.empty()) {
+    if (!attacking && board->inCheck(colour))
+      numbers = {0, INFINITE_PROOF, 0};
+    else
+      numbers = {INFINITE_PROOF, 0, 0};
+    store(key, numbers, 1);
+    return;
+  }
+  if (!attacking && movesLeft == 0) {
+    numbers = {INFINITE_PROOF, 0, 0};
+    store(key, numbers, 1);
+    return;
+  }
+
+  // the numbers of the children are looked up once and then kept here.
+  ProofNumbers children[MAX_MOVES];
+  int childMovesLeft = attacking ? movesLeft - 1 : movesLeft;
+  MoveRecord record;
+  for (size_t i = 0; i < moves.size(); i++) {
+    board->doMove(moves[i], record);
+    lookup(nodeKey(!attacking, childMovesLeft), children[i]);
+    board->undoMove(record);
+  }
+
+  while (true) {
+    /* the mating side needs one child proved and the other side needs
+       one disproved, so a node takes the least of those numbers of its
+       children and the sum of the others. */
+    uint32_t least = INFINITE_PROOF;
+    uint32_t second = INFINITE_PROOF;
+    uint32_t sum = 0;
+    size_t best = 0;
+    for (size_t i = 0; i < moves.size(); i++) {
+      uint32_t chosen = attacking ? children[i].proof : children[i].disproof;
+      sum = addProof(sum, attacking ? children[i].disproof
+		     : children[i].proof);
+      if (chosen < least) {
+	second = least;
+	least = chosen;
+	best = i;
+      }
+      else if (chosen < second)
+	second = chosen;
+    }
+    numbers.proof = attacking ? least : sum;
+    numbers.disproof = attacking ? sum : least;
+
+    // a proved node mates as fast as the mating side can manage and as
+    // slowly as the other side can.
+    if (numbers.proof == 0) {
+      numbers.distance = attacking ? INFINITE_PROOF : 0;
+      for (size_t i = 0; i < moves.size(); i++)
+	if (children[i].proof == 0)
+	  numbers.distance = attacking
+	    ? min(numbers.distance, children[i].distance + 1)
+	    : max(numbers.distance, children[i].distance + 1);
+    }
+
+    if (numbers.proof >= proofLimit || numbers.disproof >= disproofLimit
+	|| (nodeLimit != 0 && nodes >= nodeLimit))
+      break;
+
+    /* the most proving child is searched until it is no longer the best
+       choice, i.e. its number passes that of the second best, or until
+       the node reaches its own thresholds. */
+    ProofNumbers& child = children[best];
+    uint32_t childProof, childDisproof;
+    if (attacking) {
+      childProof = min(proofLimit, second + 1);
+      childDisproof = disproofLimit >= INFINITE_PROOF ? INFINITE_PROOF
+	: disproofLimit - numbers.disproof + child.disproof;
+    }
+    else {
+      childDisproof = min(disproofLimit, second + 1);
+      childProof = proofLimit >= INFINITE_PROOF ? INFINITE_PROOF
+	: proofLimit - numbers.proof + child.proof;
+    }
+    board->doMove(moves[best], record);
+    proofSearch(!attacking, childMovesLeft, childProof, childDisproof, child);
+    board->undoMove(record);
+  }
+
+  store(key, numbers, nodes - startNodes);
+}
+
+
+void MateSolver::mateLine(int movesLeft, vector<Move>& line) {
+
+  vector<MoveRecord> records;
+  bool attacking = true;
+
+  while (true) {
+    MoveList moves = board->legalMoves();
+    if (moves.empty())
+      break;
+    int childMovesLeft = attacking ? movesLeft - 1 : movesLeft;
+
+    /* the mating side plays the quickest mate the table still holds,
+       searching its moves in turn should the table have lost them all.
+       every reply of the other side is proved, so each is searched,
+       which costs nothing for those still in the table. */
+    Move chosen = NO_MOVE;
+    uint32_t distance = 0;
+    MoveRecord record;
+    for (int pass = 0; pass < (attacking ? 2 : 1) && chosen == NO_MOVE;
+	 pass++)
+      for (Move move : moves) {
+	ProofNumbers child;
+	board->doMove(move, record);
+	if (attacking && pass == 0)
+	  lookup(nodeKey(false, childMovesLeft), child);
+	else
+	  proofSearch(!attacking, childMovesLeft, INFINITE_PROOF,
+		      INFINITE_PROOF, child);
+	board->undoMove(record);
+
+	if (child.proof == 0 && (chosen == NO_MOVE
+				 || (attacking ? child.distance < distance
+				     : child.distance > distance))) {
+	  chosen = move;
+	  distance = child.distance;
+	  if (attacking && pass == 1)
+	    break;
+	}
+      }
+    if (chosen == NO_MOVE)
+      break;
+
+    line.push_back(chosen);
+    records.emplace_back();
+    board->doMove(chosen, records.back());
+    attacking = !attacking;
+    movesLeft = childMovesLeft;
+  }
+
+  while (!records.empty()) {
+    board->undoMove(records.back());
+    records.pop_back();
+  }
+}
+
+
+uint64_t MateSolver::nodeKey(bool attacking, int movesLeft) const {
+  return board->positionKey() ^ nodeSalt(attacking, movesLeft);
+}
+
+
+void MateSolver::lookup(uint64_t key, ProofNumbers& numbers) const {
+
+  const Entry* bucket = &entries[(key & mask) * BUCKET_SIZE];
+  for (int i = 0; i < BUCKET_SIZE; i++)
+    if (bucket[i].key == key) {
+      numbers = {bucket[i].proof, bucket[i].disproof, bucket[i].distance};
+      return;
+    }
+  numbers = {1, 1, 0};
+}
+
+
+void MateSolver::store(uint64_t key, const ProofNumbers& numbers,
+		       uint64_t work) {
+
+  Entry* bucket = &entries[(key & mask) * BUCKET_SIZE];
+  Entry* slot = &bucket[0];
+  for (int i = 0; i < BUCKET_SIZE; i++) {
+    if (bucket[i].key == key) {
+      slot = &bucket[i];
+      break;
+    }
+    if (bucket[i].work < slot->work)
+      slot = &bucket[i];
+  }
+  *slot = {key, numbers.proof, numbers.disproof, numbers.distance,
+	   (uint32_t)min<uint64_t>(work, UINT32_MAX)};
+}
@@ -0,0 +1,103 @@
+#ifndef MATESOLVER_H
+#define MATESOLVER_H
+#include "ChessBoard.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// what a mate search found out about a position.
+enum MateStatus {MATE_FOUND, NO_MATE, MATE_UNKNOWN};
+
+// struct holding the outcome of a mate search.
+struct MateResult {
+  MateStatus status = MATE_UNKNOWN;
+  // moves of the side to move until mate, when one was found.
+  int moves = 0;
+  // the mating line, the defence resisting longest.
+  std::vector<Move> line;
+  uint64_t nodes = 0;
+};
+
+/* solver proving or disproving that the side to move mates within a
+   number of moves, with depth-first proof-number search (df-pn). every
+   node has a proof number, the least number of leaves that must turn
+   out mates to prove it, and a disproof number, the least that must
+   turn out otherwise to disprove it. the search always expands the most
+   proving node, staying below a subtree for as long as its numbers keep
+   within thresholds, and keeps the numbers of the nodes it leaves in a
+   table of fixed size rather than a tree, so memory stays bounded. one
+   solver serves one thread. */
+class MateSolver {
+
+public:
+
+  /* constructor for the solver.
+     @param hashMegabytes is the size of the table of proof numbers. */
+  MateSolver(int hashMegabytes = 16);
+
+  /* function that finds the shortest mate of the side to move of at most
+     a number of moves, trying each number of moves in turn. draws by
+     rule are not considered, as in composed problems.
+     @param board holds the position, and is back to it when done.
+     @param maxMoves is the most moves the mate may take.
+     @param nodeLimit is the most nodes to search, 0 for no limit. */
+  MateResult solve(ChessBoard& board, int maxMoves, uint64_t nodeLimit = 0);
+
+  /* function that empties the table. */
+  void clear();
+
+private:
+
+  // struct holding the proof and disproof numbers of a node and, once it
+  // is proved, the plies to mate along the longest defence.
+  struct ProofNumbers {
+    uint32_t proof;
+    uint32_t disproof;
+    uint32_t distance;
+  };
+
+  /* function that searches a node until its proof or disproof number
+     reaches its threshold or the node limit is reached.
+     @param attacking is whether the mating side is to move.
+     @param movesLeft is the number of moves the mating side has left.
+     @param proofLimit and disproofLimit are the thresholds.
+     @param numbers is set to the numbers of the node when done. */
+  void proofSearch(bool attacking, int movesLeft, uint32_t proofLimit,
+		   uint32_t disproofLimit, ProofNumbers& numbers);
+
+  /* function that follows a proved node to mate, the mating side taking
+     the quickest mate and the other side the longest defence.
+     @param movesLeft is the number of moves the mating side has left.
+     @param line is filled with the moves. */
+  void mateLine(int movesLeft, std::vector<Move>& line);
+
+  /* function that returns the table key of the position on the board as
+     a node of the search. */
+  uint64_t nodeKey(bool attacking, int movesLeft) const;
+
+  /* function that looks a node up in the table, setting its numbers to
+     those of a fresh leaf if it is not there. */
+  void lookup(uint64_t key, ProofNumbers& numbers) const;
+
+  /* function that stores the numbers of a node in the table.
+     @param work is the number of nodes spent on the node, the entry
+     with less work giving way when a bucket is full. */
+  void store(uint64_t key, const ProofNumbers& numbers, uint64_t work);
+
+  struct Entry {
+    uint64_t key;
+    uint32_t proof;
+    uint32_t disproof;
+    uint32_t distance;
+    uint32_t work;
+  };
+
+  std::unique_ptr<Entry[]> entries;
+  uint64_t mask = 0;
+
+  ChessBoard* board = nullptr;
+  uint64_t nodes = 0;
+  uint64_t nodeLimit = 0;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "Numa.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const string NODE_PATH = "/sys/devices/system/node/";
+const string CPU_PATH = "/sys/devices/system/cpu/";
+
+// bits of the node masks given to the kernel, which reads one bit fewer.
+const unsigned long MASK_BITS = 8 * sizeof(unsigned long);
+
+/* function that reads a list such as "0-3,8-11" from a file of /sys,
+   returning an empty list if the file cannot be read. */
+vector<int> readList(const string& path) {
+
+  vector<int> numbers;
+  ifstream in(path);
+  string text;
+  if (!(in >> text))
+    return numbers;
+
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find(',', start);
+    if (end == string::npos)
+      end = text.size();
+    string range = text.substr(start, end - start);
+    size_t dash = range.find('-');
+    int first = atoi(range.c_str());
+    int last = dash == string::npos ? first : atoi(range.c_str() + dash + 1);
+    for (int number = first; number <= last; number++)
+      numbers.push_back(number);
+    start = end + 1;
+  }
+  return numbers;
+}
+
+/* function that keeps the cpus the process may run on and moves the
+   first thread of every core ahead of the second threads of cores, which
+   share its execution units. */
+void arrangeCpus(vector<int>& cpus, const cpu_set_t& allowed) {
+
+  vector<int> cores, seconds;
+  for (int cpu : cpus) {
+    if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))
+      continue;
+    vector<int> siblings = readList(CPU_PATH + "cpu" + to_string(cpu)
+				    + "/topology/thread_siblings_list");
+    if (siblings.empty() || siblings[0] == cpu)
+      cores.push_back(cpu);
+    else
+      seconds.push_back(cpu);
+  }
+  cpus = cores;
+  cpus.insert(cpus.end(), seconds.begin(), seconds.end());
+}
+
+/* function that reads the nodes of the machine and their cpus. */
+NumaTopology readTopology() {
+
+  NumaTopology topology;
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      CPU_SET(cpu, &allowed);
+
+  // nodes without cpus, holding only memory, have no threads to place.
+  for (int node : readList(NODE_PATH + "online")) {
+    vector<int> cpus = readList(NODE_PATH + "node" + to_string(node)
+				+ "/cpulist");
+    arrangeCpus(cpus, allowed);
+    if (cpus.empty())
+      continue;
+    topology.nodeIds.push_back(node);
+    topology.nodeCpus.push_back(cpus);
+  }
+
+  if (topology.nodeCpus.empty()) {
+    vector<int> cpus = readList(CPU_PATH + "online");
+    int count = (int)max(1u, thread::hardware_concurrency());
+    if (cpus.empty())
+      for (int cpu = 0; cpu < count; cpu++)
+	cpus.push_back(cpu);
+    arrangeCpus(cpus, allowed);
+    if (cpus.empty())
+      cpus.push_back(0);
+    topology.nodeIds.push_back(0);
+    topology.nodeCpus.push_back(cpus);
+  }
+  return topology;
+}
+
+/* function that sets the memory policy of the calling thread.
+   @param mode is one of the MPOL_ modes of the kernel.
+   @param mask holds a bit for each node the policy uses. */
+bool setPolicy(int mode, unsigned long mask) {
+  return syscall(SYS_set_mempolicy, mode, mask ? &mask : nullptr,
+		 mask ? MASK_BITS : 0) == 0;
+}
+
+}
+
+
+int NumaTopology::cpuCount() const {
+  int count = 0;
+  for (const vector<int>& cpus : nodeCpus)
+    count += (int)cpus.size();
+  return count;
+}
+
+
+void NumaTopology::place(int index, int& node, int& cpu) const {
+
+  index %= cpuCount();
+  node = 0;
+  while (index >= (int)nodeCpus[node].size())
+    index -= (int)nodeCpus[node++].size();
+  cpu = nodeCpus[node][index];
+}
+
+
+const NumaTopology& numaTopology() {
+  static const NumaTopology topology = readTopology();
+  return topology;
+}
+
+
+int pinThread(int index) {
+
+  const NumaTopology& topology = numaTopology();
+  int node, cpu;
+  topology.place(index, node, cpu);
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    return -1;
+
+  // pages come from the node of the cpu while it has free memory and from
+  // the nearest others after, even if the process was started with
+  // another policy.
+  if ((unsigned long)topology.nodeIds[node] < MASK_BITS - 1)
+    setPolicy(MPOL_PREFERRED, 1UL << topology.nodeIds[node]);
+  return node;
+}
+
+
+InterleavedMemory::InterleavedMemory() {
+
+  const NumaTopology& topology = numaTopology();
+  unsigned long mask = 0;
+  for (int node : topology.nodeIds)
+    if ((unsigned long)node < MASK_BITS - 1)
+      mask |= 1UL << node;
+  interleaved = topology.nodeIds.size() > 1
+    && setPolicy(MPOL_INTERLEAVE, mask);
+}
+
+
+InterleavedMemory::~InterleavedMemory() {
+  if (interleaved)
+    setPolicy(MPOL_DEFAULT, 0);
+}
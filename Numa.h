@@ -0,0 +1,65 @@
+#ifndef NUMA_H
+#define NUMA_H
+#include <vector>
+
+/* placement of threads and memory on machines with several NUMA nodes,
+   one per socket on the usual server, read from the Linux topology in
+   /sys. a thread pinned to a cpu allocates what it touches first on the
+   node of that cpu, so the tables a pinned worker and its searches build
+   for themselves stay beside them; memory shared by every thread is
+   better spread over all nodes, so no one node's memory bus carries all
+   of it. where /sys holds no nodes, the machine is taken as one node
+   with every online cpu. */
+
+// struct holding the cpus of each node of the machine.
+struct NumaTopology {
+  // number the kernel gives each node.
+  std::vector<int> nodeIds;
+  // cpus of each node, one thread of every core before any second one.
+  std::vector<std::vector<int>> nodeCpus;
+
+  /* function that returns the number of cpus of every node together. */
+  int cpuCount() const;
+
+  /* function that finds where a thread of a pool is placed, filling the
+     cores of one node before moving to the next and wrapping around once
+     every cpu has a thread.
+     @param index is the number of the thread in its pool.
+     @param node is set to the position of the node in nodeIds.
+     @param cpu is set to the cpu of the thread. */
+  void place(int index, int& node, int& cpu) const;
+};
+
+/* function that returns the topology of the machine, read once. */
+const NumaTopology& numaTopology();
+
+/* function that pins the calling thread to the cpu a thread of a pool is
+   placed on, and has it allocate on the node of that cpu. threads it
+   starts later, such as the thread of a search, inherit both.
+   @param index is the number of the thread in its pool.
+   returns the position of the node of the thread in nodeIds, or -1 if
+   it could not be pinned. */
+int pinThread(int index);
+
+/* object that, while it lives, spreads the pages the calling thread
+   touches first over every node, page by page. */
+class InterleavedMemory {
+
+public:
+
+  /* constructor setting the memory policy of the calling thread. */
+  InterleavedMemory();
+
+  /* destructor putting back the policy of allocating locally. */
+  ~InterleavedMemory();
+
+  InterleavedMemory(const InterleavedMemory&) = delete;
+  InterleavedMemory& operator=(const InterleavedMemory&) = delete;
+
+private:
+
+  // whether the policy was changed, the machine having several nodes.
+  bool interleaved;
+};
+
+#endif
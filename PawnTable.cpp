@@ -0,0 +1,131 @@
+#include "PawnTable.h"
+
+namespace {
+
+const uint64_t FILE_A = 0x0101010101010101ULL;
+
+uint64_t fileMask(int column) {
+  if (column < 0 || column > 7)
+    return 0;
+  return FILE_A << column;
+}
+
+// rows strictly ahead of a row from the point of view of a colour.
+uint64_t aheadMask(int row, int colour) {
+  if (colour == 0)
+    return row >= 7 ? 0 : ~0ULL << (8 * (row + 1));
+  return row <= 0 ? 0 : (1ULL << (8 * row)) - 1;
+}
+
+}
+
+
+PawnTable::PawnTable(int size) {
+
+  uint64_t count = 1;
+  while (count * 2 <= (uint64_t)(size > 0 ? size : 1))
+    count *= 2;
+  entries.assign(count, PawnEntry());
+  mask = count - 1;
+
+  // a board without pawns has a key of zero, so unused entries need another.
+  for (PawnEntry& entry : entries)
+    entry.key = ~0ULL;
+}
+
+
+const PawnEntry& PawnTable::probe(uint64_t key, uint64_t whitePawns,
+				  uint64_t blackPawns) {
+
+  probes++;
+  PawnEntry& entry = entries[key & mask];
+  if (entry.key == key) {
+    hits++;
+    return entry;
+  }
+
+  entry.key = key;
+  evaluatePawns(entry, whitePawns, blackPawns);
+  return entry;
+}
+
+
+double PawnTable::hitRate() const {
+  return probes ? (double)hits / probes : 0.0;
+}
+
+
+void PawnTable::evaluatePawns(PawnEntry& entry, uint64_t whitePawns,
+			      uint64_t blackPawns) {
+
+  int score[2] = {0, 0};
+  uint64_t pawns[2] = {whitePawns, blackPawns};
+
+  for (int colour = 0; colour < 2; colour++) {
+    uint64_t own = pawns[colour];
+    uint64_t enemy = pawns[1 - colour];
+    int direction = colour == 0 ? 1 : -1;
+    entry.passed[colour] = 0;
+
+    for (uint64_t remaining = own; remaining; remaining &= remaining - 1) {
+      int square = __builtin_ctzll(remaining);
+      int column = square % 8;
+      int row = square / 8;
+      int relativeRow = colour == 0 ? row : 7 - row;
+      uint64_t file = fileMask(column);
+      uint64_t adjacent = fileMask(column - 1) | fileMask(column + 1);
+      uint64_t ahead = aheadMask(row, colour);
+
+      // a pawn with another of its colour ahead on the file is doubled.
+      if (own & file & ahead)
+	score[colour] -= DOUBLED_PENALTY;
+
+      bool isolated = !(own & adjacent);
+      if (isolated)
+	score[colour] -= ISOLATED_PENALTY;
+
+      // no enemy pawn ahead on this or the adjacent files.
+      if (!(enemy & (file | adjacent) & ahead)) {
+	entry.passed[colour] |= 1ULL << square;
+	score[colour] += PASSED_BONUS[relativeRow];
+      }
+
+      /* backward: every neighbouring pawn is ahead of it, and the square
+	 it would advance to is attacked by an enemy pawn. */
+      int stopRow = row + direction;
+      if (!isolated && !(own & adjacent & ~ahead) && stopRow >= 0
+	  && stopRow <= 7) {
+	int attackRow = stopRow + direction;
+	if (attackRow >= 0 && attackRow <= 7
+	    && (enemy & adjacent & (0xFFULL << (8 * attackRow))))
+	  score[colour] -= BACKWARD_PENALTY;
+      }
+    }
+
+    // shield in front of a king on its back rows, for each king column.
+    int nearRow = colour == 0 ? 1 : 6;
+    int farRow = colour == 0 ? 2 : 5;
+    for (int kingColumn = 0; kingColumn < 8; kingColumn++) {
+      int shelter = 0;
+      for (int column = kingColumn - 1; column <= kingColumn + 1; column++) {
+	if (column < 0 || column > 7)
+	  continue;
+	if (own & (1ULL << (nearRow * 8 + column)))
+	  shelter += SHIELD_NEAR;
+	else if (own & (1ULL << (farRow * 8 + column)))
+	  shelter += SHIELD_FAR;
+	else
+	  shelter += SHIELD_MISSING;
+      }
+      entry.shelter[colour][kingColumn] = (int8_t)shelter;
+    }
+  }
+
+  entry.score = (int16_t)(score[0] - score[1]);
+}
+
+
+PawnTable& threadPawnTable() {
+  thread_local PawnTable table;
+  return table;
+}
@@ -0,0 +1,69 @@
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+#include <cstdint>
+#include <vector>
+
+// bonus for a passed pawn by how far it has advanced. pawns are not
+// promoted under these rules, so a pawn on the last row is worth nothing.
+const int PASSED_BONUS[8] = {0, 5, 10, 15, 25, 35, 45, 0};
+const int DOUBLED_PENALTY = 12;
+const int ISOLATED_PENALTY = 15;
+const int BACKWARD_PENALTY = 10;
+
+// shield scores for a pawn one or two rows ahead of the king, or none.
+const int SHIELD_NEAR = 10;
+const int SHIELD_FAR = 5;
+const int SHIELD_MISSING = -10;
+
+// struct holding the cached evaluation of one pawn structure.
+struct PawnEntry {
+  uint64_t key;
+  // pawns that no enemy pawn can stop, one bitboard per colour.
+  uint64_t passed[2];
+  // score of the pawn terms from white's point of view.
+  int16_t score;
+  // pawn shield in front of a king standing in each column, per colour.
+  int8_t shelter[2][8];
+};
+
+class PawnTable {
+
+public:
+
+  /* constructor for the table.
+     @param entries is the number of pawn structures kept, a power of two. */
+  PawnTable(int entries = 16384);
+
+  /* function that returns the evaluation of a pawn structure, working it
+     out and storing it if the structure is not in the table.
+     @param key is the pawn structure key of the board.
+     @param whitePawns and blackPawns are bitboards of the pawns, bit
+     row*8 + column set for each pawn. */
+  const PawnEntry& probe(uint64_t key, uint64_t whitePawns,
+			 uint64_t blackPawns);
+
+  /* function that returns the share of probes found in the table. */
+  double hitRate() const;
+
+  // counters of probes and of probes found in the table.
+  uint64_t probes = 0;
+  uint64_t hits = 0;
+
+private:
+
+  /* function that evaluates passed, isolated, doubled and backward pawns
+     and pawn shields of a pawn structure.
+     @param entry is filled with the evaluation.
+     @param whitePawns and blackPawns are bitboards of the pawns. */
+  static void evaluatePawns(PawnEntry& entry, uint64_t whitePawns,
+			    uint64_t blackPawns);
+
+  std::vector<PawnEntry> entries;
+  uint64_t mask;
+};
+
+/* function that returns the pawn table of the calling thread, for
+   evaluations made outside a search, which keeps its own. */
+PawnTable& threadPawnTable();
+
+#endif
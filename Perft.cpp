@@ -0,0 +1,169 @@
+#include "Perft.h"
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// mixes the depth into the table index so depths of a position spread out.
+uint64_t depthSalt(int depth) {
+  return (uint64_t)depth * 0x9E3779B97F4A7C15ULL;
+}
+
+// struct holding a piece of the tree counted by one thread.
+struct PerftTask {
+  Move moves[2];
+  int length;
+  int rootIndex;
+  uint64_t nodes;
+};
+
+}
+
+
+PerftTable::PerftTable(int megabytes) {
+
+  uint64_t count = 1;
+  uint64_t bytes = (uint64_t)(megabytes > 0 ? megabytes : 1) << 20;
+  while (count * 2 * sizeof(Entry) <= bytes)
+    count *= 2;
+
+  entries.reset(new Entry[count]);
+  mask = count - 1;
+  for (uint64_t i = 0; i < count; i++) {
+    entries[i].check.store(0, memory_order_relaxed);
+    entries[i].data.store(0, memory_order_relaxed);
+  }
+}
+
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+
+  const Entry& entry = entries[(key ^ depthSalt(depth)) & mask];
+  uint64_t data = entry.data.load(memory_order_relaxed);
+  uint64_t check = entry.check.load(memory_order_relaxed);
+
+  // depth sits in the low byte of data, the count above it.
+  if ((check ^ data) != key || (int)(data & 0xFF) != depth)
+    return false;
+  nodes = data >> 8;
+  return true;
+}
+
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+
+  Entry& entry = entries[(key ^ depthSalt(depth)) & mask];
+  uint64_t data = (nodes << 8) | (uint64_t)depth;
+  entry.data.store(data, memory_order_relaxed);
+  entry.check.store(key ^ data, memory_order_relaxed);
+}
+
+
+uint64_t perft(ChessBoard& board, int depth, PerftTable* table) {
+
+  if (depth <= 0)
+    return 1;
+
+  MoveList moves = board.legalMoves();
+
+  // the last move is counted rather than made.
+  if (depth == 1)
+    return moves.size();
+
+  uint64_t nodes = 0;
+  if (table != nullptr && table->probe(board.positionKey(), depth, nodes))
+    return nodes;
+
+  MoveRecord record;
+  for (Move move : moves) {
+    board.doMove(move, record);
+    nodes += perft(board, depth - 1, table);
+    board.undoMove(record);
+  }
+
+  if (table != nullptr)
+    table->store(board.positionKey(), depth, nodes);
+  return nodes;
+}
+
+
+uint64_t parallelPerft(ChessBoard& board, int depth, int threads,
+		       PerftTable* table, vector<PerftDivide>* divide) {
+
+  MoveList rootMoves = board.legalMoves();
+  if (divide != nullptr) {
+    divide->clear();
+    for (Move move : rootMoves)
+      divide->push_back({move, depth > 1 ? 0u : 1u});
+  }
+  if (depth <= 1)
+    return depth <= 0 ? 1 : rootMoves.size();
+
+  if (threads < 1)
+    threads = 1;
+
+  // one task per root move, split a move further if that is too few.
+  vector<PerftTask> tasks;
+  bool splitDeeper = depth >= 3 && (int)rootMoves.size() < threads * 4;
+  MoveRecord record;
+  for (size_t i = 0; i < rootMoves.size(); i++) {
+    if (!splitDeeper) {
+      tasks.push_back({{rootMoves[i], NO_MOVE}, 1, (int)i, 0});
+      continue;
+    }
+    board.doMove(rootMoves[i], record);
+    for (Move reply : board.legalMoves())
+      tasks.push_back({{rootMoves[i], reply}, 2, (int)i, 0});
+    board.undoMove(record);
+  }
+
+  // threads take the next task until none are left.
+  string fen = board.positionFen();
+  atomic<size_t> nextTask(0);
+  auto work = [&]() {
+    ChessBoard local(false);
+    local.setPosition(fen);
+    MoveRecord records[2];
+    for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+      PerftTask& task = tasks[i];
+      for (int ply = 0; ply < task.length; ply++)
+	local.doMove(task.moves[ply], records[ply]);
+      task.nodes = perft(local, depth - task.length, table);
+      for (int ply = task.length - 1; ply >= 0; ply--)
+	local.undoMove(records[ply]);
+    }
+  };
+
+  vector<thread> workers;
+  for (int i = 1; i < threads; i++)
+    workers.emplace_back(work);
+  work();
+  for (thread& worker : workers)
+    worker.join();
+
+  uint64_t nodes = 0;
+  for (const PerftTask& task : tasks) {
+    nodes += task.nodes;
+    if (divide != nullptr)
+      (*divide)[task.rootIndex].nodes += task.nodes;
+  }
+  return nodes;
+}
+
+
+uint64_t fenKeyMismatches(ChessBoard& board, int depth, ChessBoard& scratch) {
+
+  scratch.setPosition(board.positionFen());
+  uint64_t mismatches = scratch.positionKey() != board.positionKey();
+  if (depth <= 0)
+    return mismatches;
+
+  MoveRecord record;
+  for (Move move : board.legalMoves()) {
+    board.doMove(move, record);
+    mismatches += fenKeyMismatches(board, depth - 1, scratch);
+    board.undoMove(record);
+  }
+  return mismatches;
+}
@@ -0,0 +1,77 @@
+#ifndef PERFT_H
+#define PERFT_H
+#include "ChessBoard.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* table shared by perft threads caching the number of leaf positions
+   below a position at a depth. entries are written without locks: each
+   stores its key xor'd with its data, so a torn write fails the check on
+   the next probe rather than returning a wrong count. */
+class PerftTable {
+
+public:
+
+  /* constructor for the table.
+     @param megabytes is the amount of memory the table may use. */
+  PerftTable(int megabytes);
+
+  /* function that looks up a position at a depth.
+     @param key is the hash key of the position.
+     @param depth is the depth counted below the position.
+     @param nodes is filled with the count if one is found. */
+  bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+
+  /* function that stores the count of a position at a depth.
+     @param key is the hash key of the position.
+     @param depth is the depth counted below the position.
+     @param nodes is the number of leaf positions. */
+  void store(uint64_t key, int depth, uint64_t nodes);
+
+private:
+
+  struct Entry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+
+  std::unique_ptr<Entry[]> entries;
+  uint64_t mask = 0;
+};
+
+// struct holding the number of leaf positions below one root move.
+struct PerftDivide {
+  Move move;
+  uint64_t nodes;
+};
+
+/* function that counts the leaf positions of the legal move tree.
+   @param board is the chess board holding the position.
+   @param depth is the number of moves to look ahead.
+   @param table is an optional cache of counts, nullptr for none. */
+uint64_t perft(ChessBoard& board, int depth, PerftTable* table = nullptr);
+
+/* function that counts the leaf positions of the legal move tree using
+   several threads, each on its own board. the tree is split into tasks at
+   the root, or two moves deep when the root has too few moves to keep
+   every thread busy, and threads take the next task from a shared queue.
+   @param board is the chess board holding the position, left unchanged.
+   @param depth is the number of moves to look ahead.
+   @param threads is the number of threads to use.
+   @param table is an optional cache of counts, nullptr for none.
+   @param divide if not nullptr is filled with the count per root move. */
+uint64_t parallelPerft(ChessBoard& board, int depth, int threads,
+		       PerftTable* table = nullptr,
+		       std::vector<PerftDivide>* divide = nullptr);
+
+/* function that sets up every position of the legal move tree again from
+   its Forsyth-Edwards Notation and counts those whose hash key changes,
+   which would break repetitions, the perft table and the position index.
+   @param board is the chess board holding the position, left unchanged.
+   @param depth is the number of moves to look ahead.
+   @param scratch is a board the positions are set up on. */
+uint64_t fenKeyMismatches(ChessBoard& board, int depth, ChessBoard& scratch);
+
+#endif
@@ -0,0 +1,112 @@
+#include "ChessBoard.h"
+#include "Perft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* counts the leaf positions of the legal move tree, to check the move
+   generator and to measure its speed on several threads.
+
+   usage: perft [--fen FEN] [--depth N] [--threads N] [--hash MB]
+                [--divide] [--expect N] [--fen-keys]
+
+   with --expect the exit status is 1 if the count differs. with
+   --fen-keys every position of the tree is instead set up again from its
+   Forsyth-Edwards Notation, and the exit status is 1 if any hash key
+   differs from the one the moves led to. */
+
+namespace {
+
+// struct holding the options given on the command line.
+struct PerftOptions {
+  string fen = START_POSITION;
+  int depth = 5;
+  int threads = max(1u, thread::hardware_concurrency());
+  int hashMegabytes = 0;
+  bool divide = false;
+  bool expect = false;
+  uint64_t expected = 0;
+  bool fenKeys = false;
+};
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  PerftOptions options;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--fen") && i + 1 < argc)
+      options.fen = argv[++i];
+    else if (!strcmp(argv[i], "--depth") && i + 1 < argc)
+      options.depth = max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      options.hashMegabytes = max(0, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--divide"))
+      options.divide = true;
+    else if (!strcmp(argv[i], "--expect") && i + 1 < argc) {
+      options.expect = true;
+      options.expected = strtoull(argv[++i], nullptr, 10);
+    }
+    else if (!strcmp(argv[i], "--fen-keys"))
+      options.fenKeys = true;
+    else {
+      cerr << "usage: perft [--fen FEN] [--depth N] [--threads N]"
+	   << " [--hash MB] [--divide] [--expect N] [--fen-keys]" << endl;
+      return 1;
+    }
+  }
+
+  ChessBoard board(false);
+  if (!board.setPosition(options.fen)) {
+    cerr << "perft: bad position " << options.fen << endl;
+    return 1;
+  }
+
+  if (options.fenKeys) {
+    ChessBoard scratch(false);
+    uint64_t mismatches = fenKeyMismatches(board, options.depth, scratch);
+    cout << "depth " << options.depth << " positions whose fen changes the"
+	 << " hash key " << mismatches << endl;
+    return mismatches == 0 ? 0 : 1;
+  }
+
+  unique_ptr<PerftTable> table;
+  if (options.hashMegabytes > 0)
+    table.reset(new PerftTable(options.hashMegabytes));
+
+  vector<PerftDivide> divide;
+  auto start = chrono::steady_clock::now();
+  uint64_t nodes = parallelPerft(board, options.depth, options.threads,
+				 table.get(),
+				 options.divide ? &divide : nullptr);
+  double seconds = chrono::duration<double>
+    (chrono::steady_clock::now() - start).count();
+
+  for (const PerftDivide& root : divide)
+    cout << root.move << ": " << root.nodes << endl;
+
+  cout << "depth " << options.depth << " nodes " << nodes
+       << " time " << (uint64_t)(seconds * 1000) << " ms nps "
+       << (uint64_t)(nodes / max(seconds, 1e-9)) << " threads "
+       << options.threads << endl;
+
+  if (options.expect && nodes != options.expected) {
+    cerr << "perft: expected " << options.expected << " nodes, counted "
+	 << nodes << endl;
+    return 1;
+  }
+  return 0;
+}
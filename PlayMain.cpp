@@ -0,0 +1,172 @@
+#include "ChessBoard.h"
+#include "Search.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+/* plays a game against the engine on the terminal. moves are typed as two
+   positions, e.g. "E2 E4", castling as the rook's position then the
+   king's. with --ponder the engine keeps searching the reply it expects
+   while the player thinks: if the reply is played it carries on with that
+   search, otherwise it starts again on the position reached.
+
+   usage: play [--engine white|black] [--movetime MS] [--hash MB]
+               [--ponder] */
+
+namespace {
+
+string positionText(int column, int row) {
+  return string(1, (char)('A' + column)) + (char)('1' + row);
+}
+
+/* function that reads a move typed by the player.
+   @param line is the text typed, e.g. "E2 E4" or "e2e4".
+   @param from and to are filled with the two positions. */
+bool readMove(const string& line, string& from, string& to) {
+  string text;
+  for (char symbol : line)
+    if (!isspace((unsigned char)symbol))
+      text += toupper((unsigned char)symbol);
+  if (text.size() != 4)
+    return false;
+  from = text.substr(0, 2);
+  to = text.substr(2, 2);
+  return true;
+}
+
+/* function that finds the legal move between two positions.
+   @param board is the chess board holding the position.
+   @param from and to are the positions of the move.
+   @param move is filled with the move, flags included, if it is legal. */
+bool findMove(ChessBoard& board, const string& from, const string& to,
+	      Move& move) {
+  for (Move legal : board.legalMoves())
+    if (positionText(legal.originalColumn(), legal.originalRow()) == from
+	&& positionText(legal.targetColumn(), legal.targetRow()) == to) {
+      move = legal;
+      return true;
+    }
+  return false;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  Colour engineColour = BLACK;
+  SearchLimits limits;
+  limits.moveTime = 2000;
+  int hashMegabytes = 64;
+  bool ponder = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--engine") && i + 1 < argc) {
+      string colour = argv[++i];
+      engineColour = colour == "white" ? WHITE : BLACK;
+    }
+    else if (!strcmp(argv[i], "--movetime") && i + 1 < argc)
+      limits.moveTime = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      hashMegabytes = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--ponder"))
+      ponder = true;
+    else {
+      cerr << "usage: play [--engine white|black] [--movetime MS]"
+	   << " [--hash MB] [--ponder]" << endl;
+      return 1;
+    }
+  }
+
+  // the game board talks to the player, the engine searches its own copy.
+  ChessBoard game;
+  ChessBoard thinking(false);
+  Search search(hashMegabytes);
+  MoveRecord record;
+
+  // expected reply being pondered, made on the engine's board.
+  bool pondering = false;
+  Move expected = NO_MOVE;
+  MoveRecord expectedRecord;
+  // whether the search already running is for the engine's move.
+  bool searching = false;
+
+  while (true) {
+    Colour colour = game.sideToMove();
+    if (game.inCheckMate(colour) || game.drawnByRule())
+      break;
+
+    if (colour == engineColour) {
+      auto start = chrono::steady_clock::now();
+      if (!searching)
+	search.start(thinking, limits);
+      SearchResult result = search.wait();
+      searching = false;
+      int waited = (int)chrono::duration_cast<chrono::milliseconds>
+	(chrono::steady_clock::now() - start).count();
+
+      Move move = result.bestMove;
+      string from = positionText(move.originalColumn(), move.originalRow());
+      string to = positionText(move.targetColumn(), move.targetRow());
+      cout << "Engine plays " << from << " " << to << " after " << waited
+	   << " ms (depth " << result.depth << ", score "
+	   << scoreText(result.score) << ")" << endl;
+      game.submitMove(from.c_str(), to.c_str());
+      thinking.doMove(move, record);
+
+      // search the position after the reply expected while the player thinks.
+      if (ponder && result.pv.size() > 1
+	  && !game.inCheckMate(game.sideToMove()) && !game.drawnByRule()) {
+	expected = result.pv[1];
+	thinking.doMove(expected, expectedRecord);
+	SearchLimits ponderLimits = limits;
+	ponderLimits.ponder = true;
+	search.start(thinking, ponderLimits);
+	pondering = true;
+      }
+      continue;
+    }
+
+    cout << colour << " to move: " << flush;
+    string line, from, to;
+    if (!getline(cin, line) || line == "quit")
+      break;
+    Move move;
+    if (!readMove(line, from, to)) {
+      cout << "Moves are typed as two positions, e.g. E2 E4" << endl;
+      continue;
+    }
+
+    // the board explains why a move it refuses cannot be made.
+    bool legal = findMove(game, from, to, move);
+    game.submitMove(from.c_str(), to.c_str());
+    if (!legal || game.sideToMove() == colour)
+      continue;
+
+    if (pondering && move == expected) {
+      // the search already has the right position and carries on.
+      search.ponderHit();
+      searching = true;
+    }
+    else {
+      if (pondering) {
+	search.stop();
+	search.wait();
+	thinking.undoMove(expectedRecord);
+      }
+      thinking.doMove(move, record);
+    }
+    pondering = false;
+  }
+
+  search.stop();
+  search.wait();
+  return 0;
+}
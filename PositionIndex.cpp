@@ -0,0 +1,275 @@
+#include "PositionIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const char MAGIC[4] = {'C', 'H', 'P', 'I'};
+const uint32_t VERSION = 1;
+// magic, version and number of entries.
+const size_t HEADER_SIZE = 4 + 4 + 8;
+// entries are bucketed by the top bits of their key.
+const int BUCKET_BITS = 16;
+const size_t BUCKETS = (size_t)1 << BUCKET_BITS;
+const size_t ENTRIES_OFFSET = HEADER_SIZE + (BUCKETS + 1) * 8;
+
+// entries sort by key, then by game and ply so hits come out in order.
+bool before(const PositionEntry& first, const PositionEntry& second) {
+  if (first.key != second.key)
+    return first.key < second.key;
+  if (first.game != second.game)
+    return first.game < second.game;
+  return first.ply < second.ply;
+}
+
+/* class writing the sorted entries of an index, counting them by bucket
+   as they go past so the bucket table can be filled in at the end. */
+class IndexWriter {
+
+public:
+
+  IndexWriter() : counts(BUCKETS + 1, 0) {}
+
+  bool open(const string& file) {
+    out.open(file, ios::binary | ios::trunc);
+    // the header and buckets are written again once counted.
+    vector<char> space(ENTRIES_OFFSET, 0);
+    out.write(space.data(), space.size());
+    return (bool)out;
+  }
+
+  void add(const PositionEntry& entry) {
+    counts[(entry.key >> (64 - BUCKET_BITS)) + 1]++;
+    buffer.push_back(entry);
+    if (buffer.size() == 1 << 16)
+      flush();
+  }
+
+  bool finish() {
+    flush();
+    for (size_t bucket = 1; bucket <= BUCKETS; bucket++)
+      counts[bucket] += counts[bucket - 1];
+    uint64_t total = counts[BUCKETS];
+
+    out.seekp(0);
+    out.write(MAGIC, 4);
+    out.write((const char*)&VERSION, 4);
+    out.write((const char*)&total, 8);
+    out.write((const char*)counts.data(), counts.size() * 8);
+    bool written = (bool)out;
+    out.close();
+    return written;
+  }
+
+private:
+
+  void flush() {
+    out.write((const char*)buffer.data(),
+	      buffer.size() * sizeof(PositionEntry));
+    buffer.clear();
+  }
+
+  ofstream out;
+  vector<uint64_t> counts;
+  vector<PositionEntry> buffer;
+};
+
+/* class reading back a sorted run a buffer at a time. */
+class RunReader {
+
+public:
+
+  RunReader(const string& file, size_t capacity)
+    : in(file, ios::binary), buffer(capacity) {}
+
+  bool next(PositionEntry& entry) {
+    if (at == filled) {
+      in.read((char*)buffer.data(), buffer.size() * sizeof(PositionEntry));
+      filled = in.gcount() / sizeof(PositionEntry);
+      at = 0;
+      if (filled == 0)
+	return false;
+    }
+    entry = buffer[at++];
+    return true;
+  }
+
+private:
+
+  ifstream in;
+  vector<PositionEntry> buffer;
+  size_t at = 0;
+  size_t filled = 0;
+};
+
+/* function that merges sorted runs into an index.
+   @param runs are the names of the files holding the runs.
+   @param capacity is the number of entries all buffers may hold.
+   @param writer is the index the entries are written to. */
+void mergeRuns(const vector<string>& runs, size_t capacity,
+	       IndexWriter& writer) {
+
+  vector<unique_ptr<RunReader>> readers;
+  size_t share = max<size_t>(capacity / runs.size(), 1024);
+  for (const string& run : runs)
+    readers.emplace_back(new RunReader(run, share));
+
+  // heap of the next entry of every run, the smallest on top.
+  typedef pair<PositionEntry, size_t> Head;
+  auto after = [](const Head& first, const Head& second) {
+    return before(second.first, first.first);
+  };
+  priority_queue<Head, vector<Head>, decltype(after)> heads(after);
+  PositionEntry entry;
+  for (size_t run = 0; run < readers.size(); run++)
+    if (readers[run]->next(entry))
+      heads.push(Head(entry, run));
+
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    writer.add(head.first);
+    if (readers[head.second]->next(entry))
+      heads.push(Head(entry, head.second));
+  }
+}
+
+}
+
+
+bool buildPositionIndex(GameArchiveReader& archive, const string& file,
+			int megabytes, uint64_t* positions) {
+
+  size_t capacity = max(1, megabytes) * ((size_t)1 << 20)
+    / sizeof(PositionEntry);
+  vector<PositionEntry> buffer;
+  buffer.reserve(capacity);
+  vector<string> runs;
+  bool valid = true;
+
+  // sorts the entries gathered so far and writes them out as a run.
+  auto spill = [&]() {
+    sort(buffer.begin(), buffer.end(), before);
+    string run = file + ".run" + to_string(runs.size());
+    ofstream out(run, ios::binary | ios::trunc);
+    out.write((const char*)buffer.data(),
+	      buffer.size() * sizeof(PositionEntry));
+    valid = valid && (bool)out;
+    runs.push_back(run);
+    buffer.clear();
+  };
+
+  ChessBoard board(false);
+  uint64_t total = 0;
+  uint32_t game = 0;
+  uint32_t ply = 0;
+  auto gather = [&](ChessBoard& position, Move move) {
+    ply = move == NO_MOVE ? 0 : ply + 1;
+    buffer.push_back(PositionEntry{position.positionKey(), game, ply});
+    total++;
+    if (buffer.size() == capacity)
+      spill();
+    return valid;
+  };
+
+  for (; game < archive.size() && valid; game++)
+    valid = archive.replay(game, board, gather) && valid;
+
+  IndexWriter writer;
+  valid = valid && writer.open(file);
+  if (valid && runs.empty()) {
+    // everything fitted in memory, so there is nothing to merge.
+    sort(buffer.begin(), buffer.end(), before);
+    for (const PositionEntry& entry : buffer)
+      writer.add(entry);
+  }
+  else if (valid) {
+    if (!buffer.empty())
+      spill();
+    // the memory of the last run goes to the merge buffers.
+    vector<PositionEntry>().swap(buffer);
+    mergeRuns(runs, capacity, writer);
+  }
+  valid = valid && writer.finish();
+
+  for (const string& run : runs)
+    remove(run.c_str());
+  if (positions)
+    *positions = total;
+  return valid;
+}
+
+
+PositionIndex::~PositionIndex() {
+  if (mapping)
+    munmap(mapping, mappedBytes);
+}
+
+bool PositionIndex::open(const string& file) {
+  int descriptor = ::open(file.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return false;
+  struct stat status;
+  bool valid = fstat(descriptor, &status) == 0
+    && (size_t)status.st_size >= ENTRIES_OFFSET;
+  if (valid) {
+    mappedBytes = status.st_size;
+    mapping = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, descriptor,
+		   0);
+    if (mapping == MAP_FAILED)
+      mapping = nullptr;
+  }
+  close(descriptor);
+  if (!mapping)
+    return false;
+
+  const char* bytes = (const char*)mapping;
+  uint32_t version;
+  memcpy(&version, bytes + 4, 4);
+  memcpy(&count, bytes + 8, 8);
+  buckets = (const uint64_t*)(bytes + HEADER_SIZE);
+  valid = memcmp(bytes, MAGIC, 4) == 0 && version == VERSION
+    && (mappedBytes - ENTRIES_OFFSET) % sizeof(PositionEntry) == 0
+    && count == (mappedBytes - ENTRIES_OFFSET) / sizeof(PositionEntry);
+
+  // lookups index the entries by bucket, so each bucket must start where
+  // the one before ends and the last must end with the entries.
+  valid = valid && buckets[0] == 0 && buckets[BUCKETS] == count;
+  for (size_t bucket = 1; valid && bucket <= BUCKETS; bucket++)
+    valid = buckets[bucket - 1] <= buckets[bucket];
+
+  if (!valid) {
+    munmap(mapping, mappedBytes);
+    mapping = nullptr;
+    buckets = nullptr;
+    count = 0;
+    return false;
+  }
+  entries = (const PositionEntry*)(bytes + ENTRIES_OFFSET);
+  return true;
+}
+
+void PositionIndex::find(uint64_t key, vector<PositionEntry>& hits) const {
+  hits.clear();
+  if (!mapping)
+    return;
+  uint64_t bucket = key >> (64 - BUCKET_BITS);
+  const PositionEntry* first = entries + buckets[bucket];
+  const PositionEntry* last = entries + buckets[bucket + 1];
+  first = lower_bound(first, last, key,
+		      [](const PositionEntry& entry, uint64_t key) {
+			return entry.key < key;
+		      });
+  for (; first != last && first->key == key; first++)
+    hits.push_back(*first);
+}
@@ -0,0 +1,73 @@
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+#include "GameArchive.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* an index of every position reached in the games of an archive, for
+   finding the games that passed through a position. it is a file of
+   entries sorted by the hash key of the position, laid out as
+
+     header    "CHPI", version, number of entries
+     buckets   the number of the first entry of each value of the top 16
+               bits of the key, and of the end, 65537 of 8 bytes
+     entries   key, game and ply, 16 bytes each
+
+   and is mapped into memory rather than read, so opening it costs nothing
+   and a lookup touches the bucket table and a few pages of entries. the
+   entries are written in the byte order of the machine building the
+   index. */
+
+// struct holding a position reached in a game.
+struct PositionEntry {
+  uint64_t key;
+  uint32_t game;
+  // number of moves made before the position, zero for the start.
+  uint32_t ply;
+};
+
+/* function that builds an index of the positions of an archive. entries
+   are sorted in runs that fit the memory allowed, each written to a file
+   next to the index, and the runs merged into the index.
+   @param archive is the archive holding the games.
+   @param file is the name of the index.
+   @param megabytes is the memory the entries may take while sorting.
+   @param positions if not nullptr is filled with the number of entries. */
+bool buildPositionIndex(GameArchiveReader& archive, const std::string& file,
+			int megabytes, uint64_t* positions = nullptr);
+
+class PositionIndex {
+
+public:
+
+  PositionIndex() = default;
+  PositionIndex(const PositionIndex&) = delete;
+  PositionIndex& operator=(const PositionIndex&) = delete;
+
+  /* destructor for the index, unmapping the file. */
+  ~PositionIndex();
+
+  /* function that maps an index into memory.
+     @param file is the name of the index. */
+  bool open(const std::string& file);
+
+  /* getter function for the number of positions in the index. */
+  uint64_t size() const { return count; }
+
+  /* function that finds the games that passed through a position.
+     @param key is the hash key of the position.
+     @param hits is filled with an entry for every time a game reached
+     the position, in order of game and ply. */
+  void find(uint64_t key, std::vector<PositionEntry>& hits) const;
+
+private:
+
+  void* mapping = nullptr;
+  size_t mappedBytes = 0;
+  const uint64_t* buckets = nullptr;
+  const PositionEntry* entries = nullptr;
+  uint64_t count = 0;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "ChessBoard.h"
+#include "GameArchive.h"
+#include "PositionIndex.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* builds an index of the positions in a game archive and looks up the
+   games that reached a position.
+
+   usage: posindex build ARCHIVE INDEX [--memory MB]
+          posindex query INDEX FEN
+
+   build sorts at most MB megabytes of positions at a time, 256 by
+   default, spilling sorted runs to files next to the index. */
+
+namespace {
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now()
+				  - start).count();
+}
+
+int build(const string& archiveFile, const string& indexFile,
+	  int megabytes) {
+  GameArchiveReader archive;
+  if (!archive.open(archiveFile)) {
+    cerr << "posindex: cannot read " << archiveFile << endl;
+    return 1;
+  }
+
+  auto start = chrono::steady_clock::now();
+  uint64_t positions;
+  if (!buildPositionIndex(archive, indexFile, megabytes, &positions)) {
+    cerr << "posindex: cannot build " << indexFile << endl;
+    return 1;
+  }
+  double seconds = secondsSince(start);
+  cout << "Indexed " << positions << " positions of " << archive.size()
+       << " games in " << fixed << setprecision(3) << seconds << " s, "
+       << setprecision(0) << positions / max(seconds, 1e-9)
+       << " positions/s" << endl;
+  return 0;
+}
+
+int query(const string& indexFile, const string& fen) {
+  PositionIndex index;
+  if (!index.open(indexFile)) {
+    cerr << "posindex: cannot read " << indexFile << endl;
+    return 1;
+  }
+  ChessBoard board(false);
+  if (!board.setPosition(fen)) {
+    cerr << "posindex: bad position " << fen << endl;
+    return 1;
+  }
+
+  auto start = chrono::steady_clock::now();
+  vector<PositionEntry> hits;
+  index.find(board.positionKey(), hits);
+  double seconds = secondsSince(start);
+
+  for (const PositionEntry& hit : hits)
+    cout << "game " << hit.game << " ply " << hit.ply << endl;
+  cout << "Found " << hits.size() << " of " << index.size()
+       << " positions in " << fixed << setprecision(3) << seconds * 1000
+       << " ms" << endl;
+  return 0;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  string command = argc > 1 ? argv[1] : "";
+  if (command == "build" && (argc == 4 || (argc == 6
+					   && string(argv[4]) == "--memory")))
+    return build(argv[2], argv[3], argc == 6 ? atoi(argv[5]) : 256);
+
+  if (command == "query" && argc >= 4) {
+    string fen = argv[3];
+    for (int i = 4; i < argc; i++)
+      fen += string(" ") + argv[i];
+    return query(argv[2], fen);
+  }
+
+  cerr << "usage: posindex build ARCHIVE INDEX [--memory MB]" << endl
+       << "       posindex query INDEX FEN" << endl;
+  return 1;
+}
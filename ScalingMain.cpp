@@ -0,0 +1,199 @@
+#include "ChessBoard.h"
+#include "Numa.h"
+#include "Search.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/* measures how the nodes searched per second grow with threads, one
+   socket after another. every thread runs its own search over the same
+   positions, all sharing one transposition table as the workers of the
+   analysis server do, first with threads and memory placed by the
+   kernel and then pinned to cores one node at a time with the table
+   spread over every node. thread counts are one, then half and all of
+   the cores of each further node.
+
+   usage: scaling [--movetime MS] [--hash MB] [--threads N]
+                  [--pinned | --free] */
+
+namespace {
+
+const char* const POSITIONS[] = {
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r2q1rk1/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R2QK2R w KQ - 0 9",
+  "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 0 7",
+  "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19"};
+
+// struct holding the options given on the command line.
+struct ScalingOptions {
+  int moveTime = 500;
+  int hashMegabytes = 256;
+  int threads = 0;
+  bool free = true;
+  bool pinned = true;
+};
+
+// struct holding what one thread of a run searched.
+struct ThreadCount {
+  int node = 0;
+  uint64_t nodes = 0;
+  uint64_t elapsed = 0;
+};
+
+/* function that returns the thread counts to measure: one, then half and
+   all of the cpus of each node added in turn, at most limit if above 0. */
+vector<int> threadCounts(const NumaTopology& topology, int limit) {
+
+  vector<int> counts = {1};
+  int total = 0;
+  for (const vector<int>& cpus : topology.nodeCpus) {
+    for (int count : {total + (int)cpus.size() / 2,
+		      total + (int)cpus.size()})
+      if (count > counts.back() && (limit <= 0 || count <= limit))
+	counts.push_back(count);
+    total += (int)cpus.size();
+  }
+  if (limit > counts.back())
+    counts.push_back(limit);
+  return counts;
+}
+
+/* function that searches every position on each of a number of threads
+   at once and returns what each thread searched.
+   @param pinned places the threads and memory by node. */
+vector<ThreadCount> run(int threads, bool pinned,
+			const ScalingOptions& options) {
+
+  TranspositionTable table(pinned ? 1 : options.hashMegabytes);
+  if (pinned) {
+    InterleavedMemory interleaved;
+    table.resize(options.hashMegabytes);
+  }
+
+  vector<ThreadCount> counts(threads);
+  auto work = [&](int index) {
+    ThreadCount& count = counts[index];
+    count.node = pinned ? max(0, pinThread(index)) : -1;
+    Search search(table);
+    ChessBoard board(false);
+    SearchLimits limits;
+    limits.moveTime = options.moveTime;
+    // threads start on different positions so they do not all walk the
+    // same tree through the shared table.
+    int positions = (int)(sizeof(POSITIONS) / sizeof(POSITIONS[0]));
+    for (int i = 0; i < positions; i++) {
+      board.setPosition(POSITIONS[(index + i) % positions]);
+      search.think(board, limits);
+      SearchStatistics statistics = search.statistics();
+      count.nodes += statistics.nodes;
+      count.elapsed += statistics.elapsed;
+    }
+  };
+
+  vector<thread> workers;
+  for (int i = 0; i < threads; i++)
+    workers.emplace_back(work, i);
+  for (thread& worker : workers)
+    worker.join();
+  return counts;
+}
+
+/* function that writes the rate of a count of nodes in nodes a second. */
+uint64_t rate(uint64_t nodes, uint64_t elapsed) {
+  return elapsed ? nodes * 1000 / elapsed : 0;
+}
+
+/* function that measures and writes every thread count in one placement.
+   @param pinned places the threads and memory by node. */
+void measure(const NumaTopology& topology, bool pinned,
+	     const ScalingOptions& options) {
+
+  int nodeCount = (int)topology.nodeCpus.size();
+  cout << endl << (pinned ? "pinned to cores, table interleaved"
+		   : "placed by the kernel") << endl;
+  cout << setw(8) << "threads" << setw(12) << "nps" << setw(12)
+       << "nps/thread" << setw(9) << "speedup";
+  if (pinned)
+    for (int node = 0; node < nodeCount; node++)
+      cout << setw(12) << "node " + to_string(topology.nodeIds[node]);
+  cout << endl;
+
+  uint64_t single = 0;
+  for (int threads : threadCounts(topology, options.threads)) {
+    vector<ThreadCount> counts = run(threads, pinned, options);
+
+    // each thread searches for the same time, so rates add up.
+    uint64_t total = 0;
+    vector<uint64_t> perNode(nodeCount, 0);
+    for (const ThreadCount& count : counts) {
+      uint64_t threadRate = rate(count.nodes, count.elapsed);
+      total += threadRate;
+      if (count.node >= 0)
+	perNode[count.node] += threadRate;
+    }
+    if (threads == 1)
+      single = total;
+
+    cout << setw(8) << threads << setw(12) << total << setw(12)
+	 << total / threads << setw(9) << fixed << setprecision(2)
+	 << (single ? (double)total / single : 0.0);
+    if (pinned)
+      for (uint64_t nodeRate : perNode)
+	cout << setw(12) << nodeRate;
+    cout << endl;
+  }
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  ScalingOptions options;
+  bool valid = true;
+  for (int i = 1; i < argc && valid; i++) {
+    if (!strcmp(argv[i], "--movetime") && i + 1 < argc)
+      options.moveTime = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--hash") && i + 1 < argc)
+      options.hashMegabytes = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      options.threads = max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--pinned"))
+      options.free = false;
+    else if (!strcmp(argv[i], "--free"))
+      options.pinned = false;
+    else
+      valid = false;
+  }
+  // asking for only one placement and only the other leaves nothing to run.
+  if (!valid || (!options.free && !options.pinned)) {
+    cerr << "usage: scaling [--movetime MS] [--hash MB] [--threads N]"
+	 << " [--pinned | --free]" << endl;
+    return 1;
+  }
+
+  const NumaTopology& topology = numaTopology();
+  for (size_t node = 0; node < topology.nodeCpus.size(); node++) {
+    cout << "node " << topology.nodeIds[node] << ":";
+    for (int cpu : topology.nodeCpus[node])
+      cout << " " << cpu;
+    cout << endl;
+  }
+
+  if (options.free)
+    measure(topology, false, options);
+  if (options.pinned)
+    measure(topology, true, options);
+  return 0;
+}
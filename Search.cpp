@@ -0,0 +1,604 @@
+#include "Search.h"
+#include "Evaluation.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+
+namespace {
+
+// scores beyond this are mates found within the search.
+const int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+// how often, in nodes, the limits are checked and counters published.
+const uint64_t CHECK_INTERVAL = 1024;
+
+// hook of the search trace, run only when recording (see SearchTrace.h).
+#ifdef CHESS_INSTRUMENT
+#define SEARCH_TRACE(...) \
+  do { if (trace) { __VA_ARGS__; } } while (false)
+#else
+#define SEARCH_TRACE(...) ((void)0)
+#endif
+
+/* mate scores are stored relative to the position rather than the root,
+   so they stay correct when the position is reached at another ply. */
+int scoreToTable(int score, int ply) {
+  if (score >= MATE_BOUND)
+    return score + ply;
+  if (score <= -MATE_BOUND)
+    return score - ply;
+  return score;
+}
+
+int scoreFromTable(int score, int ply) {
+  if (score >= MATE_BOUND)
+    return score - ply;
+  if (score <= -MATE_BOUND)
+    return score + ply;
+  return score;
+}
+
+}
+
+
+string scoreText(int score) {
+  if (score >= MATE_BOUND)
+    return "mate " + to_string((MATE_SCORE - score + 1) / 2);
+  if (score <= -MATE_BOUND)
+    return "mate -" + to_string((MATE_SCORE + score) / 2);
+  return "cp " + to_string(score);
+}
+
+
+double SearchStatistics::ttHitRate() const {
+  return ttProbes ? (double)ttHits / ttProbes : 0.0;
+}
+
+
+double SearchStatistics::firstMoveCutoffRate() const {
+  return betaCutoffs ? (double)firstMoveCutoffs / betaCutoffs : 0.0;
+}
+
+
+double SearchStatistics::pawnHitRate() const {
+  return pawnProbes ? (double)pawnHits / pawnProbes : 0.0;
+}
+
+
+double SearchStatistics::evalHitRate() const {
+  return evalProbes ? (double)evalHits / evalProbes : 0.0;
+}
+
+
+Search::Search(int hashMegabytes)
+  : ownTable(new TranspositionTable(hashMegabytes)), table(ownTable.get()) {
+}
+
+
+Search::Search(TranspositionTable& sharedTable) : table(&sharedTable) {
+}
+
+
+Search::~Search() {
+  stop();
+  if (worker.joinable())
+    worker.join();
+}
+
+
+void Search::start(ChessBoard& board_, const SearchLimits& limits_) {
+
+  // only one search runs at a time.
+  stop();
+  if (worker.joinable())
+    worker.join();
+
+  board = &board_;
+  limits = limits_;
+  stopSignal = false;
+  ponderHitSignal = false;
+  pondering = limits.ponder;
+  nodes = ttProbes = ttHits = betaCutoffs = firstMoveCutoffs = 0;
+  selDepth = completedDepth = 0;
+  result = SearchResult();
+  {
+    lock_guard<mutex> lock(statisticsLock);
+    published = SearchStatistics();
+    published.searching = true;
+  }
+
+  worker = thread(&Search::iterativeDeepening, this);
+}
+
+
+void Search::stop() {
+  stopSignal = true;
+}
+
+
+void Search::ponderHit() {
+  ponderHitSignal = true;
+}
+
+
+SearchResult Search::wait() {
+  if (worker.joinable())
+    worker.join();
+  return result;
+}
+
+
+SearchResult Search::think(ChessBoard& board_, const SearchLimits& limits_) {
+  start(board_, limits_);
+  return wait();
+}
+
+
+SearchStatistics Search::statistics() const {
+  lock_guard<mutex> lock(statisticsLock);
+  return published;
+}
+
+
+void Search::clearHash() {
+  table->clear();
+}
+
+
+void Search::resizeHash(int megabytes) {
+  table->resize(megabytes);
+}
+
+
+void Search::resizeEvalCache(int entries) {
+  evalCache.resize(entries);
+}
+
+
+void Search::setTrace(TraceFile* file) {
+  trace.reset(file ? new TraceBuffer(*file) : nullptr);
+}
+
+
+void Search::setIterationCallback(function<void(const SearchResult&)>
+				  callback) {
+  iterationCallback = callback;
+}
+
+
+void Search::iterativeDeepening() {
+
+  // the caches are kept from one search to the next, their counters are not.
+  pawnTable.probes = 0;
+  pawnTable.hits = 0;
+  evalCache.probes = 0;
+  evalCache.hits = 0;
+
+  MoveList rootMoves = board->legalMoves();
+  timeManager.start(limits, board->sideToMove(), (int)rootMoves.size());
+
+  // with no moves to make the game is over, nothing to search.
+  if (rootMoves.empty()) {
+    result.score = board->inCheck(board->sideToMove()) ? -MATE_SCORE : 0;
+    publish();
+    lock_guard<mutex> lock(statisticsLock);
+    published.searching = false;
+    return;
+  }
+
+  // a move is always returned, even if the first iteration is cut short.
+  result.bestMove = rootMoves[0];
+
+  for (int i = 0; i < MAX_PLY; i++)
+    killers[i][0] = killers[i][1] = NO_MOVE;
+
+  int maximumDepth = limits.depth > 0 ? min(limits.depth, MAX_PLY - 1)
+    : MAX_PLY - 1;
+
+  int lineCount = min(max(limits.multiPv, 1), (int)rootMoves.size());
+
+  for (int depth = 1; depth <= maximumDepth; depth++) {
+
+    // each further line is the best root move not already given a line.
+    vector<SearchLine> lines;
+    excludedCount = 0;
+    for (int line = 0; line < lineCount; line++) {
+      int score = alphaBeta(depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+      SEARCH_TRACE(traceLeave(0, NO_MOVE, score));
+      // a line searched while stopping is kept only if it is the first.
+      if (pvLength[0] == 0 || (stopSignal && (depth > 1 || !lines.empty())))
+	break;
+      SearchLine found;
+      found.score = score;
+      found.depth = depth;
+      found.pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+      lines.push_back(found);
+      excludedRootMoves[excludedCount++] = pvTable[0][0];
+    }
+    excludedCount = 0;
+
+    // an interrupted iteration is not trusted.
+    if ((stopSignal && depth > 1) || lines.empty())
+      break;
+
+    stable_sort(lines.begin(), lines.end(),
+		[](const SearchLine& first, const SearchLine& second) {
+		  return first.score > second.score;
+		});
+    int score = lines[0].score;
+
+    completedDepth = depth;
+    result.depth = depth;
+    result.score = score;
+    result.bestMove = lines[0].pv[0];
+    result.pv = lines[0].pv;
+    result.lines = lines;
+    publish();
+    if (iterationCallback)
+      iterationCallback(result);
+
+    if (stopSignal)
+      break;
+
+    // a pondering search has no limits until the expected reply is played.
+    if (pondering && !ponderHitSignal)
+      continue;
+    pondering = false;
+
+    timeManager.iterationFinished(result.bestMove, score);
+    if (timeManager.stopAfterIteration())
+      break;
+
+    // a mate found within the depth searched will not get any shorter, but
+    // the other lines of a multipv search still have to get deeper.
+    bool proven = all_of(lines.begin(), lines.end(),
+			 [depth](const SearchLine& line) {
+			   return abs(line.score) >= MATE_BOUND
+			     && MATE_SCORE - abs(line.score) <= depth;
+			 });
+    if (proven && !limits.infinite)
+      break;
+  }
+
+  // a pondering search that runs out of depth waits to be told the outcome.
+  while (pondering && !ponderHitSignal && !stopSignal)
+    this_thread::sleep_for(chrono::milliseconds(1));
+
+  // the trace of a search is in the file once the search is over.
+  SEARCH_TRACE(trace->flush());
+  publish();
+  lock_guard<mutex> lock(statisticsLock);
+  published.searching = false;
+}
+
+
+int Search::alphaBeta(int depth, int ply, int alpha, int beta) {
+
+  pvLength[ply] = ply;
+
+  if (depth <= 0)
+    return quiescence(ply, alpha, beta);
+  SEARCH_TRACE(traceEnter(ply, depth, alpha, beta, 0));
+
+  nodes++;
+  if (nodes % CHECK_INTERVAL == 0)
+    checkLimits();
+  if (stopSignal && ply > 0)
+    return 0;
+  if (ply > selDepth)
+    selDepth = ply;
+  if (ply >= MAX_PLY - 1)
+    return evalCache.evaluate(*board, pawnTable);
+
+  // a repeated position is a draw, nothing to search. so are fifty quiet
+  // moves, unless the last of them gave mate.
+  if (ply > 0 && board->repetitionCount() > 0)
+    return 0;
+  if (ply > 0 && board->halfmoveClock() >= 100
+      && (!board->inCheck(board->sideToMove())
+	  || !board->legalMoves().empty()))
+    return 0;
+
+  bool pvNode = beta - alpha > 1;
+  uint64_t key = board->positionKey();
+
+  // a deep enough stored result can end the search of this position.
+  Move hashMove = NO_MOVE;
+  TableEntry entry;
+  ttProbes++;
+  if (table->probe(key, entry)) {
+    ttHits++;
+    SEARCH_TRACE(traceNodes[ply].flags |= TRACE_TT_HIT);
+    hashMove = entry.move;
+    if (!pvNode && ply > 0 && entry.depth >= depth) {
+      int score = scoreFromTable(entry.score, ply);
+      if (entry.bound == EXACT_BOUND
+	  || (entry.bound == LOWER_BOUND && score >= beta)
+	  || (entry.bound == UPPER_BOUND && score <= alpha)) {
+	SEARCH_TRACE(traceNodes[ply].flags |= TRACE_TT_CUTOFF);
+	return score;
+      }
+    }
+  }
+
+  Colour colour = board->sideToMove();
+  bool inCheck = board->inCheck(colour);
+
+  // positions in check are searched one ply deeper.
+  if (inCheck) {
+    depth++;
+    SEARCH_TRACE(traceNodes[ply].reduction = -1,
+		 traceNodes[ply].flags |= TRACE_IN_CHECK);
+  }
+
+  MoveList moves = board->legalMoves();
+  if (moves.empty())
+    return inCheck ? -MATE_SCORE + ply : 0;
+
+  // root moves that already have a line are left out.
+  if (ply == 0 && excludedCount > 0) {
+    size_t kept = 0;
+    for (Move move : moves)
+      if (find(excludedRootMoves, excludedRootMoves + excludedCount, move)
+	  == excludedRootMoves + excludedCount)
+	moves[kept++] = move;
+    moves.resize(kept);
+  }
+
+  orderMoves(moves, hashMove, ply);
+  SEARCH_TRACE(traceNodes[ply].moveCount = (uint8_t)moves.size());
+
+  int originalAlpha = alpha;
+  int bestScore = -INFINITE_SCORE;
+  Move bestMove = NO_MOVE;
+  MoveRecord record;
+
+  for (size_t i = 0; i < moves.size(); i++) {
+    Move move = moves[i];
+    const Piece* target = board->pieceAt(move.targetColumn(),
+					 move.targetRow());
+    bool capture = target != nullptr && target->getPieceColour() != colour;
+
+    SEARCH_TRACE(traceNodes[ply].searched = (uint8_t)(i + 1));
+    board->doMove(move, record);
+    int score;
+    if (i == 0)
+      score = -alphaBeta(depth - 1, ply + 1, -beta, -alpha);
+    else {
+      // later moves are expected to fail low, proven with a null window.
+      score = -alphaBeta(depth - 1, ply + 1, -alpha - 1, -alpha);
+      if (score > alpha && score < beta) {
+	SEARCH_TRACE(traceLeave(ply + 1, move, -score));
+	score = -alphaBeta(depth - 1, ply + 1, -beta, -alpha);
+      }
+    }
+    SEARCH_TRACE(traceLeave(ply + 1, move, -score));
+    board->undoMove(record);
+
+    // the move being searched when the search stopped has no true score.
+    // the root keeps the best of the moves searched before it.
+    if (stopSignal) {
+      if (ply > 0)
+	return 0;
+      break;
+    }
+
+    if (score > bestScore) {
+      bestScore = score;
+      bestMove = move;
+
+      if (score > alpha) {
+	alpha = score;
+
+	// principal variation is this move followed by the child's.
+	pvTable[ply][ply] = move;
+	for (int next = ply + 1; next < pvLength[ply + 1]; next++)
+	  pvTable[ply][next] = pvTable[ply + 1][next];
+	pvLength[ply] = pvLength[ply + 1];
+
+	if (alpha >= beta) {
+	  betaCutoffs++;
+	  if (i == 0)
+	    firstMoveCutoffs++;
+	  if (!capture && !(move == killers[ply][0])) {
+	    killers[ply][1] = killers[ply][0];
+	    killers[ply][0] = move;
+	  }
+	  break;
+	}
+      }
+    }
+  }
+
+  BoundType bound = bestScore >= beta ? LOWER_BOUND
+    : bestScore > originalAlpha ? EXACT_BOUND : UPPER_BOUND;
+  // a root search leaving moves out says nothing true about the position.
+  if (!stopSignal && !(ply == 0 && excludedCount > 0))
+    table->store(key, depth, scoreToTable(bestScore, ply), bound, bestMove);
+
+  return bestScore;
+}
+
+
+int Search::quiescence(int ply, int alpha, int beta) {
+
+  pvLength[ply] = ply;
+  SEARCH_TRACE(traceEnter(ply, 0, alpha, beta, TRACE_QUIESCENCE));
+
+  nodes++;
+  if (nodes % CHECK_INTERVAL == 0)
+    checkLimits();
+  if (stopSignal)
+    return 0;
+  if (ply > selDepth)
+    selDepth = ply;
+
+  int standPat = evalCache.evaluate(*board, pawnTable);
+  if (ply >= MAX_PLY - 1)
+    return standPat;
+
+  MoveList moves = board->legalMoves();
+  Colour colour = board->sideToMove();
+
+  // with no moves the position is mate or stalemate, not quiet.
+  if (moves.empty())
+    return board->inCheck(colour) ? -MATE_SCORE + ply : 0;
+
+  if (standPat >= beta)
+    return standPat;
+  if (standPat > alpha)
+    alpha = standPat;
+
+  // only captures are searched.
+  MoveList captures;
+  for (Move move : moves) {
+    const Piece* target = board->pieceAt(move.targetColumn(), move.targetRow());
+    if (target != nullptr && target->getPieceColour() != colour)
+      captures.push_back(move);
+  }
+  orderMoves(captures, NO_MOVE, ply);
+  SEARCH_TRACE(traceNodes[ply].moveCount = (uint8_t)captures.size());
+
+  int bestScore = standPat;
+  MoveRecord record;
+  for (Move move : captures) {
+    SEARCH_TRACE(traceNodes[ply].searched++);
+    board->doMove(move, record);
+    int score = -quiescence(ply + 1, -beta, -alpha);
+    SEARCH_TRACE(traceLeave(ply + 1, move, -score));
+    board->undoMove(record);
+
+    if (stopSignal)
+      return 0;
+
+    if (score > bestScore) {
+      bestScore = score;
+      if (score > alpha) {
+	alpha = score;
+	if (alpha >= beta) {
+	  betaCutoffs++;
+	  if (move == captures[0])
+	    firstMoveCutoffs++;
+	  break;
+	}
+      }
+    }
+  }
+  return bestScore;
+}
+
+
+void Search::orderMoves(MoveList& moves, Move hashMove, int ply) const {
+
+  int scores[MAX_MOVES];
+  for (size_t i = 0; i < moves.size(); i++)
+    scores[i] = moveOrderScore(moves[i], hashMove, ply);
+
+  // insertion sort, move lists are short.
+  for (size_t i = 1; i < moves.size(); i++) {
+    Move move = moves[i];
+    int score = scores[i];
+    size_t j = i;
+    while (j > 0 && scores[j - 1] < score) {
+      moves[j] = moves[j - 1];
+      scores[j] = scores[j - 1];
+      j--;
+    }
+    moves[j] = move;
+    scores[j] = score;
+  }
+}
+
+
+int Search::moveOrderScore(Move move, Move hashMove, int ply) const {
+
+  if (move == hashMove)
+    return 1000000;
+
+  const Piece* mover = board->pieceAt(move.originalColumn(),
+				      move.originalRow());
+  const Piece* target = board->pieceAt(move.targetColumn(), move.targetRow());
+
+  // captures ordered by most valuable victim, then least valuable attacker.
+  if (target != nullptr && target->getPieceColour() != mover->getPieceColour())
+    return 100000 + PIECE_VALUES[target->getPieceType()] * 10
+      - PIECE_VALUES[mover->getPieceType()] / 10;
+
+  if (move == killers[ply][0])
+    return 90000;
+  if (move == killers[ply][1])
+    return 80000;
+  return 0;
+}
+
+
+void Search::checkLimits() {
+
+  publish();
+
+  // the limits apply from when the expected reply is played.
+  if (pondering) {
+    if (!ponderHitSignal)
+      return;
+    pondering = false;
+  }
+
+  if (limits.nodes > 0 && nodes >= limits.nodes)
+    stopSignal = true;
+
+  // the first iteration always completes so a move can be made.
+  if (completedDepth >= 1 && timeManager.hardLimitReached())
+    stopSignal = true;
+}
+
+
+void Search::publish() {
+
+  int elapsed = timeManager.elapsed();
+
+  lock_guard<mutex> lock(statisticsLock);
+  published.nodes = nodes;
+  published.elapsed = elapsed;
+  published.nps = elapsed > 0 ? nodes * 1000 / elapsed : 0;
+  published.depth = completedDepth;
+  published.selDepth = selDepth;
+  published.ttProbes = ttProbes;
+  published.ttHits = ttHits;
+  published.betaCutoffs = betaCutoffs;
+  published.firstMoveCutoffs = firstMoveCutoffs;
+  published.pawnProbes = pawnTable.probes;
+  published.pawnHits = pawnTable.hits;
+  published.evalProbes = evalCache.probes;
+  published.evalHits = evalCache.hits;
+  published.bestMove = result.bestMove;
+  published.score = result.score;
+}
+
+
+void Search::traceEnter(int ply, int depth, int alpha, int beta,
+			uint8_t flags) {
+
+  TraceRecord& node = traceNodes[ply];
+  node = TraceRecord();
+  // windows reach past the scores a node can return by a little.
+  node.alpha = (int16_t)max(alpha, -INFINITE_SCORE);
+  node.beta = (int16_t)min(beta, INFINITE_SCORE);
+  node.ply = (uint8_t)ply;
+  node.depth = (int8_t)depth;
+  node.flags = flags;
+}
+
+
+void Search::traceLeave(int ply, Move move, int score) {
+
+  // a stopped search returns scores that mean nothing.
+  if (stopSignal)
+    return;
+  TraceRecord& node = traceNodes[ply];
+  node.move = move.raw();
+  node.score = (int16_t)score;
+  node.type = score >= node.beta ? TRACE_CUT
+    : score <= node.alpha ? TRACE_ALL : TRACE_PV;
+  trace->add(node);
+}
@@ -0,0 +1,251 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+#include "ChessBoard.h"
+#include "EvalCache.h"
+#include "PawnTable.h"
+#include "SearchTrace.h"
+#include "TimeManager.h"
+#include "TranspositionTable.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// deepest ply the search reaches, including quiescence.
+const int MAX_PLY = 64;
+
+// score of checkmate, reduced by the number of plies to reach it.
+const int MATE_SCORE = 30000;
+const int INFINITE_SCORE = 32000;
+
+// struct holding one of the best lines found by a search.
+struct SearchLine {
+  int score = 0;
+  int depth = 0;
+  std::vector<Move> pv;
+};
+
+// struct holding the outcome of a search.
+struct SearchResult {
+  Move bestMove = NO_MOVE;
+  int score = 0;
+  int depth = 0;
+  std::vector<Move> pv;
+  // best lines of the last completed iteration, best first, as many as
+  // the limits asked for and the position allows.
+  std::vector<SearchLine> lines;
+};
+
+/* function that writes a score as "cp <centipawns>" or, for a mate,
+   "mate <moves>" with a negative count when being mated.
+   @param score is the score from the point of view of the player to move. */
+std::string scoreText(int score);
+
+// struct holding a snapshot of the counters of a running or finished search.
+struct SearchStatistics {
+  uint64_t nodes = 0;
+  uint64_t nps = 0;
+  int depth = 0;
+  int selDepth = 0;
+  int elapsed = 0;
+  uint64_t ttProbes = 0;
+  uint64_t ttHits = 0;
+  uint64_t betaCutoffs = 0;
+  uint64_t firstMoveCutoffs = 0;
+  uint64_t pawnProbes = 0;
+  uint64_t pawnHits = 0;
+  uint64_t evalProbes = 0;
+  uint64_t evalHits = 0;
+  Move bestMove = NO_MOVE;
+  int score = 0;
+  bool searching = false;
+
+  /* function that returns the share of table probes that found an entry. */
+  double ttHitRate() const;
+
+  /* function that returns the share of cutoffs caused by the first move. */
+  double firstMoveCutoffRate() const;
+
+  /* function that returns the share of pawn table probes that hit. */
+  double pawnHitRate() const;
+
+  /* function that returns the share of evaluation cache probes that hit. */
+  double evalHitRate() const;
+};
+
+class Search {
+
+public:
+
+  /* constructor for the search.
+     @param hashMegabytes is the size of the transposition table. */
+  Search(int hashMegabytes = 16);
+
+  /* constructor for a search that uses a table shared with other searches,
+     which must outlive it.
+     @param sharedTable is the transposition table to use. */
+  Search(TranspositionTable& sharedTable);
+
+  /* destructor for the search, stops a search still running. */
+  ~Search();
+
+  /* function that starts searching a position on a background thread.
+     the board must not be used by anyone else until wait returns.
+     @param board is the chess board holding the position to search.
+     @param limits holds the clock and fixed limits of the search. */
+  void start(ChessBoard& board, const SearchLimits& limits);
+
+  /* function that asks a running search to stop as soon as possible. */
+  void stop();
+
+  /* function that tells a pondering search that the expected reply was
+     played, so it carries on with its tree and table under its limits,
+     counting the time already spent pondering. */
+  void ponderHit();
+
+  /* function that waits for the running search to finish
+     and returns its result. */
+  SearchResult wait();
+
+  /* function that searches a position and returns once it is done.
+     @param board is the chess board holding the position to search.
+     @param limits holds the clock and fixed limits of the search. */
+  SearchResult think(ChessBoard& board, const SearchLimits& limits);
+
+  /* function that returns the live counters of the search,
+     safe to call from any thread while the search runs. */
+  SearchStatistics statistics() const;
+
+  /* function that empties the transposition table. */
+  void clearHash();
+
+  /* function that reallocates the transposition table, emptying it.
+     @param megabytes is the amount of memory the table may use. */
+  void resizeHash(int megabytes);
+
+  /* function that reallocates the evaluation cache, emptying it. it must
+     not be called while a search runs.
+     @param entries is the number of positions kept, zero to evaluate
+     every position afresh. */
+  void resizeEvalCache(int entries);
+
+  /* function that records the nodes of the searches that follow into a
+     trace file, in builds made with INSTRUMENT=1. it must not be called
+     while a search runs.
+     @param file is the file to record into, which must outlive the
+     recording, or nullptr to stop recording. */
+  void setTrace(TraceFile* file);
+
+  /* function that sets what is called on the search thread after every
+     completed iteration, with the result so far. it must not be changed
+     while a search runs.
+     @param callback is the function to call, empty for none. */
+  void setIterationCallback(std::function<void(const SearchResult&)> callback);
+
+private:
+
+  /* function run on the search thread, deepening one ply at a time
+     until the limits or the time manager stop it. */
+  void iterativeDeepening();
+
+  /* function that scores a position with a principal variation search.
+     @param depth is the remaining depth to search.
+     @param ply is the distance from the root.
+     @param alpha and beta are the window of scores of interest. */
+  int alphaBeta(int depth, int ply, int alpha, int beta);
+
+  /* function that searches captures only until the position is quiet.
+     @param ply is the distance from the root.
+     @param alpha and beta are the window of scores of interest. */
+  int quiescence(int ply, int alpha, int beta);
+
+  /* function that sorts moves so that the most promising are searched first.
+     @param moves is the list of moves to sort.
+     @param hashMove is the best move stored in the table for the position.
+     @param ply is the distance from the root. */
+  void orderMoves(MoveList& moves, Move hashMove, int ply) const;
+
+  /* function that gives a move its ordering score.
+     @param move is the move to score.
+     @param hashMove is the best move stored in the table for the position.
+     @param ply is the distance from the root. */
+  int moveOrderScore(Move move, Move hashMove, int ply) const;
+
+  /* function called every few thousand nodes that checks the limits
+     and publishes the counters. */
+  void checkLimits();
+
+  /* function that copies the counters of the search thread
+     to where statistics can read them. */
+  void publish();
+
+  /* function that starts the trace record of the node at a ply.
+     @param depth is the depth left, zero in quiescence.
+     @param alpha and beta are the window the node is searched with.
+     @param flags are the TRACE_ flags known on entering the node. */
+  void traceEnter(int ply, int depth, int alpha, int beta, uint8_t flags);
+
+  /* function that completes the trace record of a node just left and
+     adds it to the buffer, unless the search was stopped.
+     @param ply is the ply of the node.
+     @param move is the move that led to it.
+     @param score is the score it returned, from its own point of view. */
+  void traceLeave(int ply, Move move, int score);
+
+  ChessBoard* board = nullptr;
+  SearchLimits limits;
+  TimeManager timeManager;
+  // table used by the search, owned unless it is shared.
+  std::unique_ptr<TranspositionTable> ownTable;
+  TranspositionTable* table;
+  // scores of positions evaluated by the search thread, kept between
+  // searches like the table.
+  EvalCache evalCache;
+  // pawn structure terms of those evaluations, kept between searches too.
+  PawnTable pawnTable;
+
+  std::function<void(const SearchResult&)> iterationCallback;
+
+  // root moves already given a line in the current iteration.
+  Move excludedRootMoves[MAX_MOVES];
+  int excludedCount = 0;
+
+  std::thread worker;
+  std::atomic<bool> stopSignal{false};
+  std::atomic<bool> ponderHitSignal{false};
+
+  // whether the search is pondering, owned by the search thread.
+  bool pondering = false;
+  SearchResult result;
+
+  // counters owned by the search thread.
+  uint64_t nodes = 0;
+  uint64_t ttProbes = 0;
+  uint64_t ttHits = 0;
+  uint64_t betaCutoffs = 0;
+  uint64_t firstMoveCutoffs = 0;
+  int selDepth = 0;
+  int completedDepth = 0;
+
+  // copy of the counters read by statistics.
+  mutable std::mutex statisticsLock;
+  SearchStatistics published;
+
+  // principal variation collected during the search.
+  Move pvTable[MAX_PLY][MAX_PLY];
+  int pvLength[MAX_PLY];
+
+  // quiet moves that caused a cutoff at each ply.
+  Move killers[MAX_PLY][2];
+
+  // buffer of the trace being recorded, none when not tracing, and the
+  // records of the nodes on the current line.
+  std::unique_ptr<TraceBuffer> trace;
+  TraceRecord traceNodes[MAX_PLY];
+};
+
+#endif
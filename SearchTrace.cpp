@@ -0,0 +1,53 @@
+#include "SearchTrace.h"
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+bool TraceFile::open(const string& file) {
+
+  // the header is appended first, before any buffer can be.
+  char header[TRACE_HEADER_BYTES];
+  uint64_t recordBytes = sizeof(TraceRecord);
+  memcpy(header, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  memcpy(header + sizeof(TRACE_MAGIC), &recordBytes, sizeof(recordBytes));
+  return out.open(file) && out.append(header, sizeof(header));
+}
+
+
+TraceBuffer::TraceBuffer(TraceFile& file, size_t capacity)
+  : file(file), records(capacity > 0 ? capacity : 1),
+    thread(file.nextThread()) {
+}
+
+TraceBuffer::~TraceBuffer() {
+  flush();
+}
+
+bool TraceBuffer::flush() {
+  if (count > 0 && !file.write(records.data(), count))
+    failed = true;
+  count = 0;
+  return !failed;
+}
+
+
+bool readTrace(const string& file, vector<TraceRecord>& records) {
+
+  ifstream in(file, ios::binary);
+  char header[TRACE_HEADER_BYTES];
+  if (!in.read(header, sizeof(header))
+      || memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+    return false;
+  uint64_t recordBytes;
+  memcpy(&recordBytes, header + sizeof(TRACE_MAGIC), sizeof(recordBytes));
+  if (recordBytes != sizeof(TraceRecord))
+    return false;
+
+  // a trace cut short by a crash keeps every whole record.
+  records.clear();
+  TraceRecord record;
+  while (in.read((char*)&record, sizeof(record)))
+    records.push_back(record);
+  return true;
+}
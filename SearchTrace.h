@@ -0,0 +1,141 @@
+#ifndef SEARCHTRACE_H
+#define SEARCHTRACE_H
+#include "AppendFile.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* recorder of the tree a search walks, for finding out offline why a
+   search got slower or weaker: which subtrees grew, where cutoffs came
+   late and where the depth was changed. every node is written as a
+   record of fixed size when the search leaves it, children before their
+   parent, into a buffer of the search thread that goes to a shared file
+   each time it fills.
+
+   nodes are recorded only in builds with CHESS_INSTRUMENT defined (make
+   INSTRUMENT=1) and only by searches given a trace file. otherwise the
+   hooks in the search expand to nothing, and in an instrumented build a
+   search without a file pays one untaken branch a hook.
+
+   a trace file is TRACE_MAGIC, the size of a record as a 64-bit number,
+   then the records of every thread in the order their buffers filled. */
+
+// kind of a node, from its score against the window it was given.
+enum TraceNodeType : uint8_t {TRACE_PV, TRACE_CUT, TRACE_ALL};
+
+// flags of a node.
+const uint8_t TRACE_QUIESCENCE = 1;
+const uint8_t TRACE_TT_HIT = 2;
+const uint8_t TRACE_TT_CUTOFF = 4;
+const uint8_t TRACE_IN_CHECK = 8;
+
+// bytes at the start of a trace file, before the size of a record.
+const char TRACE_MAGIC[8] = {'C', 'H', 'T', 'R', 'A', 'C', 'E', '1'};
+const size_t TRACE_HEADER_BYTES = 16;
+
+// struct holding one node of a traced search.
+struct TraceRecord {
+  // move leading to the node as Move::raw gives it, zero for the root.
+  uint16_t move;
+  // window the node was searched with and the score it returned, all
+  // from the point of view of the player to move there.
+  int16_t alpha;
+  int16_t beta;
+  int16_t score;
+  uint8_t ply;
+  // depth left when the node was entered, zero in quiescence.
+  int8_t depth;
+  // plies taken off the depth, negative for an extension.
+  int8_t reduction;
+  uint8_t type;
+  uint8_t flags;
+  // moves there were to search at the node and how many were searched.
+  uint8_t moveCount;
+  uint8_t searched;
+  // buffer that recorded the node, one per traced search.
+  uint8_t thread;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "trace records are 16 bytes");
+
+/* file of trace records shared by the buffers of many searches, each
+   full buffer appended without waiting for the others. */
+class TraceFile {
+
+public:
+
+  /* function that creates the file and writes its header, replacing any
+     file of that name.
+     @param file is the name of the file. */
+  bool open(const std::string& file);
+
+  /* function that writes records at the end of the file, safe to call
+     from any thread.
+     @param records are the records to write.
+     @param count is the number of records. */
+  bool write(const TraceRecord* records, size_t count) {
+    return out.append(records, count * sizeof(TraceRecord));
+  }
+
+  /* function that hands out the number of a new buffer. */
+  uint8_t nextThread() { return (uint8_t)threads++; }
+
+  /* getter function for the number of records written or being written. */
+  uint64_t size() const {
+    uint64_t bytes = out.size();
+    return bytes > TRACE_HEADER_BYTES
+      ? (bytes - TRACE_HEADER_BYTES) / sizeof(TraceRecord) : 0;
+  }
+
+private:
+
+  AppendFile out;
+  std::atomic<int> threads{0};
+};
+
+/* buffer of the records of one search thread, written to the file each
+   time it fills and started over, and when destroyed. */
+class TraceBuffer {
+
+public:
+
+  /* constructor for the buffer.
+     @param file is the file the records go to.
+     @param capacity is the number of records held before writing. */
+  TraceBuffer(TraceFile& file, size_t capacity = 4096);
+
+  /* destructor for the buffer, writing what is left. */
+  ~TraceBuffer();
+
+  /* function that adds a record, writing the buffer when it fills. */
+  void add(TraceRecord& record) {
+    record.thread = thread;
+    records[count++] = record;
+    if (count == records.size())
+      flush();
+  }
+
+  /* function that writes the records held so far. */
+  bool flush();
+
+  /* function that returns false if a write to the file failed. */
+  bool good() const { return !failed; }
+
+private:
+
+  TraceFile& file;
+  std::vector<TraceRecord> records;
+  size_t count = 0;
+  uint8_t thread;
+  bool failed = false;
+};
+
+/* function that reads every record of a trace file.
+   @param file is the name of the file.
+   @param records is filled with the records.
+   returns false if the file cannot be read or is not a trace. */
+bool readTrace(const std::string& file, std::vector<TraceRecord>& records);
+
+#endif
@@ -0,0 +1,115 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+
+void TimeManager::start(const SearchLimits& limits, Colour colour,
+			int legalMoveCount) {
+
+  startTime = steady_clock::now();
+  forced = legalMoveCount == 1;
+  lastBestMove = NO_MOVE;
+  lastScore = 0;
+  iterations = 0;
+  stableIterations = 0;
+  instability = 0;
+  scale = 1.0;
+  limited = false;
+  soft = 0;
+  hard = 0;
+
+  if (limits.infinite)
+    return;
+
+  // fixed time per move is used for both limits.
+  if (limits.moveTime > 0) {
+    limited = true;
+    soft = hard = std::max(1, limits.moveTime - MOVE_OVERHEAD);
+    return;
+  }
+
+  int remaining = limits.time[colour];
+  if (remaining <= 0)
+    return;
+  limited = true;
+
+  // spread the remaining time over the moves left, assuming a
+  // sudden death game lasts for another thirty moves.
+  int increment = limits.increment[colour];
+  int movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, 50) : 30;
+  int available = std::max(1, remaining - MOVE_OVERHEAD);
+
+  soft = available / movesToGo + increment * 3 / 4;
+
+  // never plan to use more than the clock allows with a safety margin,
+  // the hard limit lets a troubled search run to several times the soft.
+  int maximum = movesToGo == 1 ? available * 9 / 10 : available * 3 / 5;
+  hard = std::min(soft * 5, maximum);
+  soft = std::min(soft, hard);
+  soft = std::max(soft, 1);
+  hard = std::max(hard, 1);
+}
+
+
+int TimeManager::elapsed() const {
+  return (int)duration_cast<milliseconds>(steady_clock::now()
+					  - startTime).count();
+}
+
+
+void TimeManager::iterationFinished(Move bestMove, int score) {
+
+  iterations++;
+
+  // a changing best move raises instability, which decays once it settles.
+  instability *= 0.5;
+  if (iterations > 1 && !(bestMove == lastBestMove)) {
+    instability += 1.0;
+    stableIterations = 0;
+  }
+  else
+    stableIterations++;
+
+  double instabilityScale = 1.0 + 0.6 * instability;
+
+  // a dropping score asks for more time, up to double for large drops.
+  double dropScale = 1.0;
+  if (iterations > 1 && score < lastScore - 20)
+    dropScale = 1.0 + std::min(lastScore - score, 150) / 150.0;
+
+  // a best move that survived many iterations is considered obvious.
+  double stableScale = stableIterations >= 6 ? 0.5 : 1.0;
+
+  scale = instabilityScale * dropScale * stableScale;
+  lastBestMove = bestMove;
+  lastScore = score;
+}
+
+
+bool TimeManager::stopAfterIteration() const {
+
+  if (!limited)
+    return false;
+
+  // with only one move there is nothing to decide.
+  if (forced && iterations >= 1)
+    return true;
+
+  return elapsed() >= std::min((int)(soft * scale), hard);
+}
+
+
+bool TimeManager::hardLimitReached() const {
+  return limited && elapsed() >= hard;
+}
+
+
+int TimeManager::softLimit() const {
+  return soft;
+}
+
+
+int TimeManager::hardLimit() const {
+  return hard;
+}
@@ -0,0 +1,86 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+#include "ChessBoard.h"
+#include <chrono>
+#include <cstdint>
+
+// struct holding the limits a search is given. zero means no limit.
+struct SearchLimits {
+  int depth = 0;
+  uint64_t nodes = 0;
+  // fixed time for this move in milliseconds.
+  int moveTime = 0;
+  // remaining clock time and increment of each colour in milliseconds.
+  int time[2] = {0, 0};
+  int increment[2] = {0, 0};
+  // moves until the next time control, zero for sudden death.
+  int movesToGo = 0;
+  bool infinite = false;
+  // number of best lines to find, each with its own score and variation.
+  int multiPv = 1;
+  // search the position after the expected reply without limits until the
+  // reply is played, then carry on under the limits, which count the time
+  // spent pondering, so a long wait for the reply gives a quick answer.
+  bool ponder = false;
+};
+
+class TimeManager {
+
+public:
+
+  /* function that starts the clock for a search and derives the soft and
+     hard limits from the clock of the player to move.
+     @param limits holds the clock and fixed limits of the search.
+     @param colour is the colour of the player who is searching.
+     @param legalMoveCount is the number of moves the player can make. */
+  void start(const SearchLimits& limits, Colour colour, int legalMoveCount);
+
+  /* function that returns milliseconds passed since the search started. */
+  int elapsed() const;
+
+  /* function that updates the time allowed for the search after each
+     completed iteration, extending when the best move keeps changing or
+     the score drops and shrinking when the best move is settled.
+     @param bestMove is the best move of the completed iteration.
+     @param score is the score of the completed iteration. */
+  void iterationFinished(Move bestMove, int score);
+
+  /* function that determines whether a new iteration should not be started. */
+  bool stopAfterIteration() const;
+
+  /* function that determines whether the search must stop immediately. */
+  bool hardLimitReached() const;
+
+  /* getter functions for the limits in milliseconds, zero if unlimited. */
+  int softLimit() const;
+  int hardLimit() const;
+
+private:
+
+  // milliseconds kept in hand for communication and process overhead.
+  static const int MOVE_OVERHEAD = 10;
+
+  std::chrono::steady_clock::time_point startTime;
+
+  // whether the search is limited by time at all.
+  bool limited = false;
+
+  // whether there is only one move to make.
+  bool forced = false;
+
+  // time after which no new iteration starts, before adjustment.
+  int soft = 0;
+
+  // time after which the search is aborted.
+  int hard = 0;
+
+  // details of previous iterations used to scale the soft limit.
+  Move lastBestMove = NO_MOVE;
+  int lastScore = 0;
+  int iterations = 0;
+  int stableIterations = 0;
+  double instability = 0;
+  double scale = 1.0;
+};
+
+#endif
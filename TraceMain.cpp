@@ -0,0 +1,202 @@
+#include "SearchTrace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* summarises a search trace recorded by a build made with INSTRUMENT=1,
+   such as "epd FILE --trace TRACE": how the nodes spread over the plies
+   and the depths left, how many children interior nodes searched, how
+   often a cutoff came from the first move, and by how much each
+   iteration outgrew the one before.
+
+   usage: tracestat TRACE */
+
+namespace {
+
+// struct holding the counts of a group of nodes.
+struct NodeCounts {
+  uint64_t nodes = 0;
+  uint64_t quiescence = 0;
+  uint64_t types[3] = {0, 0, 0};
+  uint64_t tableHits = 0;
+  // nodes that searched at least one move, the children they searched
+  // and the moves they had.
+  uint64_t interior = 0;
+  uint64_t children = 0;
+  uint64_t moves = 0;
+  // cutoffs by a searched move, and those by the first.
+  uint64_t cutoffs = 0;
+  uint64_t firstCutoffs = 0;
+
+  void add(const TraceRecord& record) {
+    nodes++;
+    quiescence += (record.flags & TRACE_QUIESCENCE) != 0;
+    types[record.type]++;
+    tableHits += (record.flags & TRACE_TT_HIT) != 0;
+    if (record.searched > 0) {
+      interior++;
+      children += record.searched;
+      moves += record.moveCount;
+      if (record.type == TRACE_CUT) {
+	cutoffs++;
+	firstCutoffs += record.searched == 1;
+      }
+    }
+  }
+};
+
+/* function that returns a share as a percentage, zero of nothing. */
+double percent(uint64_t part, uint64_t whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+/* function that returns a mean, zero of nothing. */
+double mean(uint64_t total, uint64_t count) {
+  return count ? (double)total / count : 0.0;
+}
+
+/* function that writes the heading of a table of node counts.
+   @param first is the heading of the column of labels. */
+void printHeading(const string& first) {
+  cout << setw(6) << first << setw(12) << "nodes" << setw(8) << "share"
+       << setw(8) << "qsearch" << setw(7) << "pv" << setw(7) << "cut"
+       << setw(7) << "all" << setw(8) << "tt hit" << setw(9) << "children"
+       << setw(7) << "moves" << setw(10) << "first cut" << endl;
+}
+
+/* function that writes a row of a table of node counts.
+   @param total is the number of nodes the share of the row is of. */
+void printRow(int label, const NodeCounts& counts, uint64_t total) {
+  cout << setw(6) << label << setw(12) << counts.nodes << setw(7)
+       << percent(counts.nodes, total) << "%" << setw(7)
+       << percent(counts.quiescence, counts.nodes) << "%";
+  for (int type = TRACE_PV; type <= TRACE_ALL; type++)
+    cout << setw(6) << percent(counts.types[type], counts.nodes) << "%";
+  cout << setw(7) << percent(counts.tableHits, counts.nodes) << "%"
+       << setw(9) << mean(counts.children, counts.interior) << setw(7)
+       << mean(counts.moves, counts.interior) << setw(9)
+       << percent(counts.firstCutoffs, counts.cutoffs) << "%" << endl;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+
+  if (argc != 2) {
+    cerr << "usage: tracestat TRACE" << endl;
+    return 1;
+  }
+  vector<TraceRecord> records;
+  if (!readTrace(argv[1], records)) {
+    cerr << "tracestat: cannot read a trace from " << argv[1] << endl;
+    return 1;
+  }
+
+  NodeCounts search, quiescence;
+  vector<NodeCounts> byPly, byDepth;
+  uint64_t tableCutoffs = 0, extensions = 0;
+  int threads = 0;
+
+  // a root record closes an iteration of its thread, so the nodes of the
+  // thread since its last root record are the nodes of that iteration.
+  vector<uint64_t> sinceRoot(256, 0);
+  vector<int> lastDepth(256, 0);
+  vector<uint64_t> iterationNodes, iterationSearches;
+  vector<double> growth;
+  vector<uint64_t> growthCount;
+  vector<uint64_t> lastIteration(256, 0);
+
+  for (const TraceRecord& record : records) {
+    bool inQuiescence = record.flags & TRACE_QUIESCENCE;
+    (inQuiescence ? quiescence : search).add(record);
+    if (record.ply >= byPly.size())
+      byPly.resize(record.ply + 1);
+    byPly[record.ply].add(record);
+    if (!inQuiescence) {
+      if ((size_t)record.depth >= byDepth.size())
+	byDepth.resize(record.depth + 1);
+      byDepth[record.depth].add(record);
+    }
+    tableCutoffs += (record.flags & TRACE_TT_CUTOFF) != 0;
+    extensions += record.reduction < 0;
+    threads = max(threads, record.thread + 1);
+
+    sinceRoot[record.thread]++;
+    if (record.ply != 0)
+      continue;
+    int depth = record.depth;
+    if ((size_t)depth >= iterationNodes.size()) {
+      iterationNodes.resize(depth + 1, 0);
+      iterationSearches.resize(depth + 1, 0);
+      growth.resize(depth + 1, 0.0);
+      growthCount.resize(depth + 1, 0);
+    }
+    iterationNodes[depth] += sinceRoot[record.thread];
+    iterationSearches[depth]++;
+    // an iteration one deeper than the last of its thread belongs to the
+    // same search, so its growth over it is the effective branching factor.
+    if (depth == lastDepth[record.thread] + 1
+	&& lastIteration[record.thread] > 0) {
+      growth[depth] += log((double)sinceRoot[record.thread]
+			   / lastIteration[record.thread]);
+      growthCount[depth]++;
+    }
+    lastDepth[record.thread] = depth;
+    lastIteration[record.thread] = sinceRoot[record.thread];
+    sinceRoot[record.thread] = 0;
+  }
+
+  uint64_t total = records.size();
+  cout << "records " << total << " from " << threads << " threads, "
+       << search.nodes << " in the main search, " << quiescence.nodes
+       << " in quiescence" << endl;
+  cout << fixed << setprecision(1);
+  cout << "first-move cutoffs "
+       << percent(search.firstCutoffs, search.cutoffs) << "% of "
+       << search.cutoffs << " in the main search, "
+       << percent(quiescence.firstCutoffs, quiescence.cutoffs) << "% of "
+       << quiescence.cutoffs << " in quiescence" << endl;
+  cout << "table cutoffs " << tableCutoffs << ", check extensions "
+       << extensions << endl;
+  cout << setprecision(2) << "children searched per interior node "
+       << mean(search.children, search.interior) << " of "
+       << mean(search.moves, search.interior) << " in the main search, "
+       << mean(quiescence.children, quiescence.interior) << " of "
+       << mean(quiescence.moves, quiescence.interior) << " in quiescence"
+       << endl;
+
+  cout << endl << "iterations (effective branching factor is the mean"
+       << " growth over the iteration before)" << endl;
+  cout << setw(6) << "depth" << setw(10) << "searches" << setw(14)
+       << "mean nodes" << setw(8) << "ebf" << endl;
+  for (size_t depth = 1; depth < iterationNodes.size(); depth++) {
+    if (iterationSearches[depth] == 0)
+      continue;
+    cout << setw(6) << depth << setw(10) << iterationSearches[depth]
+	 << setw(14) << iterationNodes[depth] / iterationSearches[depth];
+    if (growthCount[depth] > 0)
+      cout << setw(8) << exp(growth[depth] / growthCount[depth]);
+    cout << endl;
+  }
+
+  cout << setprecision(1) << endl << "nodes by ply" << endl;
+  printHeading("ply");
+  for (size_t ply = 0; ply < byPly.size(); ply++)
+    if (byPly[ply].nodes > 0)
+      printRow((int)ply, byPly[ply], total);
+
+  cout << endl << "main search nodes by depth left" << endl;
+  printHeading("depth");
+  for (size_t depth = 0; depth < byDepth.size(); depth++)
+    if (byDepth[depth].nodes > 0)
+      printRow((int)depth, byDepth[depth], search.nodes);
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include "TrainingData.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+void packPosition(const ChessBoard& board, int score, int ply,
+		  PackedPosition& position) {
+
+  memset(&position, 0, sizeof(position));
+  int count = 0;
+  for (int square = 0; square < 64; square++) {
+    const Piece* piece = board.pieceAt(square % 8, square / 8);
+    if (piece == nullptr)
+      continue;
+    position.occupancy |= (uint64_t)1 << square;
+    int code = piece->getPieceColour() * 6 + piece->getPieceType();
+    position.pieces[count / 2] |= code << (count % 2) * 4;
+    count++;
+  }
+
+  position.score = (int16_t)score;
+  position.sideAndCastling = (uint8_t)(board.sideToMove()
+				       | board.castlingRights() << 1);
+  position.result = DRAWN;
+  position.halfmoves = (uint8_t)min(board.halfmoveClock(), 255);
+  position.ply = (uint16_t)min(ply, 65535);
+}
+
+string packedPositionFen(const PackedPosition& position) {
+
+  const string letters = "PRNBQKprnbqk";
+  char squares[64];
+  int count = 0;
+  for (int square = 0; square < 64; square++) {
+    squares[square] = 0;
+    if (position.occupancy >> square & 1) {
+      int code = position.pieces[count / 2] >> (count % 2) * 4 & 15;
+      squares[square] = code < 12 ? letters[code] : '?';
+      count++;
+    }
+  }
+
+  string fen;
+  for (int row = 7; row >= 0; row--) {
+    int empty = 0;
+    for (int column = 0; column < 8; column++) {
+      char piece = squares[row * 8 + column];
+      if (piece == 0) {
+	empty++;
+	continue;
+      }
+      if (empty > 0)
+	fen += char('0' + empty);
+      empty = 0;
+      fen += piece;
+    }
+    if (empty > 0)
+      fen += char('0' + empty);
+    if (row > 0)
+      fen += '/';
+  }
+
+  fen += position.sideAndCastling & 1 ? " b " : " w ";
+  string castling;
+  for (int castle = 0; castle < 4; castle++)
+    if (position.sideAndCastling >> 1 & 1 << castle)
+      castling += "KQkq"[castle];
+  fen += castling.empty() ? "-" : castling;
+  return fen + " - " + to_string(position.halfmoves) + " "
+    + to_string(position.ply / 2 + 1);
+}
+
+
+TrainingWriter::TrainingWriter(TrainingFile& file, size_t capacity)
+  : file(file) {
+  buffer.reserve(capacity);
+}
+
+TrainingWriter::~TrainingWriter() {
+  flush();
+}
+
+bool TrainingWriter::add(const PackedPosition& position) {
+  buffer.push_back(position);
+  return buffer.size() < buffer.capacity() || flush();
+}
+
+bool TrainingWriter::flush() {
+  bool written = buffer.empty() || file.write(buffer.data(), buffer.size());
+  buffer.clear();
+  return written;
+}
@@ -0,0 +1,95 @@
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+#include "AppendFile.h"
+#include "ChessBoard.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* struct holding a position labelled for training an evaluation, packed
+   into 32 bytes. files of training data are these structs back to back,
+   in the byte order of the machine that wrote them. */
+struct PackedPosition {
+  // bit row*8+column is set for each occupied square.
+  uint64_t occupancy;
+  // the piece on each occupied square in order of square, four bits
+  // each, low bits first: colour*6 + type.
+  uint8_t pieces[16];
+  // score of the search from the point of view of the player to move.
+  int16_t score;
+  // bit 0 is the player to move, bits 1-4 the castling rights.
+  uint8_t sideAndCastling;
+  // outcome of the game the position was played in.
+  uint8_t result;
+  uint8_t halfmoves;
+  uint8_t reserved;
+  // number of moves made in the game before the position.
+  uint16_t ply;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "packed positions take 32 bytes");
+
+/* function that packs the position on a board.
+   @param board is the chess board holding the position.
+   @param score is the score of the position for the player to move.
+   @param ply is the number of moves made in the game so far.
+   @param position is filled with the packed position, result left drawn. */
+void packPosition(const ChessBoard& board, int score, int ply,
+		  PackedPosition& position);
+
+/* function that returns a packed position in Forsyth-Edwards Notation. */
+std::string packedPositionFen(const PackedPosition& position);
+
+/* file of training data shared by many writers, each batch of positions
+   appended without waiting for the others. */
+class TrainingFile {
+
+public:
+
+  /* function that creates the file, replacing any file of that name.
+     @param file is the name of the file. */
+  bool open(const std::string& file) { return out.open(file); }
+
+  /* function that writes positions at the end of the file, safe to call
+     from any thread.
+     @param positions are the positions to write.
+     @param count is the number of positions. */
+  bool write(const PackedPosition* positions, size_t count) {
+    return out.append(positions, count * sizeof(PackedPosition));
+  }
+
+  /* getter function for the number of positions written or being written. */
+  uint64_t size() const { return out.size() / sizeof(PackedPosition); }
+
+private:
+
+  AppendFile out;
+};
+
+/* buffer of positions owned by one thread, written to a shared file
+   when full and when destroyed. */
+class TrainingWriter {
+
+public:
+
+  /* constructor for the writer.
+     @param file is the file the positions go to.
+     @param capacity is the number of positions held before writing. */
+  TrainingWriter(TrainingFile& file, size_t capacity = 1 << 15);
+
+  /* destructor for the writer, writing what is left. */
+  ~TrainingWriter();
+
+  /* function that adds a position, writing the buffer when it fills. */
+  bool add(const PackedPosition& position);
+
+  /* function that writes the positions held so far. */
+  bool flush();
+
+private:
+
+  TrainingFile& file;
+  std::vector<PackedPosition> buffer;
+};
+
+#endif
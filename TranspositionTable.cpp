@@ -0,0 +1,95 @@
+#include "TranspositionTable.h"
+
+using namespace std;
+
+namespace {
+
+// layout of the data word of an entry, the move fills the low 16 bits.
+const uint64_t MOVE_MASK = 0xFFFF;
+const int BOUND_SHIFT = 16;
+const uint64_t USED_BIT = 1ULL << 18;
+const int DEPTH_SHIFT = 24;
+const int SCORE_SHIFT = 32;
+
+}
+
+
+TranspositionTable::TranspositionTable(int megabytes) {
+  resize(megabytes);
+}
+
+
+void TranspositionTable::resize(int megabytes) {
+
+  // largest power of two number of entries that fits in the memory given.
+  uint64_t size = 1;
+  uint64_t bytes = (uint64_t)(megabytes > 0 ? megabytes : 1) << 20;
+  while (size * 2 * sizeof(PackedEntry) <= bytes)
+    size *= 2;
+
+  entries.reset(new PackedEntry[size]);
+  count = size;
+  mask = size - 1;
+  clear();
+}
+
+
+void TranspositionTable::clear() {
+  for (uint64_t i = 0; i < count; i++) {
+    entries[i].check.store(0, memory_order_relaxed);
+    entries[i].data.store(0, memory_order_relaxed);
+  }
+}
+
+
+bool TranspositionTable::probe(uint64_t key, TableEntry& entry) const {
+
+  const PackedEntry& stored = entries[key & mask];
+  uint64_t data = stored.data.load(memory_order_relaxed);
+  if (!(data & USED_BIT)
+      || (stored.check.load(memory_order_relaxed) ^ data) != key)
+    return false;
+
+  entry.key = key;
+  entry.move = Move((uint16_t)(data & MOVE_MASK));
+  entry.bound = (uint8_t)(data >> BOUND_SHIFT & 3);
+  entry.depth = (int8_t)(data >> DEPTH_SHIFT);
+  entry.score = (int16_t)(data >> SCORE_SHIFT);
+  return true;
+}
+
+
+void TranspositionTable::store(uint64_t key, int depth, int score,
+			       BoundType bound, Move move) {
+
+  PackedEntry& stored = entries[key & mask];
+  uint64_t old = stored.data.load(memory_order_relaxed);
+  bool samePosition = (old & USED_BIT)
+    && (stored.check.load(memory_order_relaxed) ^ old) == key;
+
+  // a deeper result for the same position is kept over a shallower one.
+  if (samePosition && (int8_t)(old >> DEPTH_SHIFT) > depth
+      && bound != EXACT_BOUND)
+    return;
+
+  // keep the old best move if the new search did not find one.
+  uint64_t packedMove = samePosition && move == NO_MOVE
+    ? old & MOVE_MASK : move.raw();
+
+  uint64_t data = packedMove | (uint64_t)bound << BOUND_SHIFT | USED_BIT
+    | (uint64_t)(uint8_t)depth << DEPTH_SHIFT
+    | (uint64_t)(uint16_t)score << SCORE_SHIFT;
+  stored.data.store(data, memory_order_relaxed);
+  stored.check.store(key ^ data, memory_order_relaxed);
+}
+
+
+int TranspositionTable::hashfull() const {
+
+  // sample the first thousand entries.
+  int used = 0;
+  for (uint64_t i = 0; i < 1000 && i < count; i++)
+    if (entries[i].data.load(memory_order_relaxed) & USED_BIT)
+      used++;
+  return used;
+}
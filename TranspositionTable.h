@@ -0,0 +1,71 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+#include "ChessBoard.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// enum storing how a stored score relates to the true score of a position.
+enum BoundType {EXACT_BOUND, LOWER_BOUND, UPPER_BOUND};
+
+// struct holding what the search learned about a position.
+struct TableEntry {
+  uint64_t key;
+  Move move;
+  int16_t score;
+  int8_t depth;
+  uint8_t bound;
+};
+
+/* table of what the search learned about positions. it may be shared by
+   searches on several threads: each entry is packed into one word stored
+   with its key xor'd in, so an entry torn by two threads writing at once
+   fails the key check instead of being read as another position's. */
+class TranspositionTable {
+
+public:
+
+  /* constructor for the table.
+     @param megabytes is the amount of memory the table may use. */
+  TranspositionTable(int megabytes);
+
+  /* function that reallocates the table, discarding what it holds.
+     @param megabytes is the amount of memory the table may use. */
+  void resize(int megabytes);
+
+  /* function that empties every entry of the table. */
+  void clear();
+
+  /* function that looks up a position in the table.
+     @param key is the hash key of the position.
+     @param entry is filled with the stored entry if one is found.
+     returns whether the position was found. */
+  bool probe(uint64_t key, TableEntry& entry) const;
+
+  /* function that stores what the search learned about a position.
+     @param key is the hash key of the position.
+     @param depth is the remaining depth the position was searched to.
+     @param score is the score found for the position.
+     @param bound is how the score relates to the true score.
+     @param move is the best move found, NO_MOVE if there was none. */
+  void store(uint64_t key, int depth, int score, BoundType bound, Move move);
+
+  /* function that returns how full the table is, in parts per thousand. */
+  int hashfull() const;
+
+private:
+
+  struct PackedEntry {
+    std::atomic<uint64_t> check;
+    std::atomic<uint64_t> data;
+  };
+
+  // entries of the table, count is always a power of two.
+  std::unique_ptr<PackedEntry[]> entries;
+  uint64_t count = 0;
+
+  // used to map a key onto an entry index.
+  uint64_t mask = 0;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "Uci.h"
+
+using namespace std;
+
+namespace {
+
+// most lines the engine will report at once.
+const int MAX_MULTI_PV = 64;
+
+string squareText(int column, int row) {
+  return string(1, (char)('a' + column)) + (char)('1' + row);
+}
+
+}
+
+
+string moveUci(Move move) {
+
+  if (move == NO_MOVE)
+    return "0000";
+
+  // castling is made by moving the rook onto the king, but written as the
+  // king moving two squares towards the rook.
+  if (move.flag() == CASTLING)
+    return squareText(move.targetColumn(), move.targetRow())
+      + squareText(move.originalColumn() == 7 ? 6 : 2, move.targetRow());
+
+  return squareText(move.originalColumn(), move.originalRow())
+    + squareText(move.targetColumn(), move.targetRow());
+}
+
+
+bool parseUciMove(ChessBoard& board, const string& text, Move& move) {
+  for (Move legal : board.legalMoves())
+    if (moveUci(legal) == text) {
+      move = legal;
+      return true;
+    }
+  return false;
+}
+
+
+UciEngine::UciEngine(ostream& out) : out(out), board(false) {
+  board.setPosition(START_POSITION);
+  search.setIterationCallback([this](const SearchResult& result) {
+      report(result);
+    });
+}
+
+
+UciEngine::~UciEngine() {
+  stopSearch();
+}
+
+
+void UciEngine::run(istream& in) {
+  string line;
+  while (getline(in, line))
+    if (!command(line))
+      break;
+  stopSearch();
+}
+
+
+bool UciEngine::command(const string& line) {
+
+  istringstream arguments(line);
+  string name;
+  if (!(arguments >> name))
+    return true;
+
+  if (name == "uci") {
+    send("id name Chess-Engine");
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name EvalCache type spin default 512 min 0 max 65536");
+    send("option name Ponder type check default false");
+    send("option name MultiPV type spin default 1 min 1 max "
+	 + to_string(MAX_MULTI_PV));
+    send("uciok");
+  }
+  else if (name == "isready")
+    send("readyok");
+  else if (name == "setoption")
+    setOption(arguments);
+  else if (name == "ucinewgame") {
+    stopSearch();
+    search.clearHash();
+  }
+  else if (name == "position")
+    position(arguments);
+  else if (name == "go")
+    go(arguments);
+  else if (name == "stop")
+    stopSearch();
+  else if (name == "ponderhit")
+    search.ponderHit();
+  else if (name == "quit")
+    return false;
+  else
+    send("info string unknown command " + name);
+  return true;
+}
+
+
+void UciEngine::setOption(istringstream& arguments) {
+
+  // setoption name <name> value <value>, names may hold spaces.
+  string word, option, value;
+  arguments >> word;
+  while (arguments >> word && word != "value")
+    option += (option.empty() ? "" : " ") + word;
+  arguments >> value;
+
+  if (option == "Hash") {
+    stopSearch();
+    search.resizeHash(max(1, atoi(value.c_str())));
+  }
+  else if (option == "EvalCache") {
+    // kilobytes of cached evaluations, none switching the cache off.
+    stopSearch();
+    int kilobytes = min(max(0, atoi(value.c_str())), 65536);
+    search.resizeEvalCache(kilobytes * 1024 / EVAL_ENTRY_BYTES);
+  }
+  else if (option == "Ponder")
+    return;
+  else if (option == "MultiPV")
+    multiPv = min(max(1, atoi(value.c_str())), MAX_MULTI_PV);
+  else
+    send("info string unknown option " + option);
+}
+
+
+void UciEngine::position(istringstream& arguments) {
+
+  stopSearch();
+
+  string word, fen;
+  arguments >> word;
+  if (word == "startpos")
+    fen = START_POSITION;
+  else if (word == "fen")
+    while (arguments >> word && word != "moves")
+      fen += (fen.empty() ? "" : " ") + word;
+
+  if (!board.setPosition(fen)) {
+    send("info string bad position " + fen);
+    board.setPosition(START_POSITION);
+    return;
+  }
+
+  // moves are made so that the board remembers them for repetitions.
+  if (word != "moves")
+    arguments >> word;
+  MoveRecord record;
+  while (arguments >> word) {
+    Move move;
+    if (!parseUciMove(board, word, move)) {
+      send("info string illegal move " + word);
+      return;
+    }
+    board.doMove(move, record);
+  }
+}
+
+
+void UciEngine::go(istringstream& arguments) {
+
+  stopSearch();
+
+  SearchLimits limits;
+  limits.multiPv = multiPv;
+  string word;
+  while (arguments >> word) {
+    if (word == "infinite")
+      limits.infinite = true;
+    else if (word == "ponder")
+      limits.ponder = true;
+    else if (word == "depth")
+      arguments >> limits.depth;
+    else if (word == "nodes")
+      arguments >> limits.nodes;
+    else if (word == "movetime")
+      arguments >> limits.moveTime;
+    else if (word == "wtime")
+      arguments >> limits.time[WHITE];
+    else if (word == "btime")
+      arguments >> limits.time[BLACK];
+    else if (word == "winc")
+      arguments >> limits.increment[WHITE];
+    else if (word == "binc")
+      arguments >> limits.increment[BLACK];
+    else if (word == "movestogo")
+      arguments >> limits.movesToGo;
+  }
+
+  search.start(board, limits);
+  reporter = thread([this]() {
+      SearchResult result = search.wait();
+      string line = "bestmove " + moveUci(result.bestMove);
+      if (result.pv.size() > 1)
+	line += " ponder " + moveUci(result.pv[1]);
+      send(line);
+    });
+}
+
+
+void UciEngine::stopSearch() {
+  search.stop();
+  if (reporter.joinable())
+    reporter.join();
+}
+
+
+void UciEngine::send(const string& line) {
+  lock_guard<mutex> lock(outputLock);
+  out << line << endl;
+}
+
+
+void UciEngine::report(const SearchResult& result) {
+
+  SearchStatistics statistics = search.statistics();
+  for (size_t i = 0; i < result.lines.size(); i++) {
+    const SearchLine& line = result.lines[i];
+    ostringstream info;
+    info << "info depth " << line.depth << " seldepth "
+	 << statistics.selDepth << " multipv " << i + 1 << " score "
+	 << scoreText(line.score) << " nodes " << statistics.nodes
+	 << " nps " << statistics.nps << " time " << statistics.elapsed
+	 << " pv";
+    for (Move move : line.pv)
+      info << " " << moveUci(move);
+    send(info.str());
+  }
+}
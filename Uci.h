@@ -0,0 +1,78 @@
+#ifndef UCI_H
+#define UCI_H
+#include "ChessBoard.h"
+#include "Search.h"
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/* function that writes a move in the coordinate notation of the universal
+   chess interface, e.g. e2e4, with castling written as the king's move.
+   @param move is the move to write. */
+std::string moveUci(Move move);
+
+/* function that finds the legal move written in universal chess interface
+   notation.
+   @param board is the chess board holding the position.
+   @param text is the move, e.g. e2e4 or e1g1.
+   @param move is filled with the move if it is legal. */
+bool parseUciMove(ChessBoard& board, const std::string& text, Move& move);
+
+/* engine speaking the universal chess interface. commands are read from a
+   stream and searches run in the background, so stop and isready are
+   answered while the engine thinks. supports the uci, isready, setoption
+   (Hash, Ponder, MultiPV), ucinewgame, position, go, stop, ponderhit and
+   quit commands. */
+class UciEngine {
+
+public:
+
+  /* constructor for the engine.
+     @param out is where responses are written. */
+  UciEngine(std::ostream& out);
+
+  /* destructor for the engine, stopping a search still running. */
+  ~UciEngine();
+
+  /* function that handles commands until quit or the end of the input.
+     @param in is where commands are read from. */
+  void run(std::istream& in);
+
+  /* function that handles one command, returning false on quit.
+     @param line is the command. */
+  bool command(const std::string& line);
+
+private:
+
+  /* functions that handle the arguments of their commands. */
+  void setOption(std::istringstream& arguments);
+  void position(std::istringstream& arguments);
+  void go(std::istringstream& arguments);
+
+  /* function that stops the search and waits for its best move
+     to be sent. */
+  void stopSearch();
+
+  /* function that writes a line of output.
+     @param line is the line to write. */
+  void send(const std::string& line);
+
+  /* function called after each iteration of the search, writing an info
+     line for each of the best lines.
+     @param result is the result of the iteration. */
+  void report(const SearchResult& result);
+
+  std::ostream& out;
+  std::mutex outputLock;
+
+  ChessBoard board;
+  Search search;
+  int multiPv = 1;
+
+  // thread waiting for the running search and sending its best move.
+  std::thread reporter;
+};
+
+#endif
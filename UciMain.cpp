@@ -0,0 +1,16 @@
+#include "Uci.h"
+
+#include <iostream>
+
+using namespace std;
+
+/* runs the engine under the universal chess interface on standard input
+   and output, for graphical interfaces and tournament managers.
+
+   usage: uci */
+
+int main() {
+  UciEngine engine(cout);
+  engine.run(cin);
+  return 0;
+}
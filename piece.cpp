@@ -1,4 +1,6 @@
 #include "piece.h"
+#include "Instrumentation.h"
+#include "LineTables.h"
 #include <iostream>
 
 Piece::Piece(Colour colour, ChessBoard* cboard) {
@@ -11,26 +13,32 @@ Piece::~Piece() {
 
 Knight::Knight(Colour colour, ChessBoard* cboard) : Piece(colour, cboard){
   setType("Knight");
+  pieceType = KNIGHT;
 }
 
 Bishop::Bishop(Colour colour, ChessBoard* cboard) : Piece(colour, cboard){
   setType("Bishop");
+  pieceType = BISHOP;
 }
 
 Rook::Rook(Colour colour, ChessBoard* cboard) : Piece(colour, cboard){
   setType("Rook");
+  pieceType = ROOK;
 }
 
 Queen::Queen(Colour colour, ChessBoard* cboard) : Piece(colour, cboard){
   setType("Queen");
+  pieceType = QUEEN;
 }
 
 King::King(Colour colour, ChessBoard* cboard) : Piece(colour, cboard) {
   setType("King");
+  pieceType = KING;
 }
 
 Pawn::Pawn(Colour colour, ChessBoard* cboard) : Piece(colour, cboard) {
   setType("Pawn");
+  pieceType = PAWN;
 }
 
 Colour Piece::getPieceColour() const{
@@ -41,11 +49,17 @@ string Piece::getType() const {
   return type;
 }
 
+PieceType Piece::getPieceType() const {
+  return pieceType;
+}
+
 void Piece::setType(string type_) {
   type = type_;
 }
 
 bool Pawn::isValid(Move move) {
+
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
   
   // calculates direction of pawn moves.
   VerticalDirection verticalDirection;
@@ -53,20 +67,19 @@ bool Pawn::isValid(Move move) {
     verticalDirection = DOWN;
   else
     verticalDirection = UP;
-  HorizontalDirection horizontalDirection = NOT_HORIZONTAL;
 
   // standard pawn move forward.
-  if (move.originalColumn == move.targetColumn
-      && move.targetRow == move.originalRow + verticalDirection
+  if (move.originalColumn() == move.targetColumn()
+      && move.targetRow() == move.originalRow() + verticalDirection
       && board_->emptyTarget(move)) {
       return true;
     }
  
   // pawn kill (diagonal move).
-   if ((move.originalColumn - verticalDirection == move.targetColumn
-	&& move.originalRow + verticalDirection == move.targetRow) 
-      || (move.originalColumn + verticalDirection == move.targetColumn
-	  && move.originalRow + verticalDirection == move.targetRow)) {
+   if ((move.originalColumn() - verticalDirection == move.targetColumn()
+	&& move.originalRow() + verticalDirection == move.targetRow()) 
+      || (move.originalColumn() + verticalDirection == move.targetColumn()
+	  && move.originalRow() + verticalDirection == move.targetRow())) {
      // if diagonal pawn target is empty, cannot do move.
      if (board_->emptyTarget(move))
        return false;
@@ -77,11 +90,11 @@ bool Pawn::isValid(Move move) {
   
 
    // case where pawn in starting position and path is empty.
-   if ((move.originalRow == 6 && getPieceColour() == BLACK)
-       || (move.originalRow == 1 && getPieceColour() == WHITE)) {
-    if (move.originalColumn == move.targetColumn
-	&& move.targetRow == move.originalRow + verticalDirection*2
-	&& board_->pathEmpty(move, verticalDirection, horizontalDirection)
+   if ((move.originalRow() == 6 && getPieceColour() == BLACK)
+       || (move.originalRow() == 1 && getPieceColour() == WHITE)) {
+    if (move.originalColumn() == move.targetColumn()
+	&& move.targetRow() == move.originalRow() + verticalDirection*2
+	&& board_->pathEmpty(move)
 	&& board_->emptyTarget(move))
       return true;
     else
@@ -93,12 +106,14 @@ bool Pawn::isValid(Move move) {
 
 bool King::isValid(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
+
   // king can move 1 unit around its column and row.
   VerticalDirection verticalDirection = calculateVertical(move);
   HorizontalDirection horizontalDirection = calculateHorizontal(move);
   
-  if (move.targetRow == move.originalRow + verticalDirection
-      && move.targetColumn == move.originalColumn + horizontalDirection)
+  if (move.targetRow() == move.originalRow() + verticalDirection
+      && move.targetColumn() == move.originalColumn() + horizontalDirection)
     return true;
   else
     return false;  
@@ -107,6 +122,8 @@ bool King::isValid(Move move) {
 
 bool Queen::isValid(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
+
   // checks if move is on the diagonal.
   if (diagonalMove(move))
     return true;
@@ -121,6 +138,8 @@ bool Queen::isValid(Move move) {
 
 bool Rook::isValid(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
+
   // checks if move is straight horizontally or vertically.
   if (horizontalVerticalMove(move))
     return true;
@@ -132,6 +151,8 @@ bool Rook::isValid(Move move) {
 
 bool Bishop::isValid(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
+
   // checks if move is on the diagonal.
   if (diagonalMove(move))
     return true;
@@ -141,17 +162,19 @@ bool Bishop::isValid(Move move) {
 
 bool Knight::isValid(Move move) {
 
+  INSTRUMENT_SCOPE(PROBE_IS_VALID);
+
   // knight moves in L shape. 1 and 2 are the respective possible columns/ rows.
-  if ((move.targetColumn == move.originalColumn + 1
-       || move.targetColumn == move.originalColumn -1)
-      && (move.targetRow == move.originalRow + 2
-	  || move.targetRow == move.originalRow -2))
+  if ((move.targetColumn() == move.originalColumn() + 1
+       || move.targetColumn() == move.originalColumn() -1)
+      && (move.targetRow() == move.originalRow() + 2
+	  || move.targetRow() == move.originalRow() -2))
     return true;
 
-  if ((move.targetColumn == move.originalColumn + 2
-       || move.targetColumn == move.originalColumn -2)
-      && (move.targetRow == move.originalRow + 1
-	  || move.targetRow == move.originalRow -1))
+  if ((move.targetColumn() == move.originalColumn() + 2
+       || move.targetColumn() == move.originalColumn() -2)
+      && (move.targetRow() == move.originalRow() + 1
+	  || move.targetRow() == move.originalRow() -1))
     return true;
 
   return false;
@@ -160,64 +183,26 @@ bool Knight::isValid(Move move) {
 bool Piece::horizontalVerticalMove(Move move) {
 
   // in the case that neither column or row are the same, move is diagonal.
-  if (move.originalColumn != move.targetColumn
-      && move.originalRow != move.targetRow)
+  if (move.originalColumn() != move.targetColumn()
+      && move.originalRow() != move.targetRow())
     return false;
 
-  VerticalDirection verticalDirection = calculateVertical(move);
-  HorizontalDirection horizontalDirection = calculateHorizontal(move);  
-
-   int column = move.originalColumn + horizontalDirection;
-   int row = move.originalRow + verticalDirection;
-
-   /* loop through board in appropirate horizontal or 
-      vertical direction to see if piece is on that path. */
-   // 8, -1 ensure loop doesn't go off the board.
-   while ((column < 8) && (column > -1) && (row < 8) && (row > -1)) {
-     if (column == move.targetColumn && row == move.targetRow) {
-
-       // if move is on this path, check if path there is empty.
-       if (board_->pathEmpty(move, verticalDirection, horizontalDirection))
-	 return true;
-       else
-	 return false;
-     }
-     column = column + horizontalDirection;
-     row = row + verticalDirection;
-   }
-   return false;
+  // the line table is empty when the piece does not move at all.
+  return LINES.line[move.originalSquare()][move.targetSquare()] != 0
+    && board_->pathEmpty(move);
 }
 
 
 bool Piece::diagonalMove(Move move) {
 
   // in the case that move is not on diagonal.
-  if (move.originalColumn == move.targetColumn
-      || move.originalRow == move.targetRow)
+  if (move.originalColumn() == move.targetColumn()
+      || move.originalRow() == move.targetRow())
     return false;
 
-  VerticalDirection verticalDirection = calculateVertical(move);
-  HorizontalDirection horizontalDirection = calculateHorizontal(move);
-  
-  int column = move.originalColumn + horizontalDirection;
-  int row = move.originalRow + verticalDirection;
-
-  /* loop through board in appropirate diagonal direction 
-     to see if piece is on that path. */
-  // 8, -1 ensure loop doesn't go off the board.
-  while ((column < 8) && (column > -1) && (row < 8) && (row > -1)){
-    if (row == move.targetRow && column  == move.targetColumn) {
-
-      // if move is on path, check if path there is empty.
-      if (board_->pathEmpty(move, verticalDirection, horizontalDirection))
-	return true;
-      else
-	return false;
-    }
-    column = column + horizontalDirection;
-    row = row + verticalDirection;
-  }
-  return false;
+  // positions sharing neither row nor column share a line only diagonally.
+  return LINES.line[move.originalSquare()][move.targetSquare()] != 0
+    && board_->pathEmpty(move);
 }
 
 
@@ -227,10 +212,10 @@ VerticalDirection Piece::calculateVertical(Move move) {
   VerticalDirection direction;
   /* if orginal row and orignal column are the same
      there is no direction of movements. */
-  if (move.originalRow == move.targetRow)
+  if (move.originalRow() == move.targetRow())
     direction = NOT_VERTICAL;
    
-  else if (move.originalRow > move.targetRow) 
+  else if (move.originalRow() > move.targetRow()) 
     direction = DOWN;
    
   else
@@ -247,10 +232,10 @@ HorizontalDirection Piece::calculateHorizontal(Move move) {
 
   /* if orginal row and orignal column are the same
      there is no direction of movements. */
-  if (move.targetColumn == move.originalColumn)
+  if (move.targetColumn() == move.originalColumn())
     horizontalDirection = NOT_HORIZONTAL;
   
-  else if (move.targetColumn > move.originalColumn)
+  else if (move.targetColumn() > move.originalColumn())
     horizontalDirection = RIGHT;
   
   else
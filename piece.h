@@ -35,6 +35,10 @@ public:
   /* getter function for the type of a piece */
   string getType() const;
 
+  /* getter function for the type of a piece as an enum, used where
+     comparing strings would be too slow (hashing, evaluation). */
+  PieceType getPieceType() const;
+
   /* setter used to set type of piece when piece is constructed.
      @ type_ is the name of type of piece. */
   void setType(string type_);
@@ -74,6 +78,9 @@ protected:
 
   /* name of type of piece */
   string type;
+
+  /* enum value of type of piece */
+  PieceType pieceType;
 };
 
 
@@ -1,5 +1,8 @@
 #ifndef SUPPLEMENTARY_H
 #define SUPPLEMENTARY_H
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
 
 // enum for possible colours of chess.
 enum Colour {WHITE, BLACK};
@@ -10,19 +13,96 @@ Colour operator!(Colour colour);
 // overloaded output operator for colour.
 std::ostream& operator << (std::ostream& out, Colour colour);
 
+// enum for the possible outcomes of a game.
+enum GameResult {WHITE_WINS, BLACK_WINS, DRAWN};
+
 // enum storing the possible directions a piece moves in vertically.
 enum VerticalDirection {DOWN = -1 ,NOT_VERTICAL = 0, UP = 1};
 
 // enum storing the possible directions a piece moves in horizontally.
 enum HorizontalDirection {LEFT = -1,  NOT_HORIZONTAL = 0, RIGHT = 1};
 
-// struct holding information about a potential move.
-struct Move {
-  int originalColumn;
-  int originalRow;
-  int targetColumn;
-  int targetRow;
+// enum for the types of chess piece, in the order the board stores piece objects.
+enum PieceType {PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING};
+
+// kinds of move stored in the flags of a move. the board plays neither
+// promotions nor en passant, so only castling is ever set.
+enum MoveFlag {NORMAL_MOVE = 0, PROMOTION = 1, EN_PASSANT = 2, CASTLING = 3};
+
+/* class holding a potential move packed into 16 bits: the original square
+   in bits 0-5 and the target square in bits 6-11, each numbered
+   row*8+column, the kind of move in bits 12-13 and the piece promoted to
+   in bits 14-15. */
+class Move {
+
+public:
+
+  // left uninitialised so move lists cost nothing to create.
+  Move() = default;
+
+  constexpr Move(int originalColumn, int originalRow, int targetColumn,
+		 int targetRow, MoveFlag flag = NORMAL_MOVE,
+		 int promotion = 0)
+    : data((uint16_t)(originalRow << 3 | originalColumn
+		      | (targetRow << 3 | targetColumn) << 6
+		      | flag << 12 | promotion << 14)) {}
+
+  /* constructor for a move from its packed form.
+     @param packed is the value returned by raw. */
+  constexpr explicit Move(uint16_t packed) : data(packed) {}
+
+  constexpr int originalColumn() const { return data & 7; }
+  constexpr int originalRow() const { return data >> 3 & 7; }
+  constexpr int targetColumn() const { return data >> 6 & 7; }
+  constexpr int targetRow() const { return data >> 9 & 7; }
+  constexpr int originalSquare() const { return data & 63; }
+  constexpr int targetSquare() const { return data >> 6 & 63; }
+  constexpr MoveFlag flag() const { return (MoveFlag)(data >> 12 & 3); }
+  constexpr int promotion() const { return data >> 14; }
+
+  /* function that returns the move packed into 16 bits. */
+  constexpr uint16_t raw() const { return data; }
+
+  constexpr bool operator==(Move other) const { return data == other.data; }
+
+private:
+
+  uint16_t data;
 };
 
+// a move from a position onto itself is never made, so it stands for no move.
+constexpr Move NO_MOVE = Move(0, 0, 0, 0);
+
+// most moves any position can have, with room to spare.
+const int MAX_MOVES = 256;
+
+// list of moves of fixed capacity, kept on the stack so it never allocates.
+class MoveList {
+
+public:
+
+  void push_back(Move move) { moves[count++] = move; }
+  void clear() { count = 0; }
+  void resize(size_t size) { count = size; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  Move& operator[](size_t index) { return moves[index]; }
+  Move operator[](size_t index) const { return moves[index]; }
+
+  Move* begin() { return moves; }
+  Move* end() { return moves + count; }
+  const Move* begin() const { return moves; }
+  const Move* end() const { return moves + count; }
+
+private:
+
+  Move moves[MAX_MOVES];
+  size_t count = 0;
+};
+
+// overloaded output operator for a move, written as the two positions, e.g. E2E4.
+std::ostream& operator << (std::ostream& out, Move move);
+
 
 #endif